@@ -19,6 +19,7 @@
 #endif
 #include <GLFW/glfw3.h> // Will drag system OpenGL headers
 
+#include <nese.debugger/cpu_profile_view.hpp>
 #include <nese.debugger/cpu_state_view.hpp>
 #include <nese.debugger/debug_control_view.hpp>
 #include <nese.debugger/disassembly_view.hpp>
@@ -86,6 +87,7 @@ void create_views(nese::gui::application& application)
 
     create_window(tag<debug_control_view>(), "Debug Control", "View/Debug/Control", window_view_flag::disable_resize | window_view_flag::auto_resize);
     create_window(tag<cpu_state_view>(), "CPU State", "View/Debug/CPU State", window_view_flag::disable_resize | window_view_flag::auto_resize);
+    create_window(tag<cpu_profile_view>(), "CPU Profile", "View/Debug/CPU Profile");
     create_window(tag<disassembly_view>(), "Program Code", "View/Debug/Program Code");
     create_window(tag<game_view>(), "Game", "View/Game");
 }
@@ -0,0 +1,141 @@
+#include <nese.debugger/cpu_profile_view.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include <magic_enum.hpp>
+
+#include <nese.gui/imgui.hpp>
+#include <nese.gui/view/view_draw_context.hpp>
+#include <nese/cpu/cpu_opcode.hpp>
+#include <nese/emulator.hpp>
+
+namespace nese::gui {
+
+namespace {
+
+struct profile_row
+{
+    string_view name;
+    string_view addr_mode;
+    cpu_profile::entry entry;
+};
+
+std::vector<profile_row> get_rows(const cpu_profile& profile, bool by_addr_mode)
+{
+    std::vector<profile_row> rows;
+
+    if (by_addr_mode)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(cpu_addr_mode::count); ++i)
+        {
+            const auto addr_mode = static_cast<cpu_addr_mode>(i);
+            rows.push_back({"", magic_enum::enum_name(addr_mode), profile.get_addr_mode(addr_mode)});
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < 256; ++i)
+        {
+            rows.push_back({cpu_opcode_mnemonics[i], magic_enum::enum_name(cpu_opcode_addr_modes[i]), profile.get_opcode(static_cast<byte_t>(i))});
+        }
+    }
+
+    std::erase_if(rows, [](const profile_row& row) { return row.entry.executions == 0; });
+    std::stable_sort(rows.begin(), rows.end(), [](const profile_row& lhs, const profile_row& rhs) { return lhs.entry.cycles > rhs.entry.cycles; });
+
+    return rows;
+}
+
+// Instantiated with the bus cpu, get_profile only exists when its policy profiles
+template<typename CpuT>
+void draw_profile(const CpuT& cpu, bool& by_addr_mode)
+{
+    if constexpr (!requires { cpu.get_profile(); })
+    {
+        imgui::text_disabled("Build with NESE_CPU_PROFILING_ENABLED=1 to profile the cpu");
+    }
+    else
+    {
+        const cpu_profile& profile = cpu.get_profile();
+        const cpu_profile::entry total = profile.get_total();
+
+        if (imgui::button("Export JSON"))
+        {
+            std::ofstream("cpu_profile.json") << profile.to_json();
+        }
+
+        imgui::same_line();
+        imgui::checkbox("By Addressing Mode", by_addr_mode);
+
+        imgui::text("Instructions: {} Cycles: {} Page Crossings: {}", total.executions, total.cycles, total.page_crossings);
+
+        imgui::separator();
+
+        if (!imgui::begin_table("profile", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY))
+        {
+            return;
+        }
+
+        imgui::table_setup_column("Opcode");
+        imgui::table_setup_column("Mode");
+        imgui::table_setup_column("Executions");
+        imgui::table_setup_column("Cycles");
+        imgui::table_setup_column("Cycles %");
+        imgui::table_setup_column("Page Crossings");
+        imgui::table_headers_row();
+
+        for (const profile_row& row : get_rows(profile, by_addr_mode))
+        {
+            imgui::table_next_row();
+
+            imgui::table_next_column();
+            imgui::text("{}", row.name);
+
+            imgui::table_next_column();
+            imgui::text("{}", row.addr_mode);
+
+            imgui::table_next_column();
+            imgui::text("{}", row.entry.executions);
+
+            imgui::table_next_column();
+            imgui::text("{}", row.entry.cycles);
+
+            imgui::table_next_column();
+            imgui::text("{:.2f}", 100.0 * static_cast<f64_t>(row.entry.cycles) / static_cast<f64_t>(total.cycles));
+
+            imgui::table_next_column();
+            imgui::text("{}", row.entry.page_crossings);
+        }
+
+        imgui::end_table();
+    }
+}
+
+// get_call_stack only exists when the policy tracks the call stack
+template<typename CpuT>
+void draw_call_stack_export(const CpuT& cpu)
+{
+    if constexpr (requires { cpu.get_call_stack(); })
+    {
+        if (imgui::button("Export Collapsed Stacks"))
+        {
+            std::ofstream("cpu_call_stack.folded") << cpu.get_call_stack().to_collapsed();
+        }
+
+        imgui::separator();
+    }
+}
+
+} // namespace
+
+void cpu_profile_view::draw(const view_draw_context& context)
+{
+    const auto& cpu = context.get_emulator().get_bus().cpu;
+
+    draw_call_stack_export(cpu);
+    draw_profile(cpu, _by_addr_mode);
+}
+
+} // namespace nese::gui
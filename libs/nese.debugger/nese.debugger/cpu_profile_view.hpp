@@ -0,0 +1,18 @@
+#pragma once
+
+namespace nese::gui {
+
+class view_draw_context;
+
+// Per opcode or addressing mode counters of the cpu, the bus cpu must be built with NESE_CPU_PROFILING_ENABLED
+// The collapsed stacks of the call stack can be exported when built with NESE_CPU_CALL_STACK_ENABLED
+class cpu_profile_view
+{
+public:
+    void draw(const view_draw_context& context);
+
+private:
+    bool _by_addr_mode{false};
+};
+
+} // namespace nese::gui
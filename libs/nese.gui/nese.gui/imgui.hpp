@@ -78,6 +78,36 @@ inline void separator()
     ImGui::Separator();
 }
 
+inline bool begin_table(const char* str_id, s32_t column_count, ImGuiTableFlags flags = 0)
+{
+    return ImGui::BeginTable(str_id, column_count, flags);
+}
+
+inline void end_table()
+{
+    ImGui::EndTable();
+}
+
+inline void table_setup_column(const char* label)
+{
+    ImGui::TableSetupColumn(label);
+}
+
+inline void table_headers_row()
+{
+    ImGui::TableHeadersRow();
+}
+
+inline void table_next_row()
+{
+    ImGui::TableNextRow();
+}
+
+inline bool table_next_column()
+{
+    return ImGui::TableNextColumn();
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wformat-security"
 
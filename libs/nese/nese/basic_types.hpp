@@ -1,13 +1,14 @@
 #pragma once
 
 #include <array>
-#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <string_view>
 
+#include <nese/master_clock.hpp>
+
 namespace nese {
 
 template<typename T, std::size_t SizeT>
@@ -47,24 +48,27 @@ constexpr T clamp(const T& v, const T& min, const T& max)
 }
 
 //
-// Given that 1 CPU cycle = 3 PPU cycle, we'll count in terms of PPU cycle
-// 1 nes_cycle_t = 1 PPU cycle = 1/3 CPU cycle
-// 3 nes_cycle_t = 3 PPU cycle = 1 CPU cycle
+// Every clock counts periods of the master clock, 1 CPU cycle = 12 ticks and 1 PPU cycle = 4 ticks on NTSC
+// Converting the CPU to the PPU or the master clock is a multiplication, PAL would be 16 and 5 ticks for its 3.2 ratio
 //
-using cycle_t = std::chrono::duration<s64_t, std::ratio<1, 1>>;
-using cpu_cycle_t = std::chrono::duration<s64_t, std::ratio<3, 1>>;
-using ppu_cycle_t = std::chrono::duration<s64_t, std::ratio<1, 1>>;
+using cycle_t = basic_cycle<1>;
+using cpu_cycle_t = basic_cycle<12>;
+using ppu_cycle_t = basic_cycle<4>;
 
 //
 // NES 6502 CPU 21.477272 / 12 MHz
 // NES PPU 21.477272 / 4 MHz
 //
-static inline constexpr cycle_t clock_hz{21477272ll / 4};
+static inline constexpr cycle_t clock_hz{21477272ll};
 static inline constexpr ppu_cycle_t ppu_scanline_cycle(341);
+static inline constexpr size_t ppu_scanline_count(262);
+static inline constexpr ppu_cycle_t ppu_frame_cycle(ppu_scanline_cycle.count() * static_cast<s64_t>(ppu_scanline_count));
+static inline constexpr ppu_cycle_t ppu_vblank_cycle(ppu_scanline_cycle.count() * 241 + 1);
+static inline constexpr ppu_cycle_t ppu_vblank_end_cycle(ppu_scanline_cycle.count() * 261 + 1);
 
 static constexpr cycle_t ms_to_cycle(s64_t ms)
 {
-    return {clock_hz / 1000 * ms};
+    return cycle_t{clock_hz.count() / 1000 * ms};
 }
 
 } // namespace nese
@@ -7,6 +7,9 @@ namespace {
 constexpr addr_t ram_addr_end{0x2000};
 constexpr addr_t ppu_addr_end{0x4000};
 constexpr addr_t apu_addr_end{0x4020};
+constexpr addr_t prg_addr_begin{0x8000};
+
+constexpr size_t page_size{0x100};
 
 [[nodiscard]] addr_t to_ram(addr_t addr)
 {
@@ -27,7 +30,44 @@ enum class ss
     ppu_data = 7
 };
 
-byte_t bus::readonly(addr_t addr) const
+bus::bus()
+{
+    // 2KB of RAM mirrored up to $2000
+    for (size_t page = 0; page < ram_addr_end / page_size; ++page)
+    {
+        byte_t* ram_page = &ram[to_ram(static_cast<addr_t>(page << 8))];
+
+        _read_pages[page] = ram_page;
+        _write_pages[page] = ram_page;
+    }
+}
+
+void bus::load_cartridge(nese::cartridge&& new_cartridge)
+{
+    cartridge = std::move(new_cartridge);
+
+    // Drop the switches reported while building the mapper, every page is mapped below
+    (void)cartridge.take_switched_prg_pages();
+
+    map_prg_pages(cpu_predecode_cache::all_pages);
+    cpu.invalidate_predecode();
+
+    ppu.invalidate_chr();
+}
+
+void bus::map_prg_pages(u8_t page_mask)
+{
+    for (size_t page = prg_addr_begin / page_size; page < page_count; ++page)
+    {
+        // 16 pages of 256 bytes per 4K PRG page
+        if (page_mask & (1 << ((page - prg_addr_begin / page_size) / 16)))
+        {
+            _read_pages[page] = cartridge.get_prg_page(static_cast<addr_t>(page << 8));
+        }
+    }
+}
+
+byte_t bus::readonly_unmapped(addr_t addr) const
 {
     if (addr < ram_addr_end)
     {
@@ -35,31 +75,25 @@ byte_t bus::readonly(addr_t addr) const
     }
     else if (addr < ppu_addr_end)
     {
+        // The ppu as of its last catch-up
         switch (static_cast<ss>(addr & 0x0007))
         {
+        case ss::control:
+        case ss::mask:
+        case ss::oam_addr:
         case ss::scroll:
         case ss::ppu_addr:
-        case ss::ppu_data:
-            // Unreadable
-            return 0xFF;
+            // Write only
+            return ppu.read_open_bus();
 
-        case ss::oam_addr:
-            return 0xFF;
+        case ss::status:
+            return ppu.peek_status();
 
         case ss::oam_data:
-            return 0xFF;
-
-        case ss::control:
-            return 0xFF;
-            // return ppu.read_control();
-
-        case ss::mask:
-            return 0xFF;
-            // return ppu.read_mask();
+            return ppu.read_oam_data();
 
-        case ss::status:
-            return 0xFF;
-            // return ppu.read_status();
+        case ss::ppu_data:
+            return ppu.peek_ppu_data();
         }
 
         return 0xFF;
@@ -75,7 +109,7 @@ byte_t bus::readonly(addr_t addr) const
     }
 }
 
-byte_t bus::read(addr_t addr)
+byte_t bus::read_unmapped(addr_t addr)
 {
     if (addr < ram_addr_end)
     {
@@ -83,28 +117,26 @@ byte_t bus::read(addr_t addr)
     }
     else if (addr < ppu_addr_end)
     {
+        sync_ppu();
+
         switch (static_cast<ss>(addr & 0x0007))
         {
         case ss::control:
         case ss::mask:
+        case ss::oam_addr:
         case ss::scroll:
         case ss::ppu_addr:
-            // Unreadable
-            return 0xFF;
+            // Write only
+            return ppu.read_open_bus();
 
-        case ss::oam_addr:
-            // TODO
-            return 0xFF;
+        case ss::status:
+            return ppu.read_status();
 
         case ss::oam_data:
-            // TODO
-            return 0xFF;
-
-        case ss::status:
-            //return ppu.read_status();
+            return ppu.read_oam_data();
 
         case ss::ppu_data:
-            //return ppu.read_ppu_data();
+            return ppu.read_ppu_data();
         }
 
         return 0xFF;
@@ -120,7 +152,7 @@ byte_t bus::read(addr_t addr)
     }
 }
 
-void bus::write(addr_t addr, byte_t value)
+void bus::write_unmapped(addr_t addr, byte_t value)
 {
     if (addr < ram_addr_end)
     {
@@ -128,43 +160,109 @@ void bus::write(addr_t addr, byte_t value)
     }
     else if (addr < ppu_addr_end)
     {
+        sync_ppu();
+
         switch (static_cast<ss>(addr & 0x0007))
         {
         case ss::control:
-            //ppu.write_control(value);
+            ppu.write_control(value);
             break;
 
         case ss::mask:
-            //ppu.write_mask(value);
+            ppu.write_mask(value);
             break;
 
         case ss::scroll:
-            //ppu.write_scroll(value);
+            ppu.write_scroll(value);
             break;
 
         case ss::ppu_addr:
-            //ppu.write_ppu_address(value);
+            ppu.write_ppu_addr(value);
             break;
 
         case ss::ppu_data:
-            //.write_ppu_data(value);
+            ppu.write_ppu_data(value);
             break;
 
-        case ss::status:
         case ss::oam_addr:
+            ppu.write_oam_addr(value);
+            break;
+
         case ss::oam_data:
-            // TODO
+            ppu.write_oam_data(value);
+            break;
+
+        case ss::status:
+            ppu.write_status(value);
             break;
         }
     }
     else if (addr < apu_addr_end)
     {
+        if (addr == oam_dma_addr)
+        {
+            // The scanlines before the DMA render with the old sprites
+            sync_ppu();
+            write_oam_dma(value);
+        }
+
         // TODO write to apu
     }
     else
     {
         cartridge.write(addr, value);
+
+        if (const u8_t switched_pages = cartridge.take_switched_prg_pages(); switched_pages != 0)
+        {
+            map_prg_pages(switched_pages);
+            cpu.invalidate_predecode(switched_pages);
+        }
+    }
+}
+
+void bus::schedule_sprite_zero_hit()
+{
+    if (const std::optional<ppu_cycle_t> cycle = ppu.get_next_sprite_zero_hit_cycle())
+    {
+        scheduler.schedule(scheduler_event::sprite_zero_hit, *cycle);
+    }
+    else
+    {
+        scheduler.cancel(scheduler_event::sprite_zero_hit);
+    }
+}
+
+void bus::sync_ppu()
+{
+    ppu.step(cpu.get_state().cycle);
+}
+
+void bus::write_oam_dma(byte_t page)
+{
+    const addr_t page_addr = static_cast<addr_t>(page << 8);
+
+    if (const byte_t* source = _read_pages[page]; source != nullptr) [[likely]]
+    {
+        // RAM and PRG, the whole page at once
+        ppu.write_oam_dma(std::span<const byte_t, page_size>(source, page_size));
     }
+    else
+    {
+        // I/O pages, every read has its side effects
+        array<byte_t, page_size> bytes;
+
+        for (size_t i = 0; i < page_size; ++i)
+        {
+            bytes[i] = read(static_cast<addr_t>(page_addr + i));
+        }
+
+        ppu.write_oam_dma(bytes);
+    }
+
+    // The hit predicted at the start of the frame used the previous sprite 0
+    schedule_sprite_zero_hit();
+
+    cpu.stall_oam_dma();
 }
 
-} // namespace nese
\ No newline at end of file
+} // namespace nese
@@ -4,11 +4,36 @@
 #include <nese/cartridge.hpp>
 #include <nese/cpu.hpp>
 #include <nese/ppu.hpp>
+#include <nese/scheduler.hpp>
 
 namespace nese {
 
+struct bus_cpu_policy : cpu_policy
+{
+    static constexpr bool cycle_accurate = NESE_CPU_CYCLE_ACCURATE_ENABLED;
+    static constexpr bool predecode = NESE_CPU_PREDECODE_ENABLED && !cycle_accurate;
+    static constexpr bool block_cache = predecode && NESE_CPU_BLOCK_CACHE_ENABLED;
+    static constexpr bool idle_loop_skip = block_cache && NESE_CPU_IDLE_LOOP_SKIP_ENABLED;
+    static constexpr bool fusion = block_cache && NESE_CPU_FUSION_ENABLED;
+    static constexpr bool profiling = NESE_CPU_PROFILING_ENABLED;
+    static constexpr bool call_stack = NESE_CPU_CALL_STACK_ENABLED;
+};
+
+struct bus_ppu_policy : ppu_policy
+{
+    static constexpr bool dot_accurate = NESE_PPU_DOT_ACCURATE_ENABLED;
+};
+
 struct bus
 {
+    // Writing a page number copies it to the OAM and halts the cpu
+    static constexpr addr_t oam_dma_addr{0x4014};
+
+    bus();
+
+    // Replace the cartridge and map its PRG pages
+    void load_cartridge(nese::cartridge&& new_cartridge);
+
     [[nodiscard]] byte_t readonly(addr_t addr) const;
     [[nodiscard]] byte_t read(addr_t addr);
     void write(addr_t addr, byte_t value);
@@ -17,12 +42,71 @@ struct bus
     [[nodiscard]] word_t read_word(addr_t addr);
     void write_word(addr_t addr, word_t value);
 
+    // Make the emulator run stop where the scanline renderer may set the sprite 0 hit flag, predicted from the OAM and the ppu registers
+    void schedule_sprite_zero_hit();
+
     array<byte_t, 2048> ram{};
     cartridge cartridge{};
-    cpu<bus> cpu{*this};
-    ppu<bus> ppu{*this};
+    scheduler scheduler{};
+    cpu<bus, bus_cpu_policy> cpu{*this};
+    ppu<bus, bus_ppu_policy> ppu{*this};
+
+private:
+    static constexpr size_t page_count = 0x100;
+
+    // Full address decoding of the pages without a direct pointer
+    [[nodiscard]] byte_t readonly_unmapped(addr_t addr) const;
+    [[nodiscard]] byte_t read_unmapped(addr_t addr);
+    void write_unmapped(addr_t addr, byte_t value);
+
+    // Run the ppu up to the cpu before a register access, it stays behind otherwise until the emulator catches it up after a run
+    // Timestamped with the cpu cycle, the cycle of the access on the cycle-accurate core and the start of the instruction otherwise
+    void sync_ppu();
+
+    // Copy a 256 bytes page to the OAM, predict the sprite 0 hit again and halt the cpu
+    void write_oam_dma(byte_t page);
+
+    // Refresh the read pages of the switched 4K PRG pages, bit 0 is $8000-$8FFF
+    void map_prg_pages(u8_t page_mask);
+
+    // 256 bytes pages, a direct pointer to the bytes or nullptr when the page has side effects
+    array<const byte_t*, page_count> _read_pages{};
+    array<byte_t*, page_count> _write_pages{};
 };
 
+static_assert(cpu_ram_bus<bus>);
+
+inline byte_t bus::readonly(addr_t addr) const
+{
+    if (const byte_t* page = _read_pages[addr >> 8]; page != nullptr) [[likely]]
+    {
+        return page[addr & 0xFF];
+    }
+
+    return readonly_unmapped(addr);
+}
+
+inline byte_t bus::read(addr_t addr)
+{
+    if (const byte_t* page = _read_pages[addr >> 8]; page != nullptr) [[likely]]
+    {
+        return page[addr & 0xFF];
+    }
+
+    return read_unmapped(addr);
+}
+
+inline void bus::write(addr_t addr, byte_t value)
+{
+    if (byte_t* page = _write_pages[addr >> 8]; page != nullptr) [[likely]]
+    {
+        page[addr & 0xFF] = value;
+        return;
+    }
+
+    write_unmapped(addr, value);
+}
+
 inline word_t bus::readonly_word(addr_t addr) const
 {
     return readonly(addr) + static_cast<word_t>(static_cast<word_t>(readonly(addr + 1)) << 8);
@@ -3,7 +3,6 @@
 #include <fstream>
 
 #include <nese/cartridge/cartridge_mapper_factory.hpp>
-#include <nese/utility/assert.hpp>
 #include <nese/utility/log.hpp>
 
 namespace nese {
@@ -61,7 +60,10 @@ cartridge cartridge::from_file(const char* filepath)
 
     const cartridge_mapper::mirroring mirroring = header.flag6 & 0x01 ? cartridge_mapper::mirroring::vertical : cartridge_mapper::mirroring::horizontal;
 
-    return cartridge{cartridge_mapper_factory::create(mapper_id, std::move(prg), std::move(chr), mirroring)};
+    cartridge cartridge;
+    cartridge._mapper = cartridge_mapper_factory::create(mapper_id, std::move(prg), std::move(chr), mirroring);
+
+    return cartridge;
 }
 
 cartridge::cartridge(std::unique_ptr<cartridge_mapper>&& mapper)
@@ -69,16 +71,4 @@ cartridge::cartridge(std::unique_ptr<cartridge_mapper>&& mapper)
 {
 }
 
-byte_t cartridge::read(addr_t addr) const
-{
-    NESE_ASSERT(_mapper);
-    return _mapper->read(addr);
-}
-
-void cartridge::write(addr_t addr, byte_t value)
-{
-    NESE_ASSERT(_mapper);
-    _mapper->write(addr, value);
-}
-
 } // namespace nese
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 #include <nese/basic_types.hpp>
 #include <nese/cartridge/cartridge_mapper.hpp>
+#include <nese/cartridge/cartridge_mapper_factory.hpp>
+#include <nese/utility/assert.hpp>
 
 namespace nese {
 
@@ -16,31 +21,141 @@ public:
     cartridge() = default;
     explicit cartridge(std::unique_ptr<cartridge_mapper>&& mapper);
 
+    // Hold a mapper listed in cartridge_mapper_variant by value
+    template<typename MapperT>
+    explicit cartridge(MapperT&& mapper)
+        requires is_concrete_cartridge_mapper<MapperT>;
+
     [[nodiscard]] const std::vector<byte_t>& get_prg() const;
     [[nodiscard]] const std::vector<byte_t>& get_chr() const;
 
+    // Without a mapper the CHR reads 0 and the nametables are mirrored horizontally
+    [[nodiscard]] cartridge_mapper::mirroring get_mirroring() const;
+    [[nodiscard]] byte_t read_chr(addr_t addr) const;
+    void write_chr(addr_t addr, byte_t value);
+
     [[nodiscard]] byte_t read(addr_t addr) const;
     void write(addr_t addr, byte_t value);
 
+    [[nodiscard]] u8_t take_switched_prg_pages();
+    [[nodiscard]] const byte_t* get_prg_page(addr_t addr) const;
+
     [[nodiscard]] bool is_valid() const;
 
+    // True when the mapper is held by value and its calls are not virtual
+    [[nodiscard]] bool is_mapper_concrete() const;
+
+private:
+    // Call functor with the mapper, as its concrete type when the variant holds it by value
+    template<typename FunctorT>
+    decltype(auto) visit_mapper(FunctorT&& functor) const;
+
+    template<typename FunctorT>
+    decltype(auto) visit_mapper(FunctorT&& functor);
+
 private:
-    std::unique_ptr<cartridge_mapper> _mapper;
+    cartridge_mapper_variant _mapper;
 };
 
+template<typename MapperT>
+cartridge::cartridge(MapperT&& mapper)
+    requires is_concrete_cartridge_mapper<MapperT>
+    : _mapper(std::in_place_type<MapperT>, std::move(mapper))
+{
+}
+
+template<typename FunctorT>
+decltype(auto) cartridge::visit_mapper(FunctorT&& functor) const
+{
+    return std::visit(
+        [&functor](const auto& mapper) -> decltype(auto) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(mapper)>, std::unique_ptr<cartridge_mapper>>)
+            {
+                NESE_ASSERT(mapper);
+                return functor(std::as_const(*mapper));
+            }
+            else
+            {
+                return functor(mapper);
+            }
+        },
+        _mapper);
+}
+
+template<typename FunctorT>
+decltype(auto) cartridge::visit_mapper(FunctorT&& functor)
+{
+    return std::visit(
+        [&functor](auto& mapper) -> decltype(auto) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(mapper)>, std::unique_ptr<cartridge_mapper>>)
+            {
+                NESE_ASSERT(mapper);
+                return functor(*mapper);
+            }
+            else
+            {
+                return functor(mapper);
+            }
+        },
+        _mapper);
+}
+
 inline const std::vector<byte_t>& cartridge::get_prg() const
 {
-    return _mapper->get_prg();
+    return visit_mapper([](const cartridge_mapper& mapper) -> const std::vector<byte_t>& { return mapper.get_prg(); });
 }
 
 inline const std::vector<byte_t>& cartridge::get_chr() const
 {
-    return _mapper->get_chr();
+    return visit_mapper([](const cartridge_mapper& mapper) -> const std::vector<byte_t>& { return mapper.get_chr(); });
+}
+
+inline cartridge_mapper::mirroring cartridge::get_mirroring() const
+{
+    return is_valid() ? visit_mapper([](const cartridge_mapper& mapper) { return mapper.get_mirroring(); }) : cartridge_mapper::mirroring::horizontal;
+}
+
+inline byte_t cartridge::read_chr(addr_t addr) const
+{
+    return is_valid() ? visit_mapper([addr](const cartridge_mapper& mapper) { return mapper.read_chr(addr); }) : byte_t{0};
+}
+
+inline void cartridge::write_chr(addr_t addr, byte_t value)
+{
+    if (is_valid())
+    {
+        visit_mapper([addr, value](cartridge_mapper& mapper) { mapper.write_chr(addr, value); });
+    }
+}
+
+inline byte_t cartridge::read(addr_t addr) const
+{
+    return visit_mapper([addr](const auto& mapper) { return mapper.read(addr); });
+}
+
+inline void cartridge::write(addr_t addr, byte_t value)
+{
+    visit_mapper([addr, value](auto& mapper) { mapper.write(addr, value); });
+}
+
+inline u8_t cartridge::take_switched_prg_pages()
+{
+    return visit_mapper([](cartridge_mapper& mapper) { return mapper.take_switched_prg_pages(); });
+}
+
+inline const byte_t* cartridge::get_prg_page(addr_t addr) const
+{
+    return is_valid() ? visit_mapper([addr](const cartridge_mapper& mapper) { return mapper.get_prg_page(addr); }) : nullptr;
 }
 
 inline bool cartridge::is_valid() const
 {
-    return _mapper != nullptr;
+    return is_mapper_concrete() || std::get<std::unique_ptr<cartridge_mapper>>(_mapper) != nullptr;
+}
+
+inline bool cartridge::is_mapper_concrete() const
+{
+    return !std::holds_alternative<std::unique_ptr<cartridge_mapper>>(_mapper);
 }
 
 } // namespace nese
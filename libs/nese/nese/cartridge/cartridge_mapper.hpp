@@ -1,6 +1,9 @@
 #pragma once
 
+#include <utility>
+
 #include <nese/basic_types.hpp>
+#include <nese/utility/assert.hpp>
 
 namespace nese {
 
@@ -16,24 +19,66 @@ public:
     using id = byte_t;
 
 public:
-    cartridge_mapper(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr);
+    // Without CHR ROM the cartridge has 8K of CHR RAM
+    cartridge_mapper(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, mirroring mirroring);
     virtual ~cartridge_mapper() = default;
 
+    // Moving keeps the PRG buffer so the mapped pages stay valid, a copy would point to the source
+    cartridge_mapper(const cartridge_mapper&) = delete;
+    cartridge_mapper(cartridge_mapper&&) noexcept = default;
+    cartridge_mapper& operator=(const cartridge_mapper&) = delete;
+    cartridge_mapper& operator=(cartridge_mapper&&) noexcept = default;
+
     [[nodiscard]] const std::vector<byte_t>& get_prg() const;
     [[nodiscard]] const std::vector<byte_t>& get_chr() const;
+    [[nodiscard]] mirroring get_mirroring() const;
+
+    // $0000-$1FFF of the ppu, the writes are dropped by CHR ROM
+    [[nodiscard]] byte_t read_chr(addr_t addr) const;
+    void write_chr(addr_t addr, byte_t value);
+    [[nodiscard]] bool has_chr_ram() const;
 
     [[nodiscard]] virtual byte_t read(addr_t addr) const = 0;
     virtual void write(addr_t addr, byte_t value) = 0;
 
+    // 4K pages of $8000-$FFFF switched since the last call, bit 0 is $8000-$8FFF
+    [[nodiscard]] u8_t take_switched_prg_pages();
+
+    // PRG bytes of the 256 bytes page at addr, nullptr when the page must be read through read
+    [[nodiscard]] const byte_t* get_prg_page(addr_t addr) const;
+
+protected:
+    void switch_prg_pages(u8_t page_mask);
+
+    // Map size bytes of PRG at addr, both page aligned, and switch the 4K pages they cover
+    void map_prg_pages(addr_t addr, size_t size, const byte_t* prg);
+
 private:
+    static constexpr addr_t prg_begin_addr = 0x8000;
+    static constexpr addr_t page_size = 0x100;
+    static constexpr size_t prg_page_count = 0x80;
+    static constexpr size_t chr_ram_size = 0x2000;
+
     std::vector<byte_t> _prg;
     std::vector<byte_t> _chr;
+    mirroring _mirroring;
+    bool _has_chr_ram;
+
+    array<const byte_t*, prg_page_count> _prg_pages{};
+
+    u8_t _switched_prg_pages{0};
 };
 
-inline cartridge_mapper::cartridge_mapper(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr)
+inline cartridge_mapper::cartridge_mapper(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, mirroring mirroring)
     : _prg(std::move(prg))
     , _chr(std::move(chr))
+    , _mirroring(mirroring)
+    , _has_chr_ram(_chr.empty())
 {
+    if (_has_chr_ram)
+    {
+        _chr.resize(chr_ram_size);
+    }
 }
 
 inline const std::vector<byte_t>& cartridge_mapper::get_prg() const
@@ -46,4 +91,62 @@ inline const std::vector<byte_t>& cartridge_mapper::get_chr() const
     return _chr;
 }
 
+inline cartridge_mapper::mirroring cartridge_mapper::get_mirroring() const
+{
+    return _mirroring;
+}
+
+inline byte_t cartridge_mapper::read_chr(addr_t addr) const
+{
+    return _chr[addr % _chr.size()];
+}
+
+inline void cartridge_mapper::write_chr(addr_t addr, byte_t value)
+{
+    if (_has_chr_ram)
+    {
+        _chr[addr % _chr.size()] = value;
+    }
+}
+
+inline bool cartridge_mapper::has_chr_ram() const
+{
+    return _has_chr_ram;
+}
+
+inline u8_t cartridge_mapper::take_switched_prg_pages()
+{
+    return std::exchange(_switched_prg_pages, u8_t{0});
+}
+
+inline const byte_t* cartridge_mapper::get_prg_page(addr_t addr) const
+{
+    return addr >= prg_begin_addr ? _prg_pages[(addr - prg_begin_addr) / page_size] : nullptr;
+}
+
+inline void cartridge_mapper::switch_prg_pages(u8_t page_mask)
+{
+    _switched_prg_pages |= page_mask;
+}
+
+inline void cartridge_mapper::map_prg_pages(addr_t addr, size_t size, const byte_t* prg)
+{
+    NESE_ASSERT(addr >= prg_begin_addr && addr % page_size == 0 && size % page_size == 0);
+    NESE_ASSERT(addr - prg_begin_addr + size <= prg_page_count * page_size);
+
+    const size_t first_page = (addr - prg_begin_addr) / page_size;
+
+    u8_t switched_pages = 0;
+
+    for (size_t page = first_page; page < first_page + size / page_size; ++page)
+    {
+        _prg_pages[page] = prg + (page - first_page) * page_size;
+
+        // 16 pages of 256 bytes per 4K page
+        switched_pages |= static_cast<u8_t>(1 << (page / 16));
+    }
+
+    switch_prg_pages(switched_pages);
+}
+
 } // namespace nese
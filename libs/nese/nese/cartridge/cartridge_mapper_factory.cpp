@@ -5,7 +5,7 @@
 
 namespace nese {
 
-std::unique_ptr<cartridge_mapper> cartridge_mapper_factory::create(cartridge_mapper::id id, std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring)
+cartridge_mapper_variant cartridge_mapper_factory::create(cartridge_mapper::id id, std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring)
 {
     NESE_ASSERT(_creators[id]);
 
@@ -1,19 +1,32 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <variant>
 
 #include <nese/basic_types.hpp>
 #include <nese/cartridge/cartridge_mapper.hpp>
+#include <nese/cartridge/nrom_cartridge_mapper.hpp>
 
 namespace nese {
 
-using cartridge_mapper_creator = std::unique_ptr<cartridge_mapper> (*)(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring);
+// The mappers listed after the first alternative are held by value, a cartridge dispatches to them with a switch and their reads inline
+// Any other mapper goes through the virtual interface
+using cartridge_mapper_variant = std::variant<std::unique_ptr<cartridge_mapper>, nrom_cartridge_mapper>;
+
+using cartridge_mapper_creator = cartridge_mapper_variant (*)(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring);
 using cartridge_mapper_creator_table = array<cartridge_mapper_creator, std::numeric_limits<byte_t>::max() + 1>;
 
+template<typename MapperT, typename VariantT = cartridge_mapper_variant>
+constexpr bool is_concrete_cartridge_mapper = false;
+
+template<typename MapperT, typename... MappersT>
+constexpr bool is_concrete_cartridge_mapper<MapperT, std::variant<MappersT...>> = (std::is_same_v<MapperT, MappersT> || ...);
+
 class cartridge_mapper_factory
 {
 public:
-    static std::unique_ptr<cartridge_mapper> create(cartridge_mapper::id id, std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring);
+    static cartridge_mapper_variant create(cartridge_mapper::id id, std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring);
 
     template<typename MapperT>
     static void set_creator(cartridge_mapper::id id);
@@ -36,7 +49,16 @@ void cartridge_mapper_factory::set_creator(cartridge_mapper::id id)
 template<typename MapperT>
 void cartridge_mapper_factory::set_creator(cartridge_mapper_creator_table& table, cartridge_mapper::id id)
 {
-    table[id] = [](std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring) -> std::unique_ptr<cartridge_mapper> { return std::make_unique<MapperT>(std::move(prg), std::move(chr), mirroring); };
+    table[id] = [](std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, cartridge_mapper::mirroring mirroring) -> cartridge_mapper_variant {
+        if constexpr (is_concrete_cartridge_mapper<MapperT>)
+        {
+            return cartridge_mapper_variant{std::in_place_type<MapperT>, std::move(prg), std::move(chr), mirroring};
+        }
+        else
+        {
+            return std::make_unique<MapperT>(std::move(prg), std::move(chr), mirroring);
+        }
+    };
 }
 
 } // namespace nese
@@ -2,10 +2,11 @@
 
 #include <nese/basic_types.hpp>
 #include <nese/cartridge/cartridge_mapper.hpp>
+#include <nese/utility/assert.hpp>
 
 namespace nese {
 
-class nrom_cartridge_mapper : public cartridge_mapper
+class nrom_cartridge_mapper final : public cartridge_mapper
 {
 public:
     nrom_cartridge_mapper(std::vector<byte_t>&& prg, std::vector<byte_t>&& chr, mirroring mirroring);
@@ -17,4 +18,15 @@ private:
     addr_t _mask;
 };
 
+inline byte_t nrom_cartridge_mapper::read(addr_t addr) const
+{
+    NESE_ASSERT(addr >= 0x8000);
+
+    return get_prg()[addr & _mask];
+}
+
+inline void nrom_cartridge_mapper::write(addr_t addr [[maybe_unused]], byte_t value [[maybe_unused]])
+{
+}
+
 } // namespace nese
\ No newline at end of file
@@ -1,14 +1,36 @@
 #pragma once
 
+#include <concepts>
+#include <utility>
+#include <variant>
+
 #include <nese/basic_types.hpp>
 #include <nese/cpu/cpu_addr_mode.hpp>
+#include <nese/cpu/cpu_call_stack.hpp>
 #include <nese/cpu/cpu_opcode.hpp>
+#include <nese/cpu/cpu_pair_histogram.hpp>
+#include <nese/cpu/cpu_policy.hpp>
+#include <nese/cpu/cpu_predecode_cache.hpp>
+#include <nese/cpu/cpu_profile.hpp>
 #include <nese/cpu/cpu_state.hpp>
+#include <nese/stop_reason.hpp>
 #include <nese/utility/assert.hpp>
 
 namespace nese {
 
+// Predicate of cpu::run_until that never stops, the cpu doesn't need to sync its state before each instruction
+struct cpu_no_stop
+{
+    constexpr bool operator()() const { return false; }
+};
+
+// Bus exposing its 2KB internal RAM, the zero page and the stack are accessed there without going through BusT::read and BusT::write
 template<typename BusT>
+concept cpu_ram_bus = requires(BusT& bus) {
+    { bus.ram } -> std::same_as<array<byte_t, 2048>&>;
+};
+
+template<typename BusT, typename PolicyT = cpu_policy>
 class cpu
 {
 public:
@@ -16,17 +38,56 @@ public:
 
 public:
     void reset();
+
+    // Execute the next instruction or interrupt sequence, false when a JAM opcode halted the cpu
     bool step();
     bool step(cpu_cycle_t to_cycle);
     bool step(cycle_t to_cycle);
 
-    void irq();
-    void nmi();
+    // Execute instructions until the budget is spent, dispatching with PolicyT::dispatch, false when a JAM opcode halted the cpu
+    bool run(cpu_cycle_t budget);
+
+    // Execute instructions until to_cycle, the predicate is evaluated before each instruction and stops the run when true
+    template<typename PredicateT>
+    stop_reason run_until(cpu_cycle_t to_cycle, PredicateT&& predicate);
+
+    // Interrupt lines, cycle is when the line changed on the master clock
+    // The cpu polls them during the last cycle of each instruction, a change after that is seen one instruction later
+    void irq(bool asserted, cycle_t cycle);
+    void nmi(cycle_t cycle);
+
+    // Halt for an OAM DMA after the current instruction, the bus already copied the page
+    void stall_oam_dma();
+
+    // Invalidate the predecoded instructions of the switched PRG pages, bit 0 is $8000-$8FFF
+    void invalidate_predecode(u8_t page_mask = cpu_predecode_cache::all_pages);
 
 public:
     [[nodiscard]] const cpu_state& get_state() const;
     [[nodiscard]] cpu_state& get_state();
 
+    // A JAM opcode halted the cpu, the cycles pass without executing anything until the next reset
+    [[nodiscard]] bool is_jammed() const;
+
+    [[nodiscard]] const cpu_predecode_cache& get_predecode_cache() const
+        requires PolicyT::predecode;
+
+    // Cycles jumped over in idle loops since the reset, always 0 without PolicyT::idle_loop_skip
+    [[nodiscard]] cpu_cycle_t get_idle_loop_cycles() const;
+
+    [[nodiscard]] const cpu_pair_histogram& get_pair_histogram() const
+        requires PolicyT::pair_profiling;
+
+    [[nodiscard]] const cpu_profile& get_profile() const
+        requires PolicyT::profiling;
+    [[nodiscard]] cpu_profile& get_profile()
+        requires PolicyT::profiling;
+
+    [[nodiscard]] const cpu_call_stack& get_call_stack() const
+        requires PolicyT::call_stack;
+    [[nodiscard]] cpu_call_stack& get_call_stack()
+        requires PolicyT::call_stack;
+
 private:
     using instruction_callback = void (cpu::*)();
 
@@ -38,6 +99,81 @@ private:
     friend struct instruction_callback_table;
 
 private:
+    void execute_next();
+
+    // The dispatch, the fused pairs and the block walk are forced into the run loop, a unit instantiating several policies runs out of
+    // inlining budget and would leave the block walk with a call per instruction, slower than predecode alone
+    [[gnu::always_inline]] inline void execute(byte_t opcode);
+    void execute_table(byte_t opcode);
+    [[gnu::always_inline]] inline void execute_switch(byte_t opcode);
+
+    template<byte_t OpcodeT>
+    void execute();
+
+    // Around the handler of every opcode, the fast core adds the base cost at the end
+    // The cycle-accurate core issues the dummy read of implied instructions first, then only adds the cycles no access spent
+    // The profile counts the cycles spent between the two, the call stack follows the calls and returns at the end
+    [[nodiscard]] cpu_cycle_t begin_instruction(byte_t opcode);
+    void end_instruction(byte_t opcode, cpu_cycle_t start_cycle);
+
+    // Run first and the instruction at addr as one pair, addr moves past the second instruction
+    [[gnu::always_inline]] inline void execute_fused(const cpu_predecoded_instruction& first, addr_t& addr);
+
+    template<size_t FusedPairIndexT>
+    void execute_fused(const cpu_predecoded_instruction& first, const cpu_predecoded_instruction& second, addr_t second_addr, addr_t next_addr);
+
+    template<typename PredicateT>
+    [[nodiscard]] stop_reason execute_until(cpu_cycle_t to_cycle, PredicateT& predicate);
+
+    template<typename PredicateT>
+    [[nodiscard]] stop_reason execute_block(cpu_cycle_t to_cycle, PredicateT& predicate);
+
+    // Run the block_size instructions of the block at the pc, up to to_cycle
+    template<typename PredicateT>
+    [[nodiscard, gnu::always_inline]] inline stop_reason walk_block(byte_t block_size, cpu_cycle_t to_cycle, PredicateT& predicate);
+
+    // Run one iteration of the idle loop at the pc, then skip the following ones
+    [[nodiscard]] stop_reason execute_idle_loop(byte_t block_size, cpu_cycle_t to_cycle);
+
+    template<typename PredicateT>
+    [[nodiscard]] bool should_stop(PredicateT& predicate);
+
+    [[nodiscard]] byte_t build_block(addr_t addr);
+
+    // Mark the instructions of the block running as a pair with the next one
+    void fuse_block(addr_t addr, byte_t block_size);
+
+    // Slow path of the run loop when _pending_events isn't empty, true when a DMA, an interrupt sequence or a jam took cycles
+    // A jammed cpu idles up to to_cycle
+    bool poll_pending_events(cpu_cycle_t to_cycle);
+    void interrupt(addr_t vector);
+
+    // Fold the IRQ line and the interrupt disable flag into _pending_events
+    void update_irq();
+
+    // CLI, SEI and PLP change the interrupt disable flag after the poll, it only applies to the next one
+    void delay_irq_update();
+
+    // The block branches back to its first instruction and its instructions only read side effect free addresses
+    [[nodiscard]] bool is_idle_loop(addr_t addr, byte_t block_size);
+    [[nodiscard]] static constexpr bool is_idle_loop_read(const cpu_predecoded_instruction& instruction);
+    [[nodiscard]] static constexpr bool is_ppu_status_read(const cpu_predecoded_instruction& instruction);
+
+    // INX, INY, DEX or DEY, the registers differ on every iteration so the loop always ends by itself
+    [[nodiscard]] static constexpr bool is_register_count(byte_t opcode);
+
+    // The branch right after reading the PPU status only tests the vblank or the sprite 0 hit flag
+    [[nodiscard]] static constexpr bool is_ppu_status_flag_branch(byte_t read_opcode, byte_t branch_opcode);
+
+    // Jump to to_cycle by whole iterations when the loop started from the same registers as the iteration that just ran
+    void skip_idle_loop(const cpu_state& iteration_start, cpu_cycle_t to_cycle);
+
+    [[nodiscard]] byte_t fetch();
+    [[nodiscard]] byte_t fetch_predecoded();
+    [[nodiscard]] byte_t fetch_predecoded(const cpu_predecoded_instruction& instruction, addr_t next_pc);
+
+    [[nodiscard]] cpu_predecoded_instruction* predecode(addr_t addr);
+
 #pragma region Instruction Helpers
     template<cpu_addr_mode AddrModeT>
     void add_with_carry(byte_t value);
@@ -52,6 +188,10 @@ private:
 
     template<cpu_addr_mode AddrModeT>
     void store(byte_t value);
+
+    // AHX, SHX, SHY and TAS store the value ANDed with the high byte of the base address + 1
+    template<cpu_addr_mode AddrModeT>
+    void store_high_and(byte_t value);
 #pragma endregion
 
 #pragma region Instructions
@@ -223,16 +363,39 @@ private:
     template<cpu_addr_mode AddrModeT>
     void instruction_tya();
 
-#if NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+    template<cpu_addr_mode AddrModeT>
+    void instruction_ahx();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_alr();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_anc();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_arr();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_axs();
+
     template<cpu_addr_mode AddrModeT>
     void instruction_dcp();
 
     template<cpu_addr_mode AddrModeT>
     void instruction_isb();
 
+    template<cpu_addr_mode AddrModeT>
+    void instruction_jam();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_las();
+
     template<cpu_addr_mode AddrModeT>
     void instruction_lax();
 
+    template<cpu_addr_mode AddrModeT>
+    void instruction_lxa();
+
     template<cpu_addr_mode AddrModeT>
     void instruction_rla();
 
@@ -242,12 +405,23 @@ private:
     template<cpu_addr_mode AddrModeT>
     void instruction_sax();
 
+    template<cpu_addr_mode AddrModeT>
+    void instruction_shx();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_shy();
+
     template<cpu_addr_mode AddrModeT>
     void instruction_slo();
 
     template<cpu_addr_mode AddrModeT>
     void instruction_sre();
-#endif
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_tas();
+
+    template<cpu_addr_mode AddrModeT>
+    void instruction_xaa();
 #pragma endregion
 
     // registers
@@ -261,9 +435,17 @@ private:
 
     byte_t& status();
 
+    // The base cost of every instruction comes from cpu_opcode_cycles once executed, handlers only add the extra cycles
     void step_cycle(u64_t cycle);
     void step_cycle(cpu_cycle_t cycle);
 
+    // Reads indexed across a page take one more cycle, see cpu_opcode_cycle::page_crossing
+    // The cycle-accurate core already spent it on the dummy read of decode_operand_addr
+    void step_page_crossing(bool page_crossing);
+
+    // A cycle on top of the base cost, the cycle-accurate core spends it reading addr
+    void step_dummy_read(addr_t addr);
+
     // status
     [[nodiscard]] bool is_status_set(cpu_status status) const;
     [[nodiscard]] bool is_status_clear(cpu_status status) const;
@@ -272,6 +454,12 @@ private:
     void set_status(cpu_status status);
     void clear_status(cpu_status status);
 
+    // Zero and negative flags of the result, deferred until the status is observed with lazy flags
+    void set_zero_negative(byte_t value);
+    void sync_status(cpu_status status = zero_negative_status);
+
+    [[nodiscard]] byte_t get_zero_negative_status() const;
+
     // memory
     [[nodiscard]] byte_t read(addr_t addr);
     [[nodiscard]] word_t readw(addr_t addr);
@@ -279,6 +467,13 @@ private:
     void write(addr_t addr, byte_t value);
     void writew(addr_t addr, word_t value);
 
+    // Access whose value is discarded, only issued by the cycle-accurate core, the fast one has it in the base cost
+    void dummy_read(addr_t addr);
+
+    // zero page and stack, always in the internal RAM
+    [[nodiscard]] byte_t read_ram(addr_t addr);
+    void write_ram(addr_t addr, byte_t value);
+
     // stack
     [[nodiscard]] byte_t pop();
     [[nodiscard]] word_t popw();
@@ -303,24 +498,66 @@ private:
     template<cpu_addr_mode AddrModeT>
     [[nodiscard]] addr_t decode_operand_addr(bool& page_crossing);
 
+    // Writes and read-modify-writes always read the indexed address before its high byte is fixed, reads only on a page crossing
     template<cpu_addr_mode AddrModeT>
-    [[nodiscard]] byte_t read_operand(word_t operand);
+    [[nodiscard]] word_t decode_write_operand();
 
     template<cpu_addr_mode AddrModeT>
-    void write_operand(word_t operand, byte_t value);
+    [[nodiscard]] word_t decode_write_operand(bool& page_crossing);
 
-    // cycle cost
     template<cpu_addr_mode AddrModeT>
-    [[nodiscard]] static constexpr cpu_cycle_t get_addr_mode_cycle_cost(bool page_crossing = false);
+    [[nodiscard]] byte_t read_operand(word_t operand);
+
+    template<cpu_addr_mode AddrModeT>
+    void write_operand(word_t operand, byte_t value);
 
+    // Read-modify-writes write the unmodified value back before the result
     template<cpu_addr_mode AddrModeT>
-    [[nodiscard]] static constexpr cpu_cycle_t get_shift_cycle_cost();
+    void write_modified_operand(word_t operand, byte_t value, byte_t new_value);
 
 private:
+    static constexpr cpu_status zero_negative_status = cpu_status::zero | cpu_status::negative;
+
+    // LXA and XAA OR the accumulator with a constant that varies between chips and with the temperature
+    static constexpr byte_t unstable_magic = 0xEE;
+
+    // End of the zero page and the stack
+    static constexpr addr_t ram_direct_end = 0x200;
+
     static constexpr instruction_callback_table _instructions{instruction_callback_table::create()};
 
     ref_wrap<BusT> _bus;
     cpu_state _state{};
+
+    [[no_unique_address]] std::conditional_t<PolicyT::predecode, cpu_predecode_cache, std::monostate> _predecode_cache{};
+    [[no_unique_address]] std::conditional_t<PolicyT::pair_profiling, cpu_pair_histogram, std::monostate> _pair_histogram{};
+    [[no_unique_address]] std::conditional_t<PolicyT::profiling, cpu_profile, std::monostate> _profile{};
+    [[no_unique_address]] std::conditional_t<PolicyT::call_stack, cpu_call_stack, std::monostate> _call_stack{};
+
+    // Operand of the predecoded instruction being executed, consumed by decode
+    word_t _predecoded_operand{0};
+    byte_t _predecoded_operand_size{0};
+
+    // Everything the run loop must handle between two instructions, a single check per instruction while empty
+    enum pending_event : u8_t
+    {
+        pending_nmi = 1 << 0,               // NMI edge latched
+        pending_irq = 1 << 1,               // IRQ line asserted with the interrupt disable flag clear
+        pending_irq_update = 1 << 2,        // The interrupt disable flag changed, pending_irq is updated after the next poll
+        pending_poll_delay = 1 << 3,        // A line changed after the last poll, skip servicing until the next one
+        pending_block_invalidated = 1 << 4, // A bank switch invalidated the block being executed
+        pending_oam_dma = 1 << 5,           // $4014 was written, the cpu halts before the next instruction
+        pending_jam = 1 << 6,               // A JAM opcode halted the cpu, never cleared but by a reset
+    };
+
+    u8_t _pending_events{0};
+    bool _irq_line{false};
+
+    cpu_cycle_t _idle_loop_cycles{0};
+
+    // Result the zero and negative flags are built from when pending
+    byte_t _zero_negative_result{0};
+    bool _zero_negative_pending{false};
 };
 
 } // namespace nese
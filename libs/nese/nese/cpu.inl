@@ -1,5 +1,6 @@
 #include <nese/cpu/cpu_stack_offset.hpp>
 #include <nese/utility/assert.hpp>
+#include <nese/utility/log.hpp>
 
 namespace nese {
 
@@ -11,6 +12,12 @@ constexpr bool is_page_crossing(addr_t addr, addr_t new_addr)
     return page_start != new_page_start;
 }
 
+// Indexed address before the carry of the index reached its high byte
+constexpr addr_t get_unfixed_addr(addr_t addr, addr_t new_addr)
+{
+    return static_cast<addr_t>((addr & 0xFF00) | (new_addr & 0x00FF));
+}
+
 constexpr bool is_zero(byte_t value)
 {
     return value == 0;
@@ -31,8 +38,8 @@ constexpr bool is_sign_overflow(byte_t old_byte, byte_t new_byte, byte_t byte)
     return (old_byte & 0x80) == (byte & 0x80) && (old_byte & 0x80) != (new_byte & 0x80);
 }
 
-template<typename BusT>
-consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_callback_table::create()
+template<typename BusT, typename PolicyT>
+consteval typename cpu<BusT, PolicyT>::instruction_callback_table cpu<BusT, PolicyT>::instruction_callback_table::create()
 {
     instruction_callback_table table{};
 
@@ -220,7 +227,18 @@ consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_
     table[cpu_opcode::txs_implied] = &cpu::instruction_txs<cpu_addr_mode::implied>;
     table[cpu_opcode::tya_implied] = &cpu::instruction_tya<cpu_addr_mode::implied>;
 
-#if NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+    table[cpu_opcode::ahx_absolute_y_unofficial] = &cpu::instruction_ahx<cpu_addr_mode::absolute_y>;
+    table[cpu_opcode::ahx_indirect_indexed_unofficial] = &cpu::instruction_ahx<cpu_addr_mode::indirect_indexed>;
+
+    table[cpu_opcode::alr_immediate_unofficial] = &cpu::instruction_alr<cpu_addr_mode::immediate>;
+
+    table[cpu_opcode::anc_immediate_unofficial_0B] = &cpu::instruction_anc<cpu_addr_mode::immediate>;
+    table[cpu_opcode::anc_immediate_unofficial_2B] = &cpu::instruction_anc<cpu_addr_mode::immediate>;
+
+    table[cpu_opcode::arr_immediate_unofficial] = &cpu::instruction_arr<cpu_addr_mode::immediate>;
+
+    table[cpu_opcode::axs_immediate_unofficial] = &cpu::instruction_axs<cpu_addr_mode::immediate>;
+
     table[cpu_opcode::dcp_zero_page_unofficial] = &cpu::instruction_dcp<cpu_addr_mode::zero_page>;
     table[cpu_opcode::dcp_zero_page_x_unofficial] = &cpu::instruction_dcp<cpu_addr_mode::zero_page_x>;
     table[cpu_opcode::dcp_absolute_unofficial] = &cpu::instruction_dcp<cpu_addr_mode::absolute>;
@@ -237,6 +255,21 @@ consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_
     table[cpu_opcode::isb_indexed_indirect_unofficial] = &cpu::instruction_isb<cpu_addr_mode::indexed_indirect>;
     table[cpu_opcode::isb_indirect_indexed_unofficial] = &cpu::instruction_isb<cpu_addr_mode::indirect_indexed>;
 
+    table[cpu_opcode::jam_implied_unofficial_02] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_12] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_22] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_32] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_42] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_52] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_62] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_72] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_92] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_B2] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_D2] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+    table[cpu_opcode::jam_implied_unofficial_F2] = &cpu::instruction_jam<cpu_addr_mode::implied>;
+
+    table[cpu_opcode::las_absolute_y_unofficial] = &cpu::instruction_las<cpu_addr_mode::absolute_y>;
+
     table[cpu_opcode::lax_zero_page_unofficial] = &cpu::instruction_lax<cpu_addr_mode::zero_page>;
     table[cpu_opcode::lax_zero_page_y_unofficial] = &cpu::instruction_lax<cpu_addr_mode::zero_page_y>;
     table[cpu_opcode::lax_absolute_unofficial] = &cpu::instruction_lax<cpu_addr_mode::absolute>;
@@ -244,7 +277,13 @@ consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_
     table[cpu_opcode::lax_indexed_indirect_unofficial] = &cpu::instruction_lax<cpu_addr_mode::indexed_indirect>;
     table[cpu_opcode::lax_indirect_indexed_unofficial] = &cpu::instruction_lax<cpu_addr_mode::indirect_indexed>;
 
+    table[cpu_opcode::lxa_immediate_unofficial] = &cpu::instruction_lxa<cpu_addr_mode::immediate>;
+
     table[cpu_opcode::nop_immediate_unofficial_80] = &cpu::instruction_nop<cpu_addr_mode::immediate>;
+    table[cpu_opcode::nop_immediate_unofficial_82] = &cpu::instruction_nop<cpu_addr_mode::immediate>;
+    table[cpu_opcode::nop_immediate_unofficial_89] = &cpu::instruction_nop<cpu_addr_mode::immediate>;
+    table[cpu_opcode::nop_immediate_unofficial_C2] = &cpu::instruction_nop<cpu_addr_mode::immediate>;
+    table[cpu_opcode::nop_immediate_unofficial_E2] = &cpu::instruction_nop<cpu_addr_mode::immediate>;
     table[cpu_opcode::nop_implied_unofficial_1A] = &cpu::instruction_nop<cpu_addr_mode::implied>;
     table[cpu_opcode::nop_implied_unofficial_3A] = &cpu::instruction_nop<cpu_addr_mode::implied>;
     table[cpu_opcode::nop_implied_unofficial_5A] = &cpu::instruction_nop<cpu_addr_mode::implied>;
@@ -291,6 +330,9 @@ consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_
     table[cpu_opcode::sax_absolute_unofficial] = &cpu::instruction_sax<cpu_addr_mode::absolute>;
     table[cpu_opcode::sax_indexed_indirect_unofficial] = &cpu::instruction_sax<cpu_addr_mode::indexed_indirect>;
 
+    table[cpu_opcode::shx_absolute_y_unofficial] = &cpu::instruction_shx<cpu_addr_mode::absolute_y>;
+    table[cpu_opcode::shy_absolute_x_unofficial] = &cpu::instruction_shy<cpu_addr_mode::absolute_x>;
+
     table[cpu_opcode::slo_zero_page_unofficial] = &cpu::instruction_slo<cpu_addr_mode::zero_page>;
     table[cpu_opcode::slo_zero_page_x_unofficial] = &cpu::instruction_slo<cpu_addr_mode::zero_page_x>;
     table[cpu_opcode::slo_absolute_unofficial] = &cpu::instruction_slo<cpu_addr_mode::absolute>;
@@ -306,19 +348,22 @@ consteval typename cpu<BusT>::instruction_callback_table cpu<BusT>::instruction_
     table[cpu_opcode::sre_absolute_y_unofficial] = &cpu::instruction_sre<cpu_addr_mode::absolute_y>;
     table[cpu_opcode::sre_indexed_indirect_unofficial] = &cpu::instruction_sre<cpu_addr_mode::indexed_indirect>;
     table[cpu_opcode::sre_indirect_indexed_unofficial] = &cpu::instruction_sre<cpu_addr_mode::indirect_indexed>;
-#endif // NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+
+    table[cpu_opcode::tas_absolute_y_unofficial] = &cpu::instruction_tas<cpu_addr_mode::absolute_y>;
+
+    table[cpu_opcode::xaa_immediate_unofficial] = &cpu::instruction_xaa<cpu_addr_mode::immediate>;
 
     return table;
 }
 
-template<typename BusT>
-cpu<BusT>::cpu(BusT& bus)
+template<typename BusT, typename PolicyT>
+cpu<BusT, PolicyT>::cpu(BusT& bus)
     : _bus(bus)
 {
 }
 
-template<typename BusT>
-void cpu<BusT>::reset()
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::reset()
 {
     _state.registers.pc = readw(0xFFFC);
 
@@ -329,29 +374,41 @@ void cpu<BusT>::reset()
     _state.registers.sp = 0xFD;
 
     _state.registers.status = static_cast<byte_t>(cpu_status::unused);
+    _zero_negative_pending = false;
 
     _state.cycle = cpu_cycle_t(7);
+    _idle_loop_cycles = cpu_cycle_t(0);
+
+    _pending_events = 0;
+    _irq_line = false;
+
+    invalidate_predecode();
+
+    if constexpr (PolicyT::call_stack)
+    {
+        _call_stack.reset(_state.cycle);
+    }
 }
 
-template<typename BusT>
-bool cpu<BusT>::step()
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::step()
 {
-    const auto opcode = static_cast<cpu_opcode>(decode());
-    const auto instruction = _instructions[opcode];
-
-    if (instruction == nullptr) [[unlikely]]
+    if (_pending_events != 0 && poll_pending_events(_state.cycle + cpu_cycle_t(1))) [[unlikely]]
     {
-        NESE_ERROR("[cpu] Unimplemented instruction {:02X}", opcode);
-        return false;
+        sync_status();
+
+        return !is_jammed();
     }
 
-    ((*this).*instruction)();
+    execute_table(fetch());
 
-    return true;
+    sync_status();
+
+    return !is_jammed();
 }
 
-template<typename BusT>
-bool cpu<BusT>::step(cpu_cycle_t to_cycle)
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::step(cpu_cycle_t to_cycle)
 {
     while (_state.cycle < to_cycle)
     {
@@ -368,407 +425,1257 @@ bool cpu<BusT>::step(cpu_cycle_t to_cycle)
     return true;
 }
 
-template<typename BusT>
-bool cpu<BusT>::step(cycle_t to_cycle)
-{
-    return step(std::chrono::duration_cast<cpu_cycle_t>(to_cycle));
-}
-
-template<typename BusT>
-void cpu<BusT>::irq()
-{
-}
-
-template<typename BusT>
-void cpu<BusT>::nmi()
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::step(cycle_t to_cycle)
 {
-}
+    // Compared on the master clock, the cpu cycle is scaled up instead of dividing to_cycle
+    while (_state.cycle < to_cycle)
+    {
+        if (!step()) [[unlikely]]
+        {
+            return false;
+        }
+    }
 
-template<typename BusT>
-const cpu_state& cpu<BusT>::get_state() const
-{
-    return _state;
+    return true;
 }
 
-template<typename BusT>
-cpu_state& cpu<BusT>::get_state()
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::run(cpu_cycle_t budget)
 {
-    return _state;
+    return run_until(_state.cycle + budget, cpu_no_stop{}) == stop_reason::cycles_complete;
 }
 
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::add_with_carry(byte_t value)
+template<typename BusT, typename PolicyT>
+template<typename PredicateT>
+stop_reason cpu<BusT, PolicyT>::run_until(cpu_cycle_t to_cycle, PredicateT&& predicate)
 {
-    const byte_t old_byte = a();
-
-    // FF+FF+1=FF -> need to detect such case by checking for overflow in each step
-    // However, for FF+80+1=80 -> the sign bit got "rescued" so we should just check final result
-    byte_t new_byte = a() + value;
-    bool bit7_overflow = new_byte < old_byte;
-    const byte_t new_byte_pre_carry = new_byte;
+    const stop_reason reason = execute_until(to_cycle, predicate);
 
-    new_byte += is_status_set(cpu_status::carry) ? 1 : 0;
-    bit7_overflow = bit7_overflow || new_byte < new_byte_pre_carry;
-
-    a() = new_byte;
+    sync_status();
 
-    set_status(cpu_status::overflow, is_sign_overflow(old_byte, a(), value));
-    set_status(cpu_status::carry, bit7_overflow);
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    return reason;
 }
 
-template<typename BusT>
-void cpu<BusT>::branch(bool condition)
+template<typename BusT, typename PolicyT>
+template<typename PredicateT>
+stop_reason cpu<BusT, PolicyT>::execute_until(cpu_cycle_t to_cycle, PredicateT& predicate)
 {
-    const s8_t byte = static_cast<s8_t>(decode());
+    static_assert(!PolicyT::block_cache || PolicyT::predecode, "The block cache is built from predecoded instructions");
+    static_assert(!PolicyT::idle_loop_skip || PolicyT::block_cache, "Idle loops are detected on blocks");
+    static_assert(!PolicyT::cycle_accurate || !PolicyT::predecode, "Predecoded instructions skip the fetches on the bus");
 
-    if (condition)
+    while (_state.cycle < to_cycle)
     {
-        const addr_t pre_branch_pc = pc();
+        if (_pending_events != 0 && poll_pending_events(to_cycle)) [[unlikely]]
+        {
+            // Idled up to to_cycle, the caller decides what a dead cpu means
+            if (is_jammed())
+            {
+                return stop_reason::jam;
+            }
 
-        // if branch succeeds ++
-        step_cycle(1);
-        pc() += byte;
+            continue;
+        }
 
-        // if crossing to a new page ++
-        if (is_page_crossing(pre_branch_pc, pc()))
+        if constexpr (PolicyT::block_cache)
         {
-            step_cycle(1);
+            if (cpu_predecode_cache::contains(pc()))
+            {
+                if (const stop_reason reason = execute_block(to_cycle, predicate); reason != stop_reason::cycles_complete)
+                {
+                    return reason;
+                }
+
+                continue;
+            }
         }
-    }
 
-    step_cycle(2);
-}
+        if (should_stop(predicate))
+        {
+            return stop_reason::breakpoint;
+        }
 
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::compare(byte_t to)
-{
-    bool page_crossing = false;
-    const word_t operand = decode_operand<AddrModeT>(page_crossing);
-    const byte_t byte = read_operand<AddrModeT>(operand);
-    const byte_t diff = to - byte;
+        NESE_ASSERT_CODE(const cpu_cycle_t pre_step_cycle = _state.cycle);
 
-    set_status(cpu_status::carry, to >= byte);
-    set_status(cpu_status::zero, is_zero(diff));
-    set_status(cpu_status::negative, is_negative(diff));
+        execute_next();
+
+        NESE_ASSERT(_state.cycle > pre_step_cycle);
+    }
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    return is_jammed() ? stop_reason::jam : stop_reason::cycles_complete;
 }
 
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::load(byte_t& value)
+template<typename BusT, typename PolicyT>
+template<typename PredicateT>
+bool cpu<BusT, PolicyT>::should_stop(PredicateT& predicate)
 {
-    bool page_crossing{false};
-    const word_t operand = decode_operand<AddrModeT>(page_crossing);
-
-    value = read_operand<AddrModeT>(operand);
+    if constexpr (std::is_same_v<std::remove_cvref_t<PredicateT>, cpu_no_stop>)
+    {
+        return false;
+    }
+    else
+    {
+        // The predicate may observe the state
+        sync_status();
 
-    set_status(cpu_status::zero, is_zero(value));
-    set_status(cpu_status::negative, is_negative(value));
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+        return predicate();
+    }
 }
 
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::store(byte_t value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::execute_next()
 {
-    const word_t operand = decode_operand<AddrModeT>();
+    execute(fetch());
+}
 
-    write(operand, value);
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::execute(byte_t opcode)
+{
+    if constexpr (PolicyT::dispatch == cpu_dispatch::table)
+    {
+        execute_table(opcode);
+    }
+    else
+    {
+        execute_switch(opcode);
+    }
 }
 
-// ADC (Add with Carry):
-// Adds a memory value and the carry flag to the accumulator, affecting flags for carry, zero, overflow, and negative.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_adc()
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::execute_table(byte_t opcode)
 {
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
-    const byte_t byte = read_operand<AddrModeT>(addr);
+    // Every opcode has an instruction, illegal ones included, no check left on the hot path
+    static_assert([] {
+        for (size_t i = 0; i < 256; ++i)
+        {
+            if (_instructions[i] == nullptr)
+            {
+                return false;
+            }
+        }
 
-    add_with_carry<AddrModeT>(byte);
+        return true;
+    }());
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
-}
+    const auto instruction = _instructions[opcode];
 
-// AND (Logical AND):
-// Performs a bitwise AND on the accumulator and a memory value, affecting the zero and negative flags.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_and()
-{
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
-    const byte_t byte = read_operand<AddrModeT>(addr);
+    if constexpr (PolicyT::pair_profiling)
+    {
+        _pair_histogram.record(opcode);
+    }
 
-    a() &= byte;
+    const cpu_cycle_t start_cycle = begin_instruction(opcode);
+
+    ((*this).*instruction)();
+
+    end_instruction(opcode, start_cycle);
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::execute_switch(byte_t opcode)
+{
+#define NESE_CPU_EXECUTE_CASE(opcode) \
+    case opcode:                      \
+        execute<opcode>();            \
+        return;
+
+#define NESE_CPU_EXECUTE_CASES_16(base)     \
+    NESE_CPU_EXECUTE_CASE(base + 0x0)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x1)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x2)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x3)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x4)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x5)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x6)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x7)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x8)       \
+    NESE_CPU_EXECUTE_CASE(base + 0x9)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xA)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xB)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xC)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xD)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xE)       \
+    NESE_CPU_EXECUTE_CASE(base + 0xF)
+
+    // Every case is a direct call the compiler can inline, no indirect branch through the callback table
+    switch (opcode)
+    {
+        NESE_CPU_EXECUTE_CASES_16(0x00)
+        NESE_CPU_EXECUTE_CASES_16(0x10)
+        NESE_CPU_EXECUTE_CASES_16(0x20)
+        NESE_CPU_EXECUTE_CASES_16(0x30)
+        NESE_CPU_EXECUTE_CASES_16(0x40)
+        NESE_CPU_EXECUTE_CASES_16(0x50)
+        NESE_CPU_EXECUTE_CASES_16(0x60)
+        NESE_CPU_EXECUTE_CASES_16(0x70)
+        NESE_CPU_EXECUTE_CASES_16(0x80)
+        NESE_CPU_EXECUTE_CASES_16(0x90)
+        NESE_CPU_EXECUTE_CASES_16(0xA0)
+        NESE_CPU_EXECUTE_CASES_16(0xB0)
+        NESE_CPU_EXECUTE_CASES_16(0xC0)
+        NESE_CPU_EXECUTE_CASES_16(0xD0)
+        NESE_CPU_EXECUTE_CASES_16(0xE0)
+        NESE_CPU_EXECUTE_CASES_16(0xF0)
+    }
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+#undef NESE_CPU_EXECUTE_CASES_16
+#undef NESE_CPU_EXECUTE_CASE
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    NESE_ASSUME(false);
 }
 
-// ASL (Arithmetic Shift Left):
-// Shifts all bits of the accumulator or a memory location one bit to the left, setting the carry flag with the last bit's value and affecting the zero and negative flags.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_asl()
+template<typename BusT, typename PolicyT>
+template<byte_t OpcodeT>
+void cpu<BusT, PolicyT>::execute()
 {
-    const word_t operand = decode_operand<AddrModeT>();
-    const byte_t value = read_operand<AddrModeT>(operand);
-    const byte_t new_value = static_cast<byte_t>(value << 1);
+    constexpr instruction_callback instruction = _instructions[OpcodeT];
 
-    write_operand<AddrModeT>(operand, new_value);
+    if constexpr (PolicyT::pair_profiling)
+    {
+        _pair_histogram.record(OpcodeT);
+    }
 
-    set_status(cpu_status::carry, value & 0x80);
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, is_negative(new_value));
+    const cpu_cycle_t start_cycle = begin_instruction(OpcodeT);
 
-    step_cycle(get_shift_cycle_cost<AddrModeT>());
-}
+    ((*this).*instruction)();
 
-// BCC (Branch if Carry Clear):
-// If the carry flag is clear, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bcc()
-{
-    branch(is_status_clear(cpu_status::carry));
+    end_instruction(OpcodeT, start_cycle);
 }
 
-// BCS (Branch if Carry Set):
-// If the carry flag is set, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bcs()
+template<typename BusT, typename PolicyT>
+cpu_cycle_t cpu<BusT, PolicyT>::begin_instruction(byte_t opcode [[maybe_unused]])
 {
-    branch(is_status_set(cpu_status::carry));
-}
+    const cpu_cycle_t start_cycle = _state.cycle;
 
-// BEQ (Branch if Equal):
-// If the zero flag is set, adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_beq()
-{
-    branch(is_status_set(cpu_status::zero));
-}
+    if constexpr (PolicyT::profiling)
+    {
+        _profile.begin(opcode);
+    }
 
-// BIT (Bit Test):
-// Tests bits in memory with the accumulator, affecting the zero, negative, and overflow flags.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bit()
-{
-    bool page_crossing = false;
-    const word_t operand = decode_operand<AddrModeT>(page_crossing);
-    const byte_t byte = read_operand<AddrModeT>(operand);
-    const byte_t new_byte = byte & a();
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        // Instructions without an operand read the next byte anyway, the stack ones included
+        const cpu_addr_mode addr_mode = cpu_opcode_addr_modes[opcode];
 
-    set_status(cpu_status::zero, is_zero(new_byte));
-    set_status(cpu_status::negative, is_negative(byte));
-    set_status(cpu_status::overflow, is_overflow(byte));
+        if (addr_mode == cpu_addr_mode::implied || addr_mode == cpu_addr_mode::accumulator)
+        {
+            dummy_read(pc());
+        }
+    }
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    return start_cycle;
 }
 
-// BMI (Branch if Minus):
-// If the negative flag is set, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bmi()
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::end_instruction(byte_t opcode, cpu_cycle_t start_cycle [[maybe_unused]])
 {
-    branch(is_status_set(cpu_status::negative));
-}
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        // The opcode fetch is already spent, cycles without a modeled access are padded up to the base cost
+        const cpu_cycle_t end_cycle = start_cycle + cpu_cycle_t(cpu_opcode_cycles[opcode].base - 1);
 
-// BNE (Branch if Not Equal):
-// If the zero flag is clear, adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bne()
-{
-    branch(is_status_clear(cpu_status::zero));
-}
+        _state.cycle = std::max(_state.cycle, end_cycle);
+    }
+    else
+    {
+        step_cycle(cpu_opcode_cycles[opcode].base);
+    }
 
-// BPL (Branch if Positive):
-// If the negative flag is clear, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bpl()
-{
-    branch(is_status_clear(cpu_status::negative));
-}
+    if constexpr (PolicyT::profiling)
+    {
+        // The cycle-accurate core already spent the opcode fetch before begin_instruction
+        const cpu_cycle_t fetch_cycle{PolicyT::cycle_accurate ? 1 : 0};
 
-// BRK (Branch if Positive):
-// If the negative flag is clear, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_brk()
-{
-    step_cycle(7);
-}
+        _profile.end(_state.cycle - start_cycle + fetch_cycle);
+    }
 
-// BVC (Branch if Overflow Clear):
-// If the overflow flag is clear, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bvc()
-{
-    branch(is_status_clear(cpu_status::overflow));
+    if constexpr (PolicyT::call_stack)
+    {
+        // JSR and BRK are paid by the caller, RTS and RTI by the routine returning
+        _call_stack.update(_state.cycle);
+        _call_stack.sync_sp(sp());
+
+        if (opcode == static_cast<byte_t>(cpu_opcode::jsr_absolute))
+        {
+            _call_stack.enter(pc(), sp(), 2);
+        }
+        else if (opcode == static_cast<byte_t>(cpu_opcode::brk_implied))
+        {
+            _call_stack.enter(pc(), sp(), 3);
+        }
+    }
 }
 
-// BVS (Branch if Overflow Set):
-// If the overflow flag is set, it adds the relative displacement to the program counter to branch to a new location.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_bvs()
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::execute_fused(const cpu_predecoded_instruction& first, addr_t& addr)
 {
-    branch(is_status_set(cpu_status::overflow));
+    NESE_ASSERT(first.fused_pair != 0 && first.fused_pair <= cpu_fused_pairs.size());
+
+    const cpu_predecoded_instruction& second = _predecode_cache[addr];
+
+    const addr_t second_addr = addr;
+    addr = static_cast<addr_t>(addr + 1 + second.operand_size);
+
+    // Compares on the pair index, each one calls both instructions directly
+    [&]<size_t... IndicesT>(std::index_sequence<IndicesT...>) __attribute__((always_inline)) {
+        (void)((first.fused_pair == IndicesT + 1 && (execute_fused<IndicesT>(first, second, second_addr, addr), true)) || ...);
+    }(std::make_index_sequence<cpu_fused_pairs.size()>{});
 }
 
-// CLC (Clear Carry Flag):
-// Clears the carry flag to 0.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_clc()
+template<typename BusT, typename PolicyT>
+template<size_t FusedPairIndexT>
+void cpu<BusT, PolicyT>::execute_fused(const cpu_predecoded_instruction& first, const cpu_predecoded_instruction& second, addr_t second_addr, addr_t next_addr)
 {
-    clear_status(cpu_status::carry);
+    constexpr cpu_fused_pair pair = cpu_fused_pairs[FusedPairIndexT];
+
+    NESE_ASSERT(first.opcode == static_cast<byte_t>(pair.first));
+    NESE_ASSERT(second.opcode == static_cast<byte_t>(pair.second));
 
-    step_cycle(2);
+    // The same handlers and cycle steps as two instructions, the bus sees the same accesses at the same cycles
+    (void)fetch_predecoded(first, second_addr);
+    execute<static_cast<byte_t>(pair.first)>();
+
+    (void)fetch_predecoded(second, next_addr);
+    execute<static_cast<byte_t>(pair.second)>();
 }
 
-// CLD (Clear Decimal Mode):
-// Clears the decimal mode flag, affecting how ADC and SBC instructions work.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_cld()
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::fetch()
 {
-    clear_status(cpu_status::decimal);
+    if constexpr (PolicyT::predecode)
+    {
+        if (cpu_predecode_cache::contains(pc()))
+        {
+            return fetch_predecoded();
+        }
+
+        _predecoded_operand_size = 0;
+    }
 
-    step_cycle(2);
+    return decode();
 }
 
-// CLI (Clear Interrupt Disable):
-// Clears the interrupt disable flag, allowing interrupts.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_cli()
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::fetch_predecoded()
 {
-    clear_status(cpu_status::interrupt);
+    const cpu_predecoded_instruction* instruction = predecode(pc());
 
-    step_cycle(2);
+    if (instruction == nullptr) [[unlikely]]
+    {
+        _predecoded_operand_size = 0;
+        return decode();
+    }
+
+    return fetch_predecoded(*instruction, static_cast<addr_t>(pc() + 1 + instruction->operand_size));
 }
 
-// CLV (Clear Overflow Flag):
-// Clears the overflow flag to 0, affecting subsequent arithmetic and branch instructions.
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_clv()
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::fetch_predecoded(const cpu_predecoded_instruction& instruction, addr_t next_pc)
 {
-    clear_status(cpu_status::overflow);
+    NESE_ASSERT(instruction.is_valid());
+
+    _predecoded_operand = instruction.operand;
+    _predecoded_operand_size = instruction.operand_size;
 
-    step_cycle(2);
+    // The whole instruction is consumed here, decoding the operand doesn't touch the pc again
+    pc() = next_pc;
+
+    return instruction.opcode;
 }
 
-// CMP (Compare Accumulator):
-// Compares the accumulator with a memory value, setting flags based on the subtraction result (carry, zero, and negative flags).
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_cmp()
+template<typename BusT, typename PolicyT>
+cpu_predecoded_instruction* cpu<BusT, PolicyT>::predecode(addr_t addr)
 {
-    compare<AddrModeT>(_state.registers.a);
-}
+    cpu_predecoded_instruction& instruction = _predecode_cache[addr];
+
+    if (instruction.is_valid()) [[likely]]
+    {
+        _predecode_cache.hit();
+        return &instruction;
+    }
+
+    _predecode_cache.miss();
+
+    const byte_t opcode = read(addr);
+    const byte_t operand_size = get_operand_size(cpu_opcode_addr_modes[opcode]);
+
+    // The operand wraps around to RAM, it can't be cached
+    if (addr + operand_size > 0xFFFF) [[unlikely]]
+    {
+        return nullptr;
+    }
+
+    instruction.opcode = opcode;
+    instruction.operand = operand_size == 2 ? readw(addr + 1) : operand_size == 1 ? read(addr + 1) : 0;
+    instruction.operand_size = operand_size;
+    instruction.block_size = 0;
+    instruction.is_idle_loop = false;
+    instruction.fused_pair = 0;
+
+    return &instruction;
+}
+
+template<typename BusT, typename PolicyT>
+template<typename PredicateT>
+stop_reason cpu<BusT, PolicyT>::execute_block(cpu_cycle_t to_cycle, PredicateT& predicate)
+{
+    const cpu_predecoded_instruction& first = _predecode_cache[pc()];
+
+    byte_t block_size = first.is_valid() ? first.block_size : 0;
+
+    if (block_size != 0) [[likely]]
+    {
+        _predecode_cache.block_hit();
+    }
+    else
+    {
+        _predecode_cache.block_miss();
+
+        block_size = build_block(pc());
+
+        // No block can start here, run the instruction on its own
+        if (block_size == 0) [[unlikely]]
+        {
+            if (should_stop(predicate))
+            {
+                return stop_reason::breakpoint;
+            }
+
+            execute_next();
+
+            return stop_reason::cycles_complete;
+        }
+    }
+
+    // Skipping jumps over the instructions the predicate would have seen
+    // The loops are rare, their bookkeeping stays out of the walk of every other block
+    if constexpr (PolicyT::idle_loop_skip && std::is_same_v<std::remove_cvref_t<PredicateT>, cpu_no_stop>)
+    {
+        if (first.is_idle_loop) [[unlikely]]
+        {
+            return execute_idle_loop(block_size, to_cycle);
+        }
+    }
+
+    return walk_block(block_size, to_cycle, predicate);
+}
+
+template<typename BusT, typename PolicyT>
+template<typename PredicateT>
+stop_reason cpu<BusT, PolicyT>::walk_block(byte_t block_size, cpu_cycle_t to_cycle, PredicateT& predicate)
+{
+    // The predicate must see every instruction
+    constexpr bool can_fuse = PolicyT::fusion && std::is_same_v<std::remove_cvref_t<PredicateT>, cpu_no_stop>;
+
+    // Only the last instruction of a block changes the control flow, the block is walked without reading the pc back
+    addr_t addr = pc();
+
+    for (byte_t i = 0; i < block_size && _state.cycle < to_cycle; ++i)
+    {
+        if (should_stop(predicate))
+        {
+            return stop_reason::breakpoint;
+        }
+
+        NESE_ASSERT_CODE(const cpu_cycle_t pre_step_cycle = _state.cycle);
+        NESE_ASSERT(addr == pc());
+
+        const cpu_predecoded_instruction& instruction = _predecode_cache[addr];
+
+        addr = static_cast<addr_t>(addr + 1 + instruction.operand_size);
+
+        if constexpr (can_fuse)
+        {
+            // The second instruction is in the block and would have run before to_cycle
+            if (instruction.fused_pair != 0 && i + 1 < block_size && _state.cycle + cpu_cycle_t(cpu_opcode_cycles[instruction.opcode].base) < to_cycle)
+            {
+                ++i;
+
+                execute_fused(instruction, addr);
+
+                NESE_ASSERT(_state.cycle > pre_step_cycle);
+
+                if (_pending_events != 0) [[unlikely]]
+                {
+                    return stop_reason::cycles_complete;
+                }
+
+                continue;
+            }
+        }
+
+        execute(fetch_predecoded(instruction, addr));
+
+        NESE_ASSERT(_state.cycle > pre_step_cycle);
+
+        // Interrupts are polled between instructions by execute_until, a bank switch leaves a stale block, a jam stops everything
+        if (_pending_events != 0) [[unlikely]]
+        {
+            return stop_reason::cycles_complete;
+        }
+    }
+
+    return stop_reason::cycles_complete;
+}
+
+template<typename BusT, typename PolicyT>
+stop_reason cpu<BusT, PolicyT>::execute_idle_loop(byte_t block_size, cpu_cycle_t to_cycle)
+{
+    sync_status();
+
+    const cpu_state iteration_start = _state;
+
+    // A couple of instructions before the skip, they run one by one like the instructions outside of the blocks
+    for (byte_t i = 0; i < block_size && _state.cycle < to_cycle && _pending_events == 0; ++i)
+    {
+        execute_next();
+    }
+
+    skip_idle_loop(iteration_start, to_cycle);
+
+    return stop_reason::cycles_complete;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::build_block(addr_t addr)
+{
+    const addr_t begin = addr;
+
+    byte_t block_size = 0;
+
+    while (block_size < cpu_predecode_cache::max_block_size)
+    {
+        const cpu_predecoded_instruction* instruction = predecode(addr);
+
+        // An instruction overlapping the next page would survive the invalidation of that page
+        if (instruction == nullptr || !cpu_predecode_cache::is_same_page(begin, static_cast<addr_t>(addr + instruction->operand_size)))
+        {
+            break;
+        }
+
+        ++block_size;
+
+        if (cpu_opcode_is_control_flows[instruction->opcode])
+        {
+            break;
+        }
+
+        const size_t next_addr = size_t{addr} + 1 + instruction->operand_size;
+
+        if (next_addr > 0xFFFF || !cpu_predecode_cache::is_same_page(begin, static_cast<addr_t>(next_addr)))
+        {
+            break;
+        }
+
+        addr = static_cast<addr_t>(next_addr);
+    }
+
+    _predecode_cache[begin].block_size = block_size;
+
+    if constexpr (PolicyT::idle_loop_skip)
+    {
+        _predecode_cache[begin].is_idle_loop = is_idle_loop(begin, block_size);
+    }
+
+    if constexpr (PolicyT::fusion)
+    {
+        fuse_block(begin, block_size);
+    }
+
+    return block_size;
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::fuse_block(addr_t addr, byte_t block_size)
+{
+    for (byte_t i = 0; i + 1 < block_size; ++i)
+    {
+        cpu_predecoded_instruction& instruction = _predecode_cache[addr];
+
+        addr = static_cast<addr_t>(addr + 1 + instruction.operand_size);
+
+        instruction.fused_pair = get_fused_pair(instruction.opcode, _predecode_cache[addr].opcode);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::is_idle_loop(addr_t addr, byte_t block_size)
+{
+    const addr_t begin = addr;
+
+    bool reads_ppu_status = false;
+
+    for (byte_t i = 0; i + 1 < block_size; ++i)
+    {
+        const cpu_predecoded_instruction& instruction = _predecode_cache[addr];
+
+        // A delay loop counts down a register, skip_idle_loop would compare the registers after every iteration and never skip it
+        if (!is_idle_loop_read(instruction) || is_register_count(instruction.opcode))
+        {
+            return false;
+        }
+
+        reads_ppu_status |= is_ppu_status_read(instruction);
+
+        addr = static_cast<addr_t>(addr + 1 + instruction.operand_size);
+    }
+
+    const cpu_predecoded_instruction& last = _predecode_cache[addr];
+
+    if (cpu_opcode_addr_modes[last.opcode] == cpu_addr_mode::relative)
+    {
+        if (static_cast<addr_t>(addr + 2 + static_cast<s8_t>(last.operand)) != begin)
+        {
+            return false;
+        }
+
+        // The sprite overflow is set while rendering without an event ending the run, only a branch on N or V right after the load or BIT
+        // can't be waiting on it, they hold the vblank and the sprite 0 hit flags which have theirs
+        return !reads_ppu_status || (block_size == 2 && is_ppu_status_flag_branch(_predecode_cache[begin].opcode, last.opcode));
+    }
+
+    return last.opcode == static_cast<byte_t>(cpu_opcode::jmp_absolute) && last.operand == begin;
+}
+
+template<typename BusT, typename PolicyT>
+constexpr bool cpu<BusT, PolicyT>::is_idle_loop_read(const cpu_predecoded_instruction& instruction)
+{
+    if (!cpu_opcode_is_side_effect_frees[instruction.opcode])
+    {
+        return false;
+    }
+
+    // RAM and cartridge memory reads have no side effect, reading the PPU status again has none either
+    // Its flags change on their own, is_idle_loop only keeps the loops waiting on a flag with an event, every other register may change on each read ($2007, $4016, ...)
+    const addr_t addr = instruction.operand;
+
+    switch (cpu_opcode_addr_modes[instruction.opcode])
+    {
+    case cpu_addr_mode::absolute:
+        return addr < 0x2000 || (addr & 0xE007) == 0x2002 || addr >= 0x6000;
+
+    case cpu_addr_mode::absolute_x:
+    case cpu_addr_mode::absolute_y:
+        return addr + 0xFF < 0x2000 || addr >= 0x6000;
+
+    default:
+        return true;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+constexpr bool cpu<BusT, PolicyT>::is_ppu_status_read(const cpu_predecoded_instruction& instruction)
+{
+    return cpu_opcode_addr_modes[instruction.opcode] == cpu_addr_mode::absolute && (instruction.operand & 0xE007) == 0x2002;
+}
+
+template<typename BusT, typename PolicyT>
+constexpr bool cpu<BusT, PolicyT>::is_register_count(byte_t opcode)
+{
+    return opcode == static_cast<byte_t>(cpu_opcode::inx_implied) || opcode == static_cast<byte_t>(cpu_opcode::iny_implied) ||
+           opcode == static_cast<byte_t>(cpu_opcode::dex_implied) || opcode == static_cast<byte_t>(cpu_opcode::dey_implied);
+}
+
+template<typename BusT, typename PolicyT>
+constexpr bool cpu<BusT, PolicyT>::is_ppu_status_flag_branch(byte_t read_opcode, byte_t branch_opcode)
+{
+    // N is bit 7 after a load or BIT, V is bit 6 after BIT and unchanged by a load
+    const bool is_read = read_opcode == static_cast<byte_t>(cpu_opcode::lda_absolute) || read_opcode == static_cast<byte_t>(cpu_opcode::ldx_absolute) ||
+                         read_opcode == static_cast<byte_t>(cpu_opcode::ldy_absolute) || read_opcode == static_cast<byte_t>(cpu_opcode::bit_absolute);
+
+    const bool is_flag_branch = branch_opcode == static_cast<byte_t>(cpu_opcode::bpl_relative) || branch_opcode == static_cast<byte_t>(cpu_opcode::bmi_relative) ||
+                                branch_opcode == static_cast<byte_t>(cpu_opcode::bvc_relative) || branch_opcode == static_cast<byte_t>(cpu_opcode::bvs_relative);
+
+    return is_read && is_flag_branch;
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::skip_idle_loop(const cpu_state& iteration_start, cpu_cycle_t to_cycle)
+{
+    sync_status();
+
+    // Cut short by to_cycle or left the loop
+    if (_state.cycle >= to_cycle || _state.registers != iteration_start.registers || _pending_events != 0)
+    {
+        return;
+    }
+
+    // Nothing changed but the cycle, every following iteration reads the same values and runs the same way
+    const cpu_cycle_t iteration_cycles = _state.cycle - iteration_start.cycle;
+    const cpu_cycle_t skipped_cycles = iteration_cycles * ((to_cycle - _state.cycle) / iteration_cycles);
+
+    _state.cycle += skipped_cycles;
+    _idle_loop_cycles += skipped_cycles;
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::irq(bool asserted, cycle_t cycle)
+{
+    _irq_line = asserted;
+
+    update_irq();
+
+    // The last cycle of the previous instruction started before the change
+    if (asserted && cycle > _state.cycle - cpu_cycle_t(1))
+    {
+        _pending_events |= pending_poll_delay;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::nmi(cycle_t cycle)
+{
+    _pending_events |= pending_nmi;
+
+    if (cycle > _state.cycle - cpu_cycle_t(1))
+    {
+        _pending_events |= pending_poll_delay;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::stall_oam_dma()
+{
+    _pending_events |= pending_oam_dma;
+}
+
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::poll_pending_events(cpu_cycle_t to_cycle)
+{
+    // Stuck until a reset, the interrupts are ignored
+    if (is_jammed()) [[unlikely]]
+    {
+        _state.cycle = std::max(_state.cycle, to_cycle);
+        return true;
+    }
+
+    // The poll of the last instruction saw the lines before these updates
+    const u8_t events = _pending_events;
+
+    _pending_events = static_cast<u8_t>(_pending_events & ~(pending_irq_update | pending_poll_delay | pending_block_invalidated | pending_oam_dma));
+
+    if ((events & pending_irq_update) != 0)
+    {
+        update_irq();
+    }
+
+    const bool oam_dma = (events & pending_oam_dma) != 0;
+
+    if (oam_dma)
+    {
+        // 1 halt cycle, 1 more to align on an even cycle, then 256 reads and writes
+        step_cycle(cpu_cycle_t(513 + (_state.cycle.count() & 1)));
+    }
+
+    if ((events & pending_poll_delay) != 0)
+    {
+        return oam_dma;
+    }
+
+    if ((events & pending_nmi) != 0)
+    {
+        _pending_events = static_cast<u8_t>(_pending_events & ~pending_nmi);
+        interrupt(0xFFFA);
+        return true;
+    }
+
+    if ((events & pending_irq) != 0)
+    {
+        interrupt(0xFFFE);
+        return true;
+    }
+
+    return oam_dma;
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::interrupt(addr_t vector)
+{
+    // Two reads of the opcode the sequence replaces
+    dummy_read(pc());
+    dummy_read(pc());
+
+    pushw(pc());
+
+    // The break flag is only set when pushed by BRK and PHP
+    push(static_cast<byte_t>((status() & ~cpu_status::break_cmd) | cpu_status::unused));
+
+    set_status(cpu_status::interrupt);
+    update_irq();
+
+    pc() = readw(vector);
+
+    if constexpr (!PolicyT::cycle_accurate)
+    {
+        step_cycle(7);
+    }
+
+    if constexpr (PolicyT::call_stack)
+    {
+        // The sequence is paid by the interrupted routine
+        _call_stack.update(_state.cycle);
+        _call_stack.enter(pc(), sp(), 3);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::update_irq()
+{
+    if (_irq_line && is_status_clear(cpu_status::interrupt))
+    {
+        _pending_events |= pending_irq;
+    }
+    else
+    {
+        _pending_events = static_cast<u8_t>(_pending_events & ~pending_irq);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::delay_irq_update()
+{
+    _pending_events |= pending_irq_update;
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::invalidate_predecode(u8_t page_mask [[maybe_unused]])
+{
+    if constexpr (PolicyT::predecode)
+    {
+        _predecode_cache.invalidate(page_mask);
+        _pending_events |= pending_block_invalidated;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+const cpu_state& cpu<BusT, PolicyT>::get_state() const
+{
+    return _state;
+}
+
+template<typename BusT, typename PolicyT>
+cpu_state& cpu<BusT, PolicyT>::get_state()
+{
+    return _state;
+}
+
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::is_jammed() const
+{
+    return (_pending_events & pending_jam) != 0;
+}
+
+template<typename BusT, typename PolicyT>
+const cpu_predecode_cache& cpu<BusT, PolicyT>::get_predecode_cache() const
+    requires PolicyT::predecode
+{
+    return _predecode_cache;
+}
+
+template<typename BusT, typename PolicyT>
+cpu_cycle_t cpu<BusT, PolicyT>::get_idle_loop_cycles() const
+{
+    return _idle_loop_cycles;
+}
+
+template<typename BusT, typename PolicyT>
+const cpu_pair_histogram& cpu<BusT, PolicyT>::get_pair_histogram() const
+    requires PolicyT::pair_profiling
+{
+    return _pair_histogram;
+}
+
+template<typename BusT, typename PolicyT>
+const cpu_profile& cpu<BusT, PolicyT>::get_profile() const
+    requires PolicyT::profiling
+{
+    return _profile;
+}
+
+template<typename BusT, typename PolicyT>
+cpu_profile& cpu<BusT, PolicyT>::get_profile()
+    requires PolicyT::profiling
+{
+    return _profile;
+}
+
+template<typename BusT, typename PolicyT>
+const cpu_call_stack& cpu<BusT, PolicyT>::get_call_stack() const
+    requires PolicyT::call_stack
+{
+    return _call_stack;
+}
+
+template<typename BusT, typename PolicyT>
+cpu_call_stack& cpu<BusT, PolicyT>::get_call_stack()
+    requires PolicyT::call_stack
+{
+    return _call_stack;
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::add_with_carry(byte_t value)
+{
+    const byte_t old_byte = a();
+
+    // FF+FF+1=FF -> need to detect such case by checking for overflow in each step
+    // However, for FF+80+1=80 -> the sign bit got "rescued" so we should just check final result
+    byte_t new_byte = a() + value;
+    bool bit7_overflow = new_byte < old_byte;
+    const byte_t new_byte_pre_carry = new_byte;
+
+    new_byte += is_status_set(cpu_status::carry) ? 1 : 0;
+    bit7_overflow = bit7_overflow || new_byte < new_byte_pre_carry;
+
+    a() = new_byte;
+
+    set_status(cpu_status::overflow, is_sign_overflow(old_byte, a(), value));
+    set_status(cpu_status::carry, bit7_overflow);
+    set_zero_negative(a());
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::branch(bool condition)
+{
+    const s8_t byte = static_cast<s8_t>(decode());
+
+    if (condition)
+    {
+        const addr_t pre_branch_pc = pc();
+
+        // if branch succeeds ++
+        step_dummy_read(pre_branch_pc);
+        pc() += byte;
+
+        // if crossing to a new page ++, the high byte isn't fixed yet
+        if (is_page_crossing(pre_branch_pc, pc()))
+        {
+            step_dummy_read(get_unfixed_addr(pre_branch_pc, pc()));
+
+            if constexpr (PolicyT::profiling)
+            {
+                _profile.record_page_crossing();
+            }
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::compare(byte_t to)
+{
+    bool page_crossing = false;
+    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+    const byte_t byte = read_operand<AddrModeT>(operand);
+    const byte_t diff = to - byte;
+
+    set_status(cpu_status::carry, to >= byte);
+    set_zero_negative(diff);
+
+    step_page_crossing(page_crossing);
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::load(byte_t& value)
+{
+    bool page_crossing{false};
+    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+
+    value = read_operand<AddrModeT>(operand);
+
+    set_zero_negative(value);
+    step_page_crossing(page_crossing);
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::store(byte_t value)
+{
+    const word_t operand = decode_write_operand<AddrModeT>();
+
+    write_operand<AddrModeT>(operand, value);
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::store_high_and(byte_t value)
+{
+    bool page_crossing{false};
+    const addr_t addr = decode_write_operand<AddrModeT>(page_crossing);
+    const addr_t base_addr = static_cast<addr_t>(addr - (AddrModeT == cpu_addr_mode::absolute_x ? x() : y()));
+    const byte_t stored_value = value & static_cast<byte_t>((base_addr >> 8) + 1);
+
+    // The high byte of the address isn't fixed up on a page crossing, the stored value replaces it
+    const addr_t stored_addr = page_crossing ? static_cast<addr_t>((stored_value << 8) | (addr & 0xFF)) : addr;
+
+    write(stored_addr, stored_value);
+}
+
+// ADC (Add with Carry):
+// Adds a memory value and the carry flag to the accumulator, affecting flags for carry, zero, overflow, and negative.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_adc()
+{
+    bool page_crossing{false};
+    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const byte_t byte = read_operand<AddrModeT>(addr);
+
+    add_with_carry<AddrModeT>(byte);
+
+    step_page_crossing(page_crossing);
+}
+
+// AND (Logical AND):
+// Performs a bitwise AND on the accumulator and a memory value, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_and()
+{
+    bool page_crossing{false};
+    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const byte_t byte = read_operand<AddrModeT>(addr);
+
+    a() &= byte;
+
+    set_zero_negative(a());
+
+    step_page_crossing(page_crossing);
+}
+
+// ASL (Arithmetic Shift Left):
+// Shifts all bits of the accumulator or a memory location one bit to the left, setting the carry flag with the last bit's value and affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_asl()
+{
+    const word_t operand = decode_write_operand<AddrModeT>();
+    const byte_t value = read_operand<AddrModeT>(operand);
+    const byte_t new_value = static_cast<byte_t>(value << 1);
+
+    write_modified_operand<AddrModeT>(operand, value, new_value);
+
+    set_status(cpu_status::carry, value & 0x80);
+    set_zero_negative(new_value);
+}
+
+// BCC (Branch if Carry Clear):
+// If the carry flag is clear, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bcc()
+{
+    branch(is_status_clear(cpu_status::carry));
+}
+
+// BCS (Branch if Carry Set):
+// If the carry flag is set, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bcs()
+{
+    branch(is_status_set(cpu_status::carry));
+}
+
+// BEQ (Branch if Equal):
+// If the zero flag is set, adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_beq()
+{
+    branch(is_status_set(cpu_status::zero));
+}
+
+// BIT (Bit Test):
+// Tests bits in memory with the accumulator, affecting the zero, negative, and overflow flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bit()
+{
+    bool page_crossing = false;
+    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+    const byte_t byte = read_operand<AddrModeT>(operand);
+    const byte_t new_byte = byte & a();
+
+    set_status(cpu_status::zero, is_zero(new_byte));
+    set_status(cpu_status::negative, is_negative(byte));
+    set_status(cpu_status::overflow, is_overflow(byte));
+
+    step_page_crossing(page_crossing);
+}
+
+// BMI (Branch if Minus):
+// If the negative flag is set, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bmi()
+{
+    branch(is_status_set(cpu_status::negative));
+}
+
+// BNE (Branch if Not Equal):
+// If the zero flag is clear, adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bne()
+{
+    branch(is_status_clear(cpu_status::zero));
+}
+
+// BPL (Branch if Positive):
+// If the negative flag is clear, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bpl()
+{
+    branch(is_status_clear(cpu_status::negative));
+}
+
+// BRK (Force Interrupt):
+// Pushes the program counter and the processor status with the break flag set, then loads the program counter from the IRQ vector at $FFFE.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_brk()
+{
+    // The padding byte after the opcode is read like any implied operand, the return address skips it
+    pushw(pc() + 1);
+
+    // Same break and unused bits as PHP, the interrupt sequence clears the break flag
+    push(status() | 0x30);
+
+    set_status(cpu_status::interrupt);
+    update_irq();
+
+    pc() = readw(0xFFFE);
+}
+
+// BVC (Branch if Overflow Clear):
+// If the overflow flag is clear, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bvc()
+{
+    branch(is_status_clear(cpu_status::overflow));
+}
+
+// BVS (Branch if Overflow Set):
+// If the overflow flag is set, it adds the relative displacement to the program counter to branch to a new location.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_bvs()
+{
+    branch(is_status_set(cpu_status::overflow));
+}
+
+// CLC (Clear Carry Flag):
+// Clears the carry flag to 0.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_clc()
+{
+    clear_status(cpu_status::carry);
+}
+
+// CLD (Clear Decimal Mode):
+// Clears the decimal mode flag, affecting how ADC and SBC instructions work.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_cld()
+{
+    clear_status(cpu_status::decimal);
+}
+
+// CLI (Clear Interrupt Disable):
+// Clears the interrupt disable flag, allowing interrupts.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_cli()
+{
+    clear_status(cpu_status::interrupt);
+    delay_irq_update();
+}
+
+// CLV (Clear Overflow Flag):
+// Clears the overflow flag to 0, affecting subsequent arithmetic and branch instructions.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_clv()
+{
+    clear_status(cpu_status::overflow);
+}
+
+// CMP (Compare Accumulator):
+// Compares the accumulator with a memory value, setting flags based on the subtraction result (carry, zero, and negative flags).
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_cmp()
+{
+    compare<AddrModeT>(_state.registers.a);
+}
 
 // CPX (Compare X Register):
 // Compares the X register with a memory value, setting flags based on the subtraction result (carry, zero, and negative flags).
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_cpx()
+void cpu<BusT, PolicyT>::instruction_cpx()
 {
     compare<AddrModeT>(_state.registers.x);
 }
 
 // CPY (Compare Y Register):
 // Compares the Y register with a memory value, setting flags based on the subtraction result (carry, zero, and negative flags).
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_cpy()
+void cpu<BusT, PolicyT>::instruction_cpy()
 {
     compare<AddrModeT>(_state.registers.y);
 }
 
 // DEC (Decrement Memory):
 // Decrements the value at a specified memory location by one, setting the zero and negative flags based on the result.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_dec()
+void cpu<BusT, PolicyT>::instruction_dec()
 {
-    const addr_t addr = decode_operand_addr<AddrModeT>();
-    const byte_t value = read(addr);
+    const addr_t addr = decode_write_operand<AddrModeT>();
+    const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = value - 1;
 
-    write(addr, new_value);
-
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, is_negative(new_value));
-
-    switch (AddrModeT)
-    {
-    case cpu_addr_mode::zero_page:
-        step_cycle(5);
-        break;
-
-    case cpu_addr_mode::zero_page_x:
-    case cpu_addr_mode::absolute:
-        step_cycle(6);
-        break;
-
-    case cpu_addr_mode::absolute_x:
-        step_cycle(7);
-        break;
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
-    default:
-        NESE_ASSERT(false);
-    }
+    set_zero_negative(new_value);
 }
 
 // DEX (Decrement X Register):
 // Decreases the value in the X register by one, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_dex()
+void cpu<BusT, PolicyT>::instruction_dex()
 {
     --x();
 
-    set_status(cpu_status::zero, is_zero(x()));
-    set_status(cpu_status::negative, is_negative(x()));
-    step_cycle(2);
+    set_zero_negative(x());
 }
 
 // DEY (Decrement Y Register):
 // Decreases the value in the Y register by one, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_dey()
+void cpu<BusT, PolicyT>::instruction_dey()
 {
     --y();
 
-    set_status(cpu_status::zero, is_zero(y()));
-    set_status(cpu_status::negative, is_negative(y()));
-    step_cycle(2);
+    set_zero_negative(y());
 }
 
 // EOR (Exclusive OR):
 // Performs a bitwise exclusive OR between the accumulator and a memory value, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_eor()
+void cpu<BusT, PolicyT>::instruction_eor()
 {
     bool page_crossing{false};
     const addr_t addr = decode_operand<AddrModeT>(page_crossing);
@@ -776,78 +1683,53 @@ void cpu<BusT>::instruction_eor()
 
     a() ^= byte;
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    set_zero_negative(a());
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    step_page_crossing(page_crossing);
 }
 
 // INC (Increment Memory):
 // Increments the value at a specified memory location by one, setting the zero and negative flags based on the result.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_inc()
+void cpu<BusT, PolicyT>::instruction_inc()
 {
-    const addr_t addr = decode_operand_addr<AddrModeT>();
-    const byte_t value = read(addr);
+    const addr_t addr = decode_write_operand<AddrModeT>();
+    const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = value + 1;
 
-    write(addr, new_value);
-
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, is_negative(new_value));
-
-    switch (AddrModeT)
-    {
-    case cpu_addr_mode::zero_page:
-        step_cycle(5);
-        break;
-
-    case cpu_addr_mode::zero_page_x:
-    case cpu_addr_mode::absolute:
-        step_cycle(6);
-        break;
-
-    case cpu_addr_mode::absolute_x:
-        step_cycle(7);
-        break;
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
-    default:
-        NESE_ASSERT(false);
-    }
+    set_zero_negative(new_value);
 }
 
 // INX (Increment Register):
 // Increases a register by one, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_inx()
+void cpu<BusT, PolicyT>::instruction_inx()
 {
     ++x();
 
-    set_status(cpu_status::zero, is_zero(x()));
-    set_status(cpu_status::negative, is_negative(x()));
-    step_cycle(2);
+    set_zero_negative(x());
 }
 
 // INX (Increment X Register):
 // Increases the X register by one, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_iny()
+void cpu<BusT, PolicyT>::instruction_iny()
 {
     ++y();
 
-    set_status(cpu_status::zero, is_zero(y()));
-    set_status(cpu_status::negative, is_negative(y()));
-    step_cycle(2);
+    set_zero_negative(y());
 }
 
 // JMP (Jump):
 // Sets the program counter to the address specified by the operand, effectively jumping to a new code location.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_jmp()
+void cpu<BusT, PolicyT>::instruction_jmp()
 {
     addr_t new_addr;
 
@@ -871,99 +1753,107 @@ void cpu<BusT>::instruction_jmp()
         new_addr = decode_operand_addr<AddrModeT>();
     }
 
-    if (new_addr == pc() - 1)
-    {
-        // TODO Infinite loop
-    }
-
     pc() = new_addr;
-    step_cycle(AddrModeT == cpu_addr_mode::indirect ? 5 : 3);
 }
 
 // JSR (Jump to Subroutine):
 // Pushes the address (minus one) of the next operation on to the stack and sets the program counter to the target address, for subroutine calls.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_jsr()
+void cpu<BusT, PolicyT>::instruction_jsr()
 {
-    // we push the actual return address -1, which is the current place (before decoding the 16-bit addr) + 1
-    pushw(pc() + 1);
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        // The high byte of the address is only read after the pushes, the pc points to it meanwhile
+        const byte_t lo = decode();
 
-    pc() = decode_operand_addr<AddrModeT>();
-    step_cycle(cpu_cycle_t(6));
+        dummy_read(sp() + cpu_stack_offset);
+        pushw(pc());
+
+        const byte_t hi = decode();
+
+        pc() = static_cast<addr_t>(lo) + static_cast<addr_t>(static_cast<addr_t>(hi) << 8);
+    }
+    else
+    {
+        const addr_t addr = decode_operand_addr<AddrModeT>();
+
+        // we push the actual return address -1, which is the last byte of the 16-bit addr
+        pushw(pc() - 1);
+
+        pc() = addr;
+    }
 }
 
 // LDA (Load Accumulator):
 // Loads a value into the accumulator from memory or an immediate value, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_lda()
+void cpu<BusT, PolicyT>::instruction_lda()
 {
     load<AddrModeT>(a());
 }
 
 // LDX (Load X Register):
 // Loads a value into the X register from memory or an immediate value, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_ldx()
+void cpu<BusT, PolicyT>::instruction_ldx()
 {
     load<AddrModeT>(x());
 }
 
 // LDY (Load Y Register):
 // Loads a value into the Y register from memory or an immediate value, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_ldy()
+void cpu<BusT, PolicyT>::instruction_ldy()
 {
     load<AddrModeT>(y());
 }
 
 // LSR (Logical Shift Right):
 // Shifts all bits of the accumulator or a memory location one bit to the right, setting the carry flag with the first bit's value and affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_lsr()
+void cpu<BusT, PolicyT>::instruction_lsr()
 {
-    const word_t operand = decode_operand<AddrModeT>();
+    const word_t operand = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(operand);
     const byte_t new_value = static_cast<byte_t>(value >> 1);
 
-    write_operand<AddrModeT>(operand, new_value);
+    write_modified_operand<AddrModeT>(operand, value, new_value);
 
     set_status(cpu_status::carry, value & 0x1);
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, false); // never negative
-    // set_status(cpu_status::negative, is_negative(new_value));
-
-    step_cycle(get_shift_cycle_cost<AddrModeT>());
+    set_zero_negative(new_value); // never negative, bit 7 is shifted in as 0
 }
 
 // NOP (No Operation):
 // Performs no operation and is used for timing adjustments and code alignment.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_nop()
+void cpu<BusT, PolicyT>::instruction_nop()
 {
     if constexpr (AddrModeT != cpu_addr_mode::implied)
     {
         bool page_crossing{false};
         [[maybe_unused]] const word_t operand = decode_operand<AddrModeT>(page_crossing);
 
-        step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
-    }
-    else
-    {
-        step_cycle(2);
+        // The operand is read like any other read instruction
+        if constexpr (AddrModeT != cpu_addr_mode::immediate)
+        {
+            dummy_read(operand);
+        }
+
+        step_page_crossing(page_crossing);
     }
 }
 
 // ORA (Logical Inclusive OR):
 // Performs a bitwise OR between the accumulator and a memory value, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_ora()
+void cpu<BusT, PolicyT>::instruction_ora()
 {
     bool page_crossing{false};
     const addr_t addr = decode_operand<AddrModeT>(page_crossing);
@@ -971,133 +1861,128 @@ void cpu<BusT>::instruction_ora()
 
     a() |= byte;
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    set_zero_negative(a());
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    step_page_crossing(page_crossing);
 }
 
 // PHA (Push Accumulator):
 // Pushes a copy of the accumulator onto the stack.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_pha()
+void cpu<BusT, PolicyT>::instruction_pha()
 {
     push(a());
-
-    step_cycle(3);
 }
 
 // PHP (Push Processor Status):
 // Pushes a copy of the status flags onto the stack.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_php()
+void cpu<BusT, PolicyT>::instruction_php()
 {
     // http://wiki.nesdev.com/w/index.php/cpu_status_behavior
     // Set bit 5 and 4 to 1 when copy status into from PHP
     push(status() | 0x30);
-
-    step_cycle(3);
 }
 
 // PLA (Pull Accumulator):
 // Pulls a byte from the stack into the accumulator, affecting the zero and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_pla()
+void cpu<BusT, PolicyT>::instruction_pla()
 {
-    a() = pop();
+    // The stack pointer is incremented during a cycle reading the top of the stack
+    dummy_read(sp() + cpu_stack_offset);
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    a() = pop();
 
-    step_cycle(4);
+    set_zero_negative(a());
 }
 
 // PLP (Pull Processor Status):
 // Pulls the processor status flags from the stack.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_plp()
+void cpu<BusT, PolicyT>::instruction_plp()
 {
     // http://wiki.nesdev.com/w/index.php/cpu_status_behavior
     // Bit 5 and 4 are ignored when pulled from stack - which means they are preserved
     // @TODO - Nintendulator actually always sets bit 5, not sure which one is correct
+    dummy_read(sp() + cpu_stack_offset);
     status() = (pop() & 0xef) | (status() & 0x10) | 0x20;
-
-    step_cycle(4);
+    delay_irq_update();
 }
 
 // RTI (Return from Interrupt):
 // Restores the CPU's state from the stack, including the program counter and processor flags, to conclude an interrupt service routine.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_rti()
+void cpu<BusT, PolicyT>::instruction_rti()
 {
     instruction_plp<AddrModeT>();
 
-    pc() = popw();
+    // Unlike PLP, the restored interrupt disable flag is already seen by the poll of RTI
+    update_irq();
 
-    step_cycle(2);
+    pc() = popw();
 }
 
 // RTS (Return from Subroutine):
 // Pulls the program counter (plus one) from the stack, returning from a subroutine.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_rts()
+void cpu<BusT, PolicyT>::instruction_rts()
 {
-    pc() = popw() + 1;
+    dummy_read(sp() + cpu_stack_offset);
+
+    pc() = popw();
+
+    // The pulled address is read while it is incremented
+    dummy_read(pc());
 
-    step_cycle(6);
+    ++pc();
 }
 
 // ROL (Rotate Left):
 // Rotates all bits of the accumulator or a memory location one bit to the left, including the carry flag, affecting the carry, zero, and negative flags.template<addr_mode AddrModeT>
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_rol()
+void cpu<BusT, PolicyT>::instruction_rol()
 {
-    const word_t operand = decode_operand<AddrModeT>();
+    const word_t operand = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(operand);
     const byte_t carry_mask = is_status_set(cpu_status::carry) ? 0x01 : 0x00;
     const byte_t new_value = value << 1 | carry_mask;
 
-    write_operand<AddrModeT>(operand, new_value);
+    write_modified_operand<AddrModeT>(operand, value, new_value);
 
     set_status(cpu_status::carry, value & 0x80);
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, is_negative(new_value));
-
-    step_cycle(get_shift_cycle_cost<AddrModeT>());
+    set_zero_negative(new_value);
 }
 
 // ROR (Rotate Right):
 // Rotates all bits of the accumulator or a memory location one bit to the right, including the carry flag, affecting the carry, zero, and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_ror()
+void cpu<BusT, PolicyT>::instruction_ror()
 {
-    const word_t operand = decode_operand<AddrModeT>();
+    const word_t operand = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(operand);
     const byte_t carry_mask = is_status_set(cpu_status::carry) ? 0x80 : 0x00;
     const byte_t new_value = value >> 1 | carry_mask;
 
-    write_operand<AddrModeT>(operand, new_value);
+    write_modified_operand<AddrModeT>(operand, value, new_value);
 
     set_status(cpu_status::carry, value & 0x1);
-    set_status(cpu_status::zero, is_zero(new_value));
-    set_status(cpu_status::negative, is_negative(new_value));
-
-    step_cycle(get_shift_cycle_cost<AddrModeT>());
+    set_zero_negative(new_value);
 }
 
 // SBC (Subtract with Carry):
 // Subtracts a memory value and the carry flag from the accumulator, affecting flags for carry, zero, overflow, and negative.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sbc()
+void cpu<BusT, PolicyT>::instruction_sbc()
 {
     bool page_crossing{false};
     const addr_t addr = decode_operand<AddrModeT>(page_crossing);
@@ -1105,202 +1990,262 @@ void cpu<BusT>::instruction_sbc()
 
     add_with_carry<AddrModeT>(~byte);
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    step_page_crossing(page_crossing);
 }
 
 // SEC (Set Carry Flag):
 // Sets the carry flag to 1.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sec()
+void cpu<BusT, PolicyT>::instruction_sec()
 {
     set_status(cpu_status::carry);
-
-    step_cycle(2);
 }
 
 // SED (Set Decimal Mode):
 // Sets the decimal mode flag, affecting how ADC and SBC instructions work.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sed()
+void cpu<BusT, PolicyT>::instruction_sed()
 {
     set_status(cpu_status::decimal);
-
-    step_cycle(2);
 }
 
 // SEI (Set Interrupt Disable):
 // Sets the interrupt disable flag, preventing interrupts.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sei()
+void cpu<BusT, PolicyT>::instruction_sei()
 {
     set_status(cpu_status::interrupt);
-
-    step_cycle(2);
+    delay_irq_update();
 }
 
 // STA (Store Accumulator):
 // Stores the value in the accumulator into a specific location in memory.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sta()
+void cpu<BusT, PolicyT>::instruction_sta()
 {
     store<AddrModeT>(a());
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(true));
 }
 
 // STX (Store X Register):
 // Stores the value in the X register into a specified memory location.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_stx()
+void cpu<BusT, PolicyT>::instruction_stx()
 {
     store<AddrModeT>(x());
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>());
 }
 
 // STY (Store Y Register):
 // Stores the value in the Y register into a specified memory location.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sty()
+void cpu<BusT, PolicyT>::instruction_sty()
 {
     store<AddrModeT>(y());
+}
+
+// TAX (Transfer Accumulator to X):
+// Transfers the value in the accumulator to the X register, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_tax()
+{
+    x() = a();
+
+    set_zero_negative(x());
+}
+
+// TAY (Transfer Accumulator to Y):
+// Transfers the value in the accumulator to the Y register, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_tay()
+{
+    y() = a();
+
+    set_zero_negative(y());
+}
+
+// TSX (Transfer Stack Pointer to X):
+// Transfers the current stack pointer value to the X register, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_tsx()
+{
+    x() = sp();
+
+    set_zero_negative(x());
+}
+
+// TXA (Transfer X to Accumulator):
+// Transfers the value in the X register to the accumulator, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_txa()
+{
+    a() = x();
+
+    set_zero_negative(a());
+}
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>());
+// TXS (Transfer X to Stack Pointer):
+// Transfers the value in the X register to the stack pointer. Note that this instruction does not affect any flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_txs()
+{
+    sp() = x();
 }
 
-// TAX (Transfer Accumulator to X):
-// Transfers the value in the accumulator to the X register, affecting the zero and negative flags.
-template<typename BusT>
+// TYA (Transfer Y to Accumulator):
+// Transfers the value in the Y register to the accumulator, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_tax()
+void cpu<BusT, PolicyT>::instruction_tya()
 {
-    x() = a();
-
-    set_status(cpu_status::zero, is_zero(x()));
-    set_status(cpu_status::negative, is_negative(x()));
+    a() = y();
 
-    step_cycle(2);
+    set_zero_negative(a());
 }
 
-// TAY (Transfer Accumulator to Y):
-// Transfers the value in the accumulator to the Y register, affecting the zero and negative flags.
-template<typename BusT>
+// AHX (Store A AND X AND High Address), also known as SHA:
+// Stores the accumulator ANDed with the X register and the high byte of the base address + 1, without affecting any flags.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_tay()
+void cpu<BusT, PolicyT>::instruction_ahx()
 {
-    y() = a();
-
-    set_status(cpu_status::zero, is_zero(y()));
-    set_status(cpu_status::negative, is_negative(y()));
-
-    step_cycle(2);
+    store_high_and<AddrModeT>(a() & x());
 }
 
-// TSX (Transfer Stack Pointer to X):
-// Transfers the current stack pointer value to the X register, affecting the zero and negative flags.
-template<typename BusT>
+// ALR (AND then Logical Shift Right), also known as ASR:
+// ANDs the accumulator with an immediate value then shifts it right, affecting the carry, zero, and negative flags.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_tsx()
+void cpu<BusT, PolicyT>::instruction_alr()
 {
-    x() = sp();
+    const byte_t value = a() & read_operand<AddrModeT>(decode_operand<AddrModeT>());
 
-    set_status(cpu_status::zero, is_zero(x()));
-    set_status(cpu_status::negative, is_negative(x()));
+    a() = value >> 1;
 
-    step_cycle(2);
+    set_status(cpu_status::carry, value & 0x1);
+    set_zero_negative(a());
 }
 
-// TXA (Transfer X to Accumulator):
-// Transfers the value in the X register to the accumulator, affecting the zero and negative flags.
-template<typename BusT>
+// ANC (AND then Copy Negative to Carry):
+// ANDs the accumulator with an immediate value, the carry flag is set like the negative flag.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_txa()
+void cpu<BusT, PolicyT>::instruction_anc()
 {
-    a() = x();
+    a() &= read_operand<AddrModeT>(decode_operand<AddrModeT>());
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
-
-    step_cycle(2);
+    set_status(cpu_status::carry, is_negative(a()));
+    set_zero_negative(a());
 }
 
-// TXS (Transfer X to Stack Pointer):
-// Transfers the value in the X register to the stack pointer. Note that this instruction does not affect any flags.
-template<typename BusT>
+// ARR (AND then Rotate Right):
+// ANDs the accumulator with an immediate value then rotates it right, the carry flag is set from bit 6 and the overflow flag from bit 6 XOR bit 5.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_txs()
+void cpu<BusT, PolicyT>::instruction_arr()
 {
-    sp() = x();
+    const byte_t value = a() & read_operand<AddrModeT>(decode_operand<AddrModeT>());
+    const byte_t carry_mask = is_status_set(cpu_status::carry) ? 0x80 : 0x00;
+
+    a() = value >> 1 | carry_mask;
 
-    step_cycle(2);
+    set_status(cpu_status::carry, (a() & 0x40) != 0);
+    set_status(cpu_status::overflow, ((a() >> 6) ^ (a() >> 5)) & 0x1);
+    set_zero_negative(a());
 }
 
-// TYA (Transfer Y to Accumulator):
-// Transfers the value in the Y register to the accumulator, affecting the zero and negative flags.
-template<typename BusT>
+// AXS (AND X with Accumulator then Subtract), also known as SBX:
+// Subtracts an immediate value from the accumulator ANDed with X without borrow and stores the result in X, affecting the carry, zero, and negative flags.
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_tya()
+void cpu<BusT, PolicyT>::instruction_axs()
 {
-    a() = y();
+    const byte_t value = read_operand<AddrModeT>(decode_operand<AddrModeT>());
+    const byte_t and_value = a() & x();
 
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    x() = and_value - value;
 
-    step_cycle(2);
+    set_status(cpu_status::carry, and_value >= value);
+    set_zero_negative(x());
 }
 
-#if NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
 // DCP (Decrement Memory then Compare with Accumulator):
 // Decrements a memory location and then compares the result with the accumulator, setting the zero, carry, and negative flags based on the subtraction result.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_dcp()
+void cpu<BusT, PolicyT>::instruction_dcp()
 {
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const addr_t addr = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = value - 1;
 
-    write_operand<AddrModeT>(addr, new_value);
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
     const byte_t diff = a() - new_value;
 
     set_status(cpu_status::carry, a() >= new_value);
-    set_status(cpu_status::zero, is_zero(diff));
-    set_status(cpu_status::negative, is_negative(diff));
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
+    set_zero_negative(diff);
 }
 
 // ISB (Increment Memory then Subtract with Borrow):
 // Increments the value at a memory location, then subtracts it from the accumulator with borrow, affecting the carry, zero, negative, and overflow flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_isb()
+void cpu<BusT, PolicyT>::instruction_isb()
 {
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const addr_t addr = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = value + 1;
 
-    write_operand<AddrModeT>(addr, new_value);
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
     add_with_carry<AddrModeT>(~new_value);
+}
+
+// JAM (Halt), also known as KIL:
+// Locks the cpu on the opcode, only a reset restarts it and the interrupts are ignored.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_jam()
+{
+    --pc();
+
+    _pending_events |= pending_jam;
+}
+
+// LAS (Load Accumulator, X and Stack Pointer):
+// Loads the accumulator, the X register and the stack pointer with a memory value ANDed with the stack pointer, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_las()
+{
+    bool page_crossing{false};
+    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const byte_t value = read_operand<AddrModeT>(addr) & sp();
+
+    a() = value;
+    x() = value;
+    sp() = value;
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
+    set_zero_negative(value);
+
+    step_page_crossing(page_crossing);
 }
 
 // LAX (Load Accumulator and X):
 // Loads both the accumulator and the X register with the same memory content, updating the zero and negative flags based on the value loaded.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_lax()
+void cpu<BusT, PolicyT>::instruction_lax()
 {
     bool page_crossing{false};
     const addr_t addr = decode_operand<AddrModeT>(page_crossing);
@@ -1309,227 +2254,424 @@ void cpu<BusT>::instruction_lax()
     a() = value;
     x() = value;
 
-    set_status(cpu_status::zero, is_zero(value));
-    set_status(cpu_status::negative, is_negative(value));
+    set_zero_negative(value);
+
+    step_page_crossing(page_crossing);
+}
+
+// LXA (Load Accumulator and X with AND), also known as ATX:
+// Loads the accumulator and the X register with the accumulator ORed with an unstable constant then ANDed with an immediate value, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_lxa()
+{
+    const byte_t value = (a() | unstable_magic) & read_operand<AddrModeT>(decode_operand<AddrModeT>());
+
+    a() = value;
+    x() = value;
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    set_zero_negative(value);
 }
 
 // RLA (Rotate Left then AND):
 // Rotates a memory location or the accumulator left, then ANDs the result with the accumulator, affecting the carry, zero, and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_rla()
+void cpu<BusT, PolicyT>::instruction_rla()
 {
-    bool page_crossing{false};
-    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+    const word_t operand = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(operand);
     const byte_t carry_mask = is_status_set(cpu_status::carry) ? 0x01 : 0x00;
     const byte_t new_value = value << 1 | carry_mask;
 
-    write_operand<AddrModeT>(operand, new_value);
+    write_modified_operand<AddrModeT>(operand, value, new_value);
 
     a() &= new_value;
 
     set_status(cpu_status::carry, (value & 0x80) != 0);
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
+    set_zero_negative(a());
 }
 
 // RRA (Rotate Right then Add):
 // Rotates a memory location or the accumulator right, then adds the result to the accumulator with carry, affecting the carry, zero, and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_rra()
+void cpu<BusT, PolicyT>::instruction_rra()
 {
-    bool page_crossing{false};
-    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+    const word_t operand = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(operand);
     const byte_t carry_mask = is_status_set(cpu_status::carry) ? 0x80 : 0x00;
     const byte_t new_value = value >> 1 | carry_mask;
 
-    write_operand<AddrModeT>(operand, new_value);
+    write_modified_operand<AddrModeT>(operand, value, new_value);
 
     set_status(cpu_status::carry, value & 0x1);
 
     add_with_carry<AddrModeT>(new_value);
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
 }
 
 // SAX (Store Accumulator and X):
 // Stores the bitwise AND of the accumulator and the X register to memory, without affecting any flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sax()
+void cpu<BusT, PolicyT>::instruction_sax()
 {
     bool page_crossing{false};
     const addr_t addr = decode_operand<AddrModeT>(page_crossing);
 
     write_operand<AddrModeT>(addr, static_cast<byte_t>(a() & x()));
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing));
+    step_page_crossing(page_crossing);
+}
+
+// SHX (Store X AND High Address):
+// Stores the X register ANDed with the high byte of the base address + 1, without affecting any flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_shx()
+{
+    store_high_and<AddrModeT>(x());
+}
+
+// SHY (Store Y AND High Address):
+// Stores the Y register ANDed with the high byte of the base address + 1, without affecting any flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_shy()
+{
+    store_high_and<AddrModeT>(y());
 }
 
 // SLO (Shift Left then Logical OR):
 // Shifts the value in memory one bit to the left (ASL) and then performs an OR operation with the accumulator, affecting the zero, negative, and carry flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_slo()
+void cpu<BusT, PolicyT>::instruction_slo()
 {
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const addr_t addr = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = static_cast<byte_t>(value << 1);
 
-    write_operand<AddrModeT>(addr, new_value);
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
     a() |= new_value;
 
     set_status(cpu_status::carry, is_negative(value));
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
-
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
+    set_zero_negative(a());
 }
 
 // SRE (Shift Right then Exclusive OR):
 // Shifts a memory location or the accumulator right, then XORs the result with the accumulator, affecting the carry, zero, and negative flags.
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::instruction_sre()
+void cpu<BusT, PolicyT>::instruction_sre()
 {
-    bool page_crossing{false};
-    const addr_t addr = decode_operand<AddrModeT>(page_crossing);
+    const addr_t addr = decode_write_operand<AddrModeT>();
     const byte_t value = read_operand<AddrModeT>(addr);
     const byte_t new_value = static_cast<byte_t>(value >> 1);
 
-    write_operand<AddrModeT>(addr, new_value);
+    write_modified_operand<AddrModeT>(addr, value, new_value);
 
     a() ^= new_value;
 
     set_status(cpu_status::carry, value & 0x1);
-    set_status(cpu_status::zero, is_zero(a()));
-    set_status(cpu_status::negative, is_negative(a()));
+    set_zero_negative(a());
+}
+
+// TAS (Transfer A AND X to Stack Pointer then Store), also known as SHS:
+// Sets the stack pointer to the accumulator ANDed with X, then stores it ANDed with the high byte of the base address + 1, without affecting any flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_tas()
+{
+    sp() = a() & x();
+
+    store_high_and<AddrModeT>(sp());
+}
 
-    step_cycle(get_addr_mode_cycle_cost<AddrModeT>(page_crossing) + cpu_cycle_t(2));
+// XAA (Transfer X to Accumulator then AND), also known as ANE:
+// Sets the accumulator to itself ORed with an unstable constant, ANDed with X and an immediate value, affecting the zero and negative flags.
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+void cpu<BusT, PolicyT>::instruction_xaa()
+{
+    a() = (a() | unstable_magic) & x() & read_operand<AddrModeT>(decode_operand<AddrModeT>());
+
+    set_zero_negative(a());
 }
-#endif
 
-template<typename BusT>
-byte_t& cpu<BusT>::a()
+template<typename BusT, typename PolicyT>
+byte_t& cpu<BusT, PolicyT>::a()
 {
     return _state.registers.a;
 }
 
-template<typename BusT>
-byte_t& cpu<BusT>::x()
+template<typename BusT, typename PolicyT>
+byte_t& cpu<BusT, PolicyT>::x()
 {
     return _state.registers.x;
 }
 
-template<typename BusT>
-byte_t& cpu<BusT>::y()
+template<typename BusT, typename PolicyT>
+byte_t& cpu<BusT, PolicyT>::y()
 {
     return _state.registers.y;
 }
 
-template<typename BusT>
-byte_t& cpu<BusT>::sp()
+template<typename BusT, typename PolicyT>
+byte_t& cpu<BusT, PolicyT>::sp()
 {
     return _state.registers.sp;
 }
 
-template<typename BusT>
-word_t& cpu<BusT>::pc()
+template<typename BusT, typename PolicyT>
+word_t& cpu<BusT, PolicyT>::pc()
 {
     return _state.registers.pc;
 }
 
-template<typename BusT>
-byte_t& cpu<BusT>::status()
+template<typename BusT, typename PolicyT>
+byte_t& cpu<BusT, PolicyT>::status()
 {
+    sync_status();
+
     return _state.registers.status;
 }
 
-template<typename BusT>
-void cpu<BusT>::step_cycle(u64_t cycle)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::step_cycle(u64_t cycle)
 {
     step_cycle(cpu_cycle_t(cycle));
 }
 
-template<typename BusT>
-void cpu<BusT>::step_cycle(cpu_cycle_t cycle)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::step_cycle(cpu_cycle_t cycle)
 {
     _state.cycle += cycle;
 }
 
-template<typename BusT>
-bool cpu<BusT>::is_status_set(cpu_status status) const
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::step_page_crossing(bool page_crossing)
+{
+    if constexpr (PolicyT::profiling)
+    {
+        if (page_crossing)
+        {
+            _profile.record_page_crossing();
+        }
+    }
+
+    if constexpr (!PolicyT::cycle_accurate)
+    {
+        if (page_crossing)
+        {
+            step_cycle(1);
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::step_dummy_read(addr_t addr [[maybe_unused]])
+{
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        dummy_read(addr);
+    }
+    else
+    {
+        step_cycle(1);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::is_status_set(cpu_status status) const
 {
+    if constexpr (PolicyT::lazy_flags)
+    {
+        if (_zero_negative_pending && (status & zero_negative_status) != cpu_status::none)
+        {
+            return (get_zero_negative_status() & status) != cpu_status::none;
+        }
+    }
+
     return _state.registers.is_status_set(status);
 }
 
-template<typename BusT>
-bool cpu<BusT>::is_status_clear(cpu_status status) const
+template<typename BusT, typename PolicyT>
+bool cpu<BusT, PolicyT>::is_status_clear(cpu_status status) const
 {
-    return _state.registers.is_status_clear(status);
+    return !is_status_set(status);
 }
 
-template<typename BusT>
-void cpu<BusT>::set_status(cpu_status status, bool value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::set_status(cpu_status status, bool value)
 {
+    sync_status(status);
+
     _state.registers.set_status(status, value);
 }
 
-template<typename BusT>
-void cpu<BusT>::set_status(cpu_status status)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::set_status(cpu_status status)
 {
+    sync_status(status);
+
     _state.registers.set_status(status);
 }
 
-template<typename BusT>
-void cpu<BusT>::clear_status(cpu_status status)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::clear_status(cpu_status status)
 {
+    sync_status(status);
+
     _state.registers.clear_status(status);
 }
 
-template<typename BusT>
-byte_t cpu<BusT>::read(addr_t addr)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::set_zero_negative(byte_t value)
+{
+    if constexpr (PolicyT::lazy_flags)
+    {
+        _zero_negative_result = value;
+        _zero_negative_pending = true;
+    }
+    else
+    {
+        _state.registers.set_status(cpu_status::zero, is_zero(value));
+        _state.registers.set_status(cpu_status::negative, is_negative(value));
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::sync_status(cpu_status status)
+{
+    if constexpr (PolicyT::lazy_flags)
+    {
+        if (_zero_negative_pending && (status & zero_negative_status) != cpu_status::none)
+        {
+            _state.registers.status = get_zero_negative_status();
+            _zero_negative_pending = false;
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::get_zero_negative_status() const
+{
+    const byte_t status = _state.registers.status & static_cast<byte_t>(~zero_negative_status);
+    const byte_t zero = is_zero(_zero_negative_result) ? static_cast<byte_t>(cpu_status::zero) : 0;
+    const byte_t negative = _zero_negative_result & static_cast<byte_t>(cpu_status::negative);
+
+    return status | zero | negative;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::read(addr_t addr)
 {
-    return _bus.get().read(addr);
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        // The bus sees the access at its cycle, the next one starts after it
+        const byte_t value = _bus.get().read(addr);
+        step_cycle(1);
+        return value;
+    }
+    else
+    {
+        return _bus.get().read(addr);
+    }
 }
 
-template<typename BusT>
-word_t cpu<BusT>::readw(addr_t addr)
+template<typename BusT, typename PolicyT>
+word_t cpu<BusT, PolicyT>::readw(addr_t addr)
 {
-    return _bus.get().read_word(addr);
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        const byte_t lo = read(addr);
+        const byte_t hi = read(addr + 1);
+
+        return static_cast<word_t>(hi << 8) + lo;
+    }
+    else
+    {
+        return _bus.get().read_word(addr);
+    }
 }
 
-template<typename BusT>
-void cpu<BusT>::write(addr_t addr, byte_t value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::write(addr_t addr, byte_t value)
 {
     _bus.get().write(addr, value);
+
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        step_cycle(1);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::writew(addr_t addr, word_t value)
+{
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        write(addr, static_cast<byte_t>(value & 0xff));
+        write(addr + 1, static_cast<byte_t>(value >> 8));
+    }
+    else
+    {
+        _bus.get().write_word(addr, value);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::dummy_read(addr_t addr [[maybe_unused]])
+{
+    if constexpr (PolicyT::cycle_accurate)
+    {
+        (void)read(addr);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::read_ram(addr_t addr)
+{
+    NESE_ASSERT(addr < ram_direct_end);
+
+    // The cycle-accurate core shows every access to the bus
+    if constexpr (cpu_ram_bus<BusT> && !PolicyT::cycle_accurate)
+    {
+        return _bus.get().ram[addr];
+    }
+    else
+    {
+        return read(addr);
+    }
 }
 
-template<typename BusT>
-void cpu<BusT>::writew(addr_t addr, word_t value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::write_ram(addr_t addr, byte_t value)
 {
-    _bus.get().write_word(addr, value);
+    NESE_ASSERT(addr < ram_direct_end);
+
+    if constexpr (cpu_ram_bus<BusT> && !PolicyT::cycle_accurate)
+    {
+        _bus.get().ram[addr] = value;
+    }
+    else
+    {
+        write(addr, value);
+    }
 }
 
-template<typename BusT>
-byte_t cpu<BusT>::pop()
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::pop()
 {
     ++sp();
 
-    return read(sp() + cpu_stack_offset);
+    return read_ram(sp() + cpu_stack_offset);
 }
 
-template<typename BusT>
-word_t cpu<BusT>::popw()
+template<typename BusT, typename PolicyT>
+word_t cpu<BusT, PolicyT>::popw()
 {
     const byte_t lo = pop();
     const byte_t hi = pop();
@@ -1537,30 +2679,55 @@ word_t cpu<BusT>::popw()
     return static_cast<word_t>(hi << 8) + lo;
 }
 
-template<typename BusT>
-void cpu<BusT>::push(byte_t value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::push(byte_t value)
 {
-    write(sp() + cpu_stack_offset, value);
+    write_ram(sp() + cpu_stack_offset, value);
 
     --sp();
 }
 
-template<typename BusT>
-void cpu<BusT>::pushw(word_t value)
+template<typename BusT, typename PolicyT>
+void cpu<BusT, PolicyT>::pushw(word_t value)
 {
     push(value >> 8);
     push(value & 0xff);
 }
 
-template<typename BusT>
-byte_t cpu<BusT>::decode()
+template<typename BusT, typename PolicyT>
+byte_t cpu<BusT, PolicyT>::decode()
 {
+    if constexpr (PolicyT::predecode)
+    {
+        if (_predecoded_operand_size != 0)
+        {
+            const byte_t decoded = static_cast<byte_t>(_predecoded_operand & 0xff);
+
+            _predecoded_operand >>= 8;
+            --_predecoded_operand_size;
+
+            return decoded;
+        }
+    }
+
     return read(pc()++);
 }
 
-template<typename BusT>
-word_t cpu<BusT>::decodew()
+template<typename BusT, typename PolicyT>
+word_t cpu<BusT, PolicyT>::decodew()
 {
+    if constexpr (PolicyT::predecode)
+    {
+        if (_predecoded_operand_size != 0)
+        {
+            NESE_ASSERT(_predecoded_operand_size == 2);
+
+            _predecoded_operand_size = 0;
+
+            return _predecoded_operand;
+        }
+    }
+
     const word_t decoded = readw(pc());
 
     pc() += 2;
@@ -1568,17 +2735,17 @@ word_t cpu<BusT>::decodew()
     return decoded;
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-word_t cpu<BusT>::decode_operand()
+word_t cpu<BusT, PolicyT>::decode_operand()
 {
     bool page_crossing{false};
     return decode_operand<AddrModeT>(page_crossing);
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-word_t cpu<BusT>::decode_operand(bool& page_crossing)
+word_t cpu<BusT, PolicyT>::decode_operand(bool& page_crossing)
 {
     if constexpr (AddrModeT == cpu_addr_mode::accumulator)
     {
@@ -1593,17 +2760,17 @@ word_t cpu<BusT>::decode_operand(bool& page_crossing)
     return decode_operand_addr<AddrModeT>(page_crossing);
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-addr_t cpu<BusT>::decode_operand_addr()
+addr_t cpu<BusT, PolicyT>::decode_operand_addr()
 {
     bool page_crossing{false};
     return decode_operand_addr<AddrModeT>(page_crossing);
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
+addr_t cpu<BusT, PolicyT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
 {
     if constexpr (AddrModeT == cpu_addr_mode::zero_page)
     {
@@ -1612,12 +2779,21 @@ addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
 
     if constexpr (AddrModeT == cpu_addr_mode::zero_page_x)
     {
-        return decode() + x() & 0xFF;
+        const byte_t addr = decode();
+
+        // The base address is read while the index is added
+        dummy_read(addr);
+
+        return addr + x() & 0xFF;
     }
 
     if constexpr (AddrModeT == cpu_addr_mode::zero_page_y)
     {
-        return decode() + y() & 0xFF;
+        const byte_t addr = decode();
+
+        dummy_read(addr);
+
+        return addr + y() & 0xFF;
     }
 
     if constexpr (AddrModeT == cpu_addr_mode::absolute)
@@ -1632,6 +2808,11 @@ addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
 
         page_crossing = is_page_crossing(addr, new_addr);
 
+        if (page_crossing)
+        {
+            dummy_read(get_unfixed_addr(addr, new_addr));
+        }
+
         return new_addr;
     }
 
@@ -1642,6 +2823,11 @@ addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
 
         page_crossing = is_page_crossing(addr, new_addr);
 
+        if (page_crossing)
+        {
+            dummy_read(get_unfixed_addr(addr, new_addr));
+        }
+
         return new_addr;
     }
 
@@ -1649,8 +2835,10 @@ addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
     {
         const byte_t addr = decode();
 
-        const byte_t lo = read((addr + x()) & 0xff);
-        const byte_t hi = read((addr + x() + 1) & 0xff);
+        dummy_read(addr);
+
+        const byte_t lo = read_ram((addr + x()) & 0xff);
+        const byte_t hi = read_ram((addr + x() + 1) & 0xff);
 
         return static_cast<addr_t>(lo) + static_cast<addr_t>(static_cast<addr_t>(hi) << 8);
     }
@@ -1659,23 +2847,54 @@ addr_t cpu<BusT>::decode_operand_addr(bool& page_crossing [[maybe_unused]])
     {
         const byte_t addr_arg = decode();
 
-        const byte_t lo = read(addr_arg);
-        const byte_t hi = read((addr_arg + 1) & 0xFF);
+        const byte_t lo = read_ram(addr_arg);
+        const byte_t hi = read_ram((addr_arg + 1) & 0xFF);
 
         const addr_t addr = static_cast<addr_t>(lo) + static_cast<addr_t>(static_cast<addr_t>(hi) << 8) ;
         const addr_t new_addr = addr + y();
 
         page_crossing = is_page_crossing(addr, new_addr);
 
+        if (page_crossing)
+        {
+            dummy_read(get_unfixed_addr(addr, new_addr));
+        }
+
         return new_addr;
     }
 
     NESE_ASSUME(false);
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+word_t cpu<BusT, PolicyT>::decode_write_operand()
+{
+    bool page_crossing{false};
+    return decode_write_operand<AddrModeT>(page_crossing);
+}
+
+template<typename BusT, typename PolicyT>
+template<cpu_addr_mode AddrModeT>
+word_t cpu<BusT, PolicyT>::decode_write_operand(bool& page_crossing)
+{
+    const word_t operand = decode_operand<AddrModeT>(page_crossing);
+
+    // Without a page crossing the address was already right, it is read anyway
+    if constexpr (AddrModeT == cpu_addr_mode::absolute_x || AddrModeT == cpu_addr_mode::absolute_y || AddrModeT == cpu_addr_mode::indirect_indexed)
+    {
+        if (!page_crossing)
+        {
+            dummy_read(operand);
+        }
+    }
+
+    return operand;
+}
+
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-byte_t cpu<BusT>::read_operand(word_t operand)
+byte_t cpu<BusT, PolicyT>::read_operand(word_t operand)
 {
     if constexpr (AddrModeT == cpu_addr_mode::accumulator)
     {
@@ -1687,82 +2906,42 @@ byte_t cpu<BusT>::read_operand(word_t operand)
         return static_cast<byte_t>(operand);
     }
 
+    if constexpr (is_zero_page(AddrModeT))
+    {
+        return read_ram(operand);
+    }
+
     return read(operand);
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-void cpu<BusT>::write_operand(word_t operand, byte_t value)
+void cpu<BusT, PolicyT>::write_operand(word_t operand, byte_t value)
 {
     if constexpr (AddrModeT == cpu_addr_mode::accumulator)
     {
         a() = value;
     }
+    else if constexpr (is_zero_page(AddrModeT))
+    {
+        write_ram(operand, value);
+    }
     else
     {
         write(operand, value);
     }
 }
 
-template<typename BusT>
+template<typename BusT, typename PolicyT>
 template<cpu_addr_mode AddrModeT>
-constexpr cpu_cycle_t cpu<BusT>::get_addr_mode_cycle_cost(bool page_crossing)
+void cpu<BusT, PolicyT>::write_modified_operand(word_t operand, byte_t value [[maybe_unused]], byte_t new_value)
 {
-    switch (AddrModeT)
+    if constexpr (PolicyT::cycle_accurate && AddrModeT != cpu_addr_mode::accumulator)
     {
-    case cpu_addr_mode::accumulator:
-    case cpu_addr_mode::immediate:
-        return cpu_cycle_t(2);
-
-    case cpu_addr_mode::zero_page:
-        return cpu_cycle_t(3);
-
-    case cpu_addr_mode::zero_page_x:
-    case cpu_addr_mode::zero_page_y:
-    case cpu_addr_mode::absolute:
-        return cpu_cycle_t(4);
-
-    case cpu_addr_mode::absolute_x:
-    case cpu_addr_mode::absolute_y:
-        return cpu_cycle_t(page_crossing ? 5 : 4);
-
-    case cpu_addr_mode::indexed_indirect:
-        return cpu_cycle_t(6);
-
-    case cpu_addr_mode::indirect_indexed:
-        return cpu_cycle_t(page_crossing ? 6 : 5);
-
-    default:
-        NESE_ASSERT(false);
-        return cpu_cycle_t(0);
+        write_operand<AddrModeT>(operand, value);
     }
-}
-
-template<typename BusT>
-template<cpu_addr_mode AddrModeT>
-constexpr cpu_cycle_t cpu<BusT>::get_shift_cycle_cost()
-{
-    switch (AddrModeT)
-    {
-    case cpu_addr_mode::accumulator:
-        return cpu_cycle_t(2);
-
-    case cpu_addr_mode::zero_page:
-        return cpu_cycle_t(5);
 
-    case cpu_addr_mode::zero_page_x:
-        return cpu_cycle_t(6);
-
-    case cpu_addr_mode::absolute:
-        return cpu_cycle_t(6);
-
-    case cpu_addr_mode::absolute_x:
-        return cpu_cycle_t(7);
-
-    default:
-        NESE_ASSERT(false);
-        return cpu_cycle_t(0);
-    }
+    write_operand<AddrModeT>(operand, new_value);
 }
 
-} // namespace nese
\ No newline at end of file
+} // namespace nese
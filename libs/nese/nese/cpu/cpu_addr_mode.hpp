@@ -43,4 +43,39 @@ constexpr auto format_as(cpu_addr_mode status)
     return magic_enum::enum_name(status);
 }
 
+// Number of operand bytes following the opcode
+constexpr byte_t get_operand_size(cpu_addr_mode addr_mode)
+{
+    switch (addr_mode)
+    {
+    case cpu_addr_mode::implied:
+    case cpu_addr_mode::accumulator:
+    case cpu_addr_mode::count:
+        return 0;
+
+    case cpu_addr_mode::immediate:
+    case cpu_addr_mode::zero_page:
+    case cpu_addr_mode::zero_page_x:
+    case cpu_addr_mode::zero_page_y:
+    case cpu_addr_mode::relative:
+    case cpu_addr_mode::indexed_indirect:
+    case cpu_addr_mode::indirect_indexed:
+        return 1;
+
+    case cpu_addr_mode::absolute:
+    case cpu_addr_mode::absolute_x:
+    case cpu_addr_mode::absolute_y:
+    case cpu_addr_mode::indirect:
+        return 2;
+    }
+
+    return 0;
+}
+
+// The operand address is in the zero page, the internal RAM
+constexpr bool is_zero_page(cpu_addr_mode addr_mode)
+{
+    return addr_mode == cpu_addr_mode::zero_page || addr_mode == cpu_addr_mode::zero_page_x || addr_mode == cpu_addr_mode::zero_page_y;
+}
+
 } // namespace nese
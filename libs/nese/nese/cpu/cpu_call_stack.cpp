@@ -0,0 +1,133 @@
+#include <nese/cpu/cpu_call_stack.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+
+namespace nese {
+
+void cpu_call_stack::reset(cpu_cycle_t cycle)
+{
+    _frames.clear();
+    _node = 0;
+    _last_cycle = cycle;
+}
+
+void cpu_call_stack::clear()
+{
+    _nodes = {node{}};
+    _children.clear();
+    _frames.clear();
+    _node = 0;
+}
+
+u32_t cpu_call_stack::get_child(u32_t parent, addr_t addr)
+{
+    const u64_t key = (u64_t{parent} << 16) | addr;
+
+    if (const auto it = _children.find(key); it != _children.end())
+    {
+        return it->second;
+    }
+
+    const auto child = static_cast<u32_t>(_nodes.size());
+
+    _nodes.push_back({addr, parent, 0, 0});
+    _children.emplace(key, child);
+
+    return child;
+}
+
+std::vector<cpu_call_stack::routine> cpu_call_stack::get_routines() const
+{
+    // Children are always after their parent, a reverse pass sums every subtree
+    std::vector<u64_t> subtree_cycles(_nodes.size());
+
+    for (size_t i = _nodes.size(); i-- > 0;)
+    {
+        subtree_cycles[i] += _nodes[i].cycles;
+
+        if (i != 0)
+        {
+            subtree_cycles[_nodes[i].parent] += subtree_cycles[i];
+        }
+    }
+
+    const auto is_recursive = [this](size_t index) {
+        for (u32_t parent = _nodes[index].parent; parent != 0; parent = _nodes[parent].parent)
+        {
+            if (_nodes[parent].addr == _nodes[index].addr)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    std::unordered_map<addr_t, routine> routines;
+
+    for (size_t i = 1; i < _nodes.size(); ++i)
+    {
+        routine& entry = routines[_nodes[i].addr];
+
+        entry.addr = _nodes[i].addr;
+        entry.calls += _nodes[i].calls;
+        entry.exclusive_cycles += _nodes[i].cycles;
+
+        if (!is_recursive(i))
+        {
+            entry.inclusive_cycles += subtree_cycles[i];
+        }
+    }
+
+    std::vector<routine> result;
+    result.reserve(routines.size());
+
+    for (const auto& [addr, entry] : routines)
+    {
+        result.push_back(entry);
+    }
+
+    std::sort(result.begin(), result.end(), [](const routine& lhs, const routine& rhs) {
+        return lhs.inclusive_cycles != rhs.inclusive_cycles ? lhs.inclusive_cycles > rhs.inclusive_cycles : lhs.addr < rhs.addr;
+    });
+
+    return result;
+}
+
+string cpu_call_stack::to_collapsed() const
+{
+    std::vector<string> lines;
+
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        if (_nodes[i].cycles == 0)
+        {
+            continue;
+        }
+
+        string path;
+
+        for (u32_t index = static_cast<u32_t>(i); index != 0; index = _nodes[index].parent)
+        {
+            path.insert(0, fmt::format(";${:04X}", _nodes[index].addr));
+        }
+
+        lines.push_back(fmt::format("root{} {}\n", path, _nodes[i].cycles));
+    }
+
+    std::sort(lines.begin(), lines.end());
+
+    string out;
+
+    for (const string& line : lines)
+    {
+        out += line;
+    }
+
+    return out;
+}
+
+} // namespace nese
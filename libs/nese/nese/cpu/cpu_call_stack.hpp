@@ -0,0 +1,122 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+// Shadow of the 6502 call stack, the cycles are attributed to the routine running and to the routines that called it
+// A routine is entered by JSR or an interrupt and left once the stack pointer moved above its return address
+// Resyncing on the stack pointer follows the usual tricks, an RTS jump table stays in its routine and PLA PLA leaves it
+class cpu_call_stack
+{
+public:
+    struct routine
+    {
+        addr_t addr{0};
+        u64_t calls{0};
+
+        // Recursive calls are only counted once
+        u64_t inclusive_cycles{0};
+        u64_t exclusive_cycles{0};
+    };
+
+public:
+    // Attribute the cycles since the last update to the routine running
+    void update(cpu_cycle_t cycle);
+
+    // A JSR or an interrupt entered the routine at addr after pushing pushed_size bytes, the return address last
+    void enter(addr_t addr, byte_t sp, byte_t pushed_size);
+
+    // Leave the routines whose return address was pulled
+    void sync_sp(byte_t sp);
+
+    // Leave every routine, the cycles attributed so far are kept
+    void reset(cpu_cycle_t cycle);
+    void clear();
+
+    // Routines entered and not left yet, depth 0 is the outermost
+    [[nodiscard]] size_t get_depth() const;
+    [[nodiscard]] addr_t get_routine(size_t depth) const;
+
+    // Every routine called, most inclusive cycles first
+    [[nodiscard]] std::vector<routine> get_routines() const;
+
+    // The collapsed stacks of flame graph tools, one "root;$C000;$C123 cycles" line per call path with exclusive cycles
+    [[nodiscard]] string to_collapsed() const;
+
+private:
+    // Call tree, node 0 is the code running outside any routine
+    struct node
+    {
+        addr_t addr{0};
+        u32_t parent{0};
+        u64_t calls{0};
+        u64_t cycles{0};
+    };
+
+    struct frame
+    {
+        u32_t node{0};
+
+        // Stack pointer after the call pushed, the frame is left once pushed_size bytes above it are pulled
+        byte_t entry_sp{0};
+        byte_t pushed_size{0};
+    };
+
+    // The stack wraps in its page, moving up by less than half of it pulls and further is the routine pushing below its entry
+    static constexpr byte_t pull_window{0x80};
+
+    [[nodiscard]] u32_t get_child(u32_t parent, addr_t addr);
+
+private:
+    std::vector<node> _nodes{node{}};
+    std::unordered_map<u64_t, u32_t> _children;
+
+    std::vector<frame> _frames;
+    u32_t _node{0};
+
+    cpu_cycle_t _last_cycle{0};
+};
+
+inline void cpu_call_stack::update(cpu_cycle_t cycle)
+{
+    _nodes[_node].cycles += static_cast<u64_t>((cycle - _last_cycle).count());
+    _last_cycle = cycle;
+}
+
+inline void cpu_call_stack::enter(addr_t addr, byte_t sp, byte_t pushed_size)
+{
+    _node = get_child(_node, addr);
+    ++_nodes[_node].calls;
+
+    _frames.push_back({_node, sp, pushed_size});
+}
+
+inline void cpu_call_stack::sync_sp(byte_t sp)
+{
+    const auto is_pulled = [sp](const frame& frame) {
+        const byte_t pulled_size = static_cast<byte_t>(sp - frame.entry_sp);
+        return pulled_size >= frame.pushed_size && pulled_size < pull_window;
+    };
+
+    while (!_frames.empty() && is_pulled(_frames.back())) [[unlikely]]
+    {
+        _frames.pop_back();
+        _node = _nodes[_node].parent;
+    }
+}
+
+inline size_t cpu_call_stack::get_depth() const
+{
+    return _frames.size();
+}
+
+inline addr_t cpu_call_stack::get_routine(size_t depth) const
+{
+    return _nodes[_frames[depth].node].addr;
+}
+
+} // namespace nese
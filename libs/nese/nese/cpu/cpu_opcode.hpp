@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include <nese/basic_types.hpp>
 #include <nese/cpu/cpu_addr_mode.hpp>
 #include <nese/cpu/cpu_opcode_enum.hpp>
@@ -118,8 +120,188 @@ public:
     }
 };
 
+class cpu_opcode_is_control_flow_table : public cpu_opcode_table<bool>
+{
+public:
+    static consteval cpu_opcode_is_control_flow_table create()
+    {
+        cpu_opcode_is_control_flow_table table;
+
+        for (size_t i = 0; i < table._data.size(); ++i)
+        {
+            const string_view name = magic_enum::enum_name(static_cast<cpu_opcode>(i));
+
+            const string_view mnemonic = name.substr(0, name.find_first_of('_'));
+
+            // A jam stops the cpu, treat it as leaving the straight-line code
+            table._data[i] = name.contains("relative") || mnemonic == "brk" || mnemonic == "jam" || mnemonic == "jmp" || mnemonic == "jsr" || mnemonic == "rti" || mnemonic == "rts";
+        }
+
+        return table;
+    }
+};
+
+class cpu_opcode_is_side_effect_free_table : public cpu_opcode_table<bool>
+{
+public:
+    static consteval cpu_opcode_is_side_effect_free_table create()
+    {
+        cpu_opcode_is_side_effect_free_table table;
+
+        constexpr array<string_view, 28> mnemonics{"adc", "and", "bit", "clc", "cld", "clv", "cmp", "cpx", "cpy", "dex", "dey", "eor", "inx", "iny",
+                                                   "lax", "lda", "ldx", "ldy", "nop", "ora", "sbc", "sec", "sed", "tax", "tay", "tsx", "txa", "tya"};
+
+        for (size_t i = 0; i < table._data.size(); ++i)
+        {
+            const string_view name = magic_enum::enum_name(static_cast<cpu_opcode>(i));
+
+            // The address read through a zero page pointer isn't known before executing
+            if (name.empty() || name.contains("indirect"))
+            {
+                continue;
+            }
+
+            const string_view mnemonic = name.substr(0, name.find_first_of('_'));
+
+            table._data[i] = std::find(mnemonics.begin(), mnemonics.end(), mnemonic) != mnemonics.end();
+        }
+
+        return table;
+    }
+};
+
+struct cpu_opcode_cycle
+{
+    // Cycles of the instruction without a page crossing nor a taken branch
+    u8_t base{0};
+
+    // One more cycle when the indexed address crosses a page, only reads pay it
+    bool page_crossing{false};
+};
+
+class cpu_opcode_cycle_table : public cpu_opcode_table<cpu_opcode_cycle>
+{
+public:
+    static consteval cpu_opcode_cycle_table create()
+    {
+        cpu_opcode_cycle_table table;
+
+        for (size_t i = 0; i < table._data.size(); ++i)
+        {
+            const string_view name = magic_enum::enum_name(static_cast<cpu_opcode>(i));
+
+            if (name.empty())
+            {
+                continue;
+            }
+
+            const string_view mnemonic = name.substr(0, name.find_first_of('_'));
+
+            table._data[i] = get_cycle(mnemonic, cpu_opcode_addr_mode_table::create()[i]);
+        }
+
+        return table;
+    }
+
+private:
+    static consteval cpu_opcode_cycle get_cycle(string_view mnemonic, cpu_addr_mode addr_mode)
+    {
+        // clang-format off
+        if (mnemonic == "brk") return {7};
+        if (mnemonic == "jmp") return {addr_mode == cpu_addr_mode::indirect ? u8_t{5} : u8_t{3}};
+        if (mnemonic == "jsr" || mnemonic == "rti" || mnemonic == "rts") return {6};
+        if (mnemonic == "pha" || mnemonic == "php") return {3};
+        if (mnemonic == "pla" || mnemonic == "plp") return {4};
+        // clang-format on
+
+        // Branches pay the taken and page crossing cycles on their own
+        if (addr_mode == cpu_addr_mode::implied || addr_mode == cpu_addr_mode::accumulator || addr_mode == cpu_addr_mode::immediate || addr_mode == cpu_addr_mode::relative)
+        {
+            return {2};
+        }
+
+        // Read-modify-write, the indexed address is always fixed up before the write
+        if (mnemonic == "asl" || mnemonic == "lsr" || mnemonic == "rol" || mnemonic == "ror" || mnemonic == "inc" || mnemonic == "dec" ||
+            mnemonic == "dcp" || mnemonic == "isb" || mnemonic == "rla" || mnemonic == "rra" || mnemonic == "slo" || mnemonic == "sre")
+        {
+            switch (addr_mode)
+            {
+            case cpu_addr_mode::zero_page: return {5};
+            case cpu_addr_mode::zero_page_x:
+            case cpu_addr_mode::absolute: return {6};
+            case cpu_addr_mode::absolute_x:
+            case cpu_addr_mode::absolute_y: return {7};
+            default: return {8};
+            }
+        }
+
+        const bool is_store = mnemonic == "sta" || mnemonic == "stx" || mnemonic == "sty" || mnemonic == "sax" || mnemonic == "ahx" || mnemonic == "shx" || mnemonic == "shy" || mnemonic == "tas";
+
+        switch (addr_mode)
+        {
+        case cpu_addr_mode::zero_page: return {3};
+        case cpu_addr_mode::zero_page_x:
+        case cpu_addr_mode::zero_page_y:
+        case cpu_addr_mode::absolute: return {4};
+        case cpu_addr_mode::absolute_x:
+        case cpu_addr_mode::absolute_y: return is_store ? cpu_opcode_cycle{5} : cpu_opcode_cycle{4, true};
+        case cpu_addr_mode::indexed_indirect: return {6};
+        case cpu_addr_mode::indirect_indexed: return is_store ? cpu_opcode_cycle{6} : cpu_opcode_cycle{5, true};
+        default: return {};
+        }
+    }
+};
+
 static inline constexpr cpu_opcode_mnemonic_table cpu_opcode_mnemonics{cpu_opcode_mnemonic_table::create()};
 static inline constexpr cpu_opcode_addr_mode_table cpu_opcode_addr_modes{cpu_opcode_addr_mode_table::create()};
 static inline constexpr cpu_opcode_is_official_table cpu_opcode_is_officials{cpu_opcode_is_official_table::create()};
+static inline constexpr cpu_opcode_is_control_flow_table cpu_opcode_is_control_flows{cpu_opcode_is_control_flow_table::create()};
+
+static inline constexpr cpu_opcode_cycle_table cpu_opcode_cycles{cpu_opcode_cycle_table::create()};
+
+// Only reads memory and changes registers, never writes memory nor touches the stack
+static inline constexpr cpu_opcode_is_side_effect_free_table cpu_opcode_is_side_effect_frees{cpu_opcode_is_side_effect_free_table::create()};
+
+// Consecutive instructions a predecoded block runs through a single handler, see cpu_policy::fusion
+struct cpu_fused_pair
+{
+    cpu_opcode first;
+    cpu_opcode second;
+};
+
+// Picked from the pair histogram of the cpu benchmark workloads, see cpu_pair_histogram
+static inline constexpr array<cpu_fused_pair, 9> cpu_fused_pairs{{
+    {cpu_opcode::dex_implied, cpu_opcode::bne_relative},
+    {cpu_opcode::dey_implied, cpu_opcode::bne_relative},
+    {cpu_opcode::inx_implied, cpu_opcode::bne_relative},
+    {cpu_opcode::iny_implied, cpu_opcode::bne_relative},
+    {cpu_opcode::cmp_immediate, cpu_opcode::bne_relative},
+    {cpu_opcode::cmp_immediate, cpu_opcode::beq_relative},
+    {cpu_opcode::inc_zero_page, cpu_opcode::bne_relative},
+    {cpu_opcode::dec_zero_page, cpu_opcode::bne_relative},
+    {cpu_opcode::lda_zero_page, cpu_opcode::sta_absolute},
+}};
+
+// The first instruction has a fixed cost and only touches registers and RAM, nothing can stop the block between the two
+static_assert(std::ranges::all_of(cpu_fused_pairs, [](const cpu_fused_pair& pair) {
+    const cpu_addr_mode addr_mode = cpu_opcode_addr_modes[pair.first];
+
+    return !cpu_opcode_is_control_flows[pair.first] && !cpu_opcode_cycles[pair.first].page_crossing &&
+           (addr_mode == cpu_addr_mode::implied || addr_mode == cpu_addr_mode::immediate || addr_mode == cpu_addr_mode::zero_page);
+}));
+
+// Index in cpu_fused_pairs plus one, 0 when the pair isn't fused
+[[nodiscard]] constexpr byte_t get_fused_pair(byte_t first, byte_t second)
+{
+    for (size_t i = 0; i < cpu_fused_pairs.size(); ++i)
+    {
+        if (static_cast<byte_t>(cpu_fused_pairs[i].first) == first && static_cast<byte_t>(cpu_fused_pairs[i].second) == second)
+        {
+            return static_cast<byte_t>(i + 1);
+        }
+    }
+
+    return 0;
+}
 
 } // namespace nese
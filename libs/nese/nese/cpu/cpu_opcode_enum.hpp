@@ -2,10 +2,6 @@
 
 #include <magic_enum.hpp>
 
-#ifndef NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
-#define NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED 1
-#endif
-
 namespace nese {
 
 enum class cpu_opcode
@@ -192,7 +188,19 @@ enum class cpu_opcode
     txs_implied = 0x9A,
     tya_implied = 0x98,
 
-#if NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+    // Every opcode below is unofficial, the 256 values are all named
+    ahx_absolute_y_unofficial = 0x9F,
+    ahx_indirect_indexed_unofficial = 0x93,
+
+    alr_immediate_unofficial = 0x4B,
+
+    anc_immediate_unofficial_0B = 0x0B,
+    anc_immediate_unofficial_2B = 0x2B,
+
+    arr_immediate_unofficial = 0x6B,
+
+    axs_immediate_unofficial = 0xCB,
+
     dcp_zero_page_unofficial = 0xC7,
     dcp_zero_page_x_unofficial = 0xD7,
     dcp_absolute_unofficial = 0xCF,
@@ -210,6 +218,22 @@ enum class cpu_opcode
     isb_indexed_indirect_unofficial = 0xE3,
     isb_indirect_indexed_unofficial = 0xF3,
 
+    // kil == jam, halts the cpu until a reset
+    jam_implied_unofficial_02 = 0x02,
+    jam_implied_unofficial_12 = 0x12,
+    jam_implied_unofficial_22 = 0x22,
+    jam_implied_unofficial_32 = 0x32,
+    jam_implied_unofficial_42 = 0x42,
+    jam_implied_unofficial_52 = 0x52,
+    jam_implied_unofficial_62 = 0x62,
+    jam_implied_unofficial_72 = 0x72,
+    jam_implied_unofficial_92 = 0x92,
+    jam_implied_unofficial_B2 = 0xB2,
+    jam_implied_unofficial_D2 = 0xD2,
+    jam_implied_unofficial_F2 = 0xF2,
+
+    las_absolute_y_unofficial = 0xBB,
+
     lax_zero_page_unofficial = 0xA7,
     lax_zero_page_y_unofficial = 0xB7,
     lax_absolute_unofficial = 0xAF,
@@ -217,7 +241,14 @@ enum class cpu_opcode
     lax_indexed_indirect_unofficial = 0xA3,
     lax_indirect_indexed_unofficial = 0xB3,
 
+    // Unstable, see cpu::unstable_magic
+    lxa_immediate_unofficial = 0xAB,
+
     nop_immediate_unofficial_80 = 0x80,
+    nop_immediate_unofficial_82 = 0x82,
+    nop_immediate_unofficial_89 = 0x89,
+    nop_immediate_unofficial_C2 = 0xC2,
+    nop_immediate_unofficial_E2 = 0xE2,
     nop_implied_unofficial_1A = 0x1A,
     nop_implied_unofficial_3A = 0x3A,
     nop_implied_unofficial_5A = 0x5A,
@@ -264,6 +295,10 @@ enum class cpu_opcode
 
     sbc_immediate_unofficial = 0xEB,
 
+    // The stored value is ANDed with the high byte of the address + 1, the high byte is replaced by the value on a page crossing
+    shx_absolute_y_unofficial = 0x9E,
+    shy_absolute_x_unofficial = 0x9C,
+
     slo_zero_page_unofficial = 0x07,
     slo_zero_page_x_unofficial = 0x17,
     slo_absolute_unofficial = 0x0F,
@@ -280,7 +315,10 @@ enum class cpu_opcode
     sre_indexed_indirect_unofficial = 0x43,
     sre_indirect_indexed_unofficial = 0x53,
 
-#endif // NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+    tas_absolute_y_unofficial = 0x9B,
+
+    // Unstable, see cpu::unstable_magic
+    xaa_immediate_unofficial = 0x8B,
 };
 
 constexpr auto format_as(cpu_opcode opcode)
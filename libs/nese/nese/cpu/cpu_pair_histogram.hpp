@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+// Count of every pair of consecutive opcodes executed, the data behind cpu_fused_pairs
+class cpu_pair_histogram
+{
+public:
+    struct entry
+    {
+        byte_t first{0};
+        byte_t second{0};
+        u64_t count{0};
+    };
+
+public:
+    void record(byte_t opcode);
+    void clear();
+
+    [[nodiscard]] u64_t get_count(byte_t first, byte_t second) const;
+
+    // The most frequent pairs, most frequent first
+    [[nodiscard]] std::vector<entry> get_most_frequent(size_t max_count) const;
+
+private:
+    [[nodiscard]] static size_t to_index(byte_t first, byte_t second) { return (size_t{first} << 8) | second; }
+
+private:
+    // On the heap, the cpu is often a member of a bus on the stack
+    std::vector<u64_t> _counts = std::vector<u64_t>(0x10000);
+
+    byte_t _previous_opcode{0};
+    bool _has_previous_opcode{false};
+};
+
+inline void cpu_pair_histogram::record(byte_t opcode)
+{
+    if (_has_previous_opcode)
+    {
+        ++_counts[to_index(_previous_opcode, opcode)];
+    }
+
+    _previous_opcode = opcode;
+    _has_previous_opcode = true;
+}
+
+inline void cpu_pair_histogram::clear()
+{
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _has_previous_opcode = false;
+}
+
+inline u64_t cpu_pair_histogram::get_count(byte_t first, byte_t second) const
+{
+    return _counts[to_index(first, second)];
+}
+
+inline std::vector<cpu_pair_histogram::entry> cpu_pair_histogram::get_most_frequent(size_t max_count) const
+{
+    std::vector<entry> entries;
+
+    for (size_t i = 0; i < _counts.size(); ++i)
+    {
+        if (_counts[i] != 0)
+        {
+            entries.push_back({static_cast<byte_t>(i >> 8), static_cast<byte_t>(i & 0xFF), _counts[i]});
+        }
+    }
+
+    const size_t count = std::min(max_count, entries.size());
+
+    std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(count), entries.end(), [](const entry& lhs, const entry& rhs) { return lhs.count > rhs.count; });
+    entries.resize(count);
+
+    return entries;
+}
+
+} // namespace nese
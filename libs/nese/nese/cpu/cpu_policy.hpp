@@ -0,0 +1,92 @@
+#pragma once
+
+#include <nese/basic_types.hpp>
+
+#ifndef NESE_CPU_SWITCH_DISPATCH_ENABLED
+#define NESE_CPU_SWITCH_DISPATCH_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_LAZY_FLAGS_ENABLED
+#define NESE_CPU_LAZY_FLAGS_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_PREDECODE_ENABLED
+#define NESE_CPU_PREDECODE_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_BLOCK_CACHE_ENABLED
+#define NESE_CPU_BLOCK_CACHE_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_IDLE_LOOP_SKIP_ENABLED
+#define NESE_CPU_IDLE_LOOP_SKIP_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_FUSION_ENABLED
+#define NESE_CPU_FUSION_ENABLED 1
+#endif
+
+#ifndef NESE_CPU_PROFILING_ENABLED
+#define NESE_CPU_PROFILING_ENABLED 0
+#endif
+
+#ifndef NESE_CPU_CALL_STACK_ENABLED
+#define NESE_CPU_CALL_STACK_ENABLED 0
+#endif
+
+#ifndef NESE_CPU_CYCLE_ACCURATE_ENABLED
+#define NESE_CPU_CYCLE_ACCURATE_ENABLED 0
+#endif
+
+namespace nese {
+
+enum class cpu_dispatch : u8_t
+{
+    table,      // Indirect call through the instruction callback table
+    switch_case // Switch on the opcode, every case calls its instruction directly
+};
+
+// Compile-time configuration of a cpu instantiation
+// Derive from it and override the members to select another configuration
+struct cpu_policy
+{
+    static constexpr cpu_dispatch dispatch = NESE_CPU_SWITCH_DISPATCH_ENABLED ? cpu_dispatch::switch_case : cpu_dispatch::table;
+
+    // Keep the last result and build the zero and negative flags only when the status is observed
+    static constexpr bool lazy_flags = NESE_CPU_LAZY_FLAGS_ENABLED;
+
+    // Cache decoded instructions of $8000-$FFFF, the bus must be read-only there and report bank switches with invalidate_predecode
+    static constexpr bool predecode = false;
+
+    // Run straight-line blocks of predecoded instructions without looking each one up, requires predecode
+    static constexpr bool block_cache = false;
+
+    // Jump to to_cycle from a block looping on itself with only reads and the same registers every iteration, requires block_cache
+    // Only done without a stop predicate, memory read by the loop must only change on a scheduled event
+    static constexpr bool idle_loop_skip = false;
+
+    // Run the instruction pairs of cpu_fused_pairs through a single handler inside blocks, requires block_cache
+    // Only done without a stop predicate, the predicate would not see the second instruction
+    static constexpr bool fusion = false;
+
+    // Count every pair of consecutive opcodes, see cpu::get_pair_histogram
+    static constexpr bool pair_profiling = false;
+
+    // Count executions, cycles and page crossings per opcode, see cpu::get_profile
+    static constexpr bool profiling = false;
+
+    // Track the routines entered by JSR and interrupts and attribute the cycles to them, see cpu::get_call_stack
+    static constexpr bool call_stack = false;
+
+    // Issue every bus access of an instruction at its own cycle, dummy reads and the double write of read-modify-write included
+    // Slower, for the games relying on mid-instruction timing, can't be combined with predecode which skips the fetches
+    static constexpr bool cycle_accurate = false;
+};
+
+// The exact core, selected for the games needing it while the bulk runs keep the fast one
+struct cycle_accurate_cpu_policy : cpu_policy
+{
+    static constexpr bool cycle_accurate = true;
+};
+
+} // namespace nese
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+struct cpu_predecoded_instruction
+{
+    static constexpr byte_t invalid_operand_size = 0xFF;
+
+    [[nodiscard]] bool is_valid() const { return operand_size != invalid_operand_size; }
+
+    word_t operand{0};
+    byte_t opcode{0};
+    byte_t operand_size{invalid_operand_size};
+
+    // Number of straight-line instructions starting here, 0 when no block was built from this address
+    byte_t block_size{0};
+
+    // The block starting here loops back to itself without side effects, see cpu_policy::idle_loop_skip
+    bool is_idle_loop{false};
+
+    // Runs with the next instruction as a pair, see get_fused_pair
+    byte_t fused_pair{0};
+};
+
+static_assert(sizeof(cpu_predecoded_instruction) == 8);
+
+// Opcode and operand of every instruction decoded from PRG ROM ($8000-$FFFF), keyed by address
+// The ROM only changes on bank switches, the bus invalidates the switched 4K pages
+class cpu_predecode_cache
+{
+public:
+    static constexpr addr_t begin_addr = 0x8000;
+    static constexpr size_t page_size = 0x1000;
+    static constexpr size_t page_count = 8;
+    static constexpr u8_t all_pages = 0xFF;
+
+    static constexpr byte_t max_block_size = 32;
+
+public:
+    [[nodiscard]] static constexpr bool contains(addr_t addr) { return addr >= begin_addr; }
+    [[nodiscard]] static constexpr bool is_same_page(addr_t lhs, addr_t rhs) { return (lhs & ~(page_size - 1)) == (rhs & ~(page_size - 1)); }
+
+    [[nodiscard]] cpu_predecoded_instruction& operator[](addr_t addr);
+    [[nodiscard]] const cpu_predecoded_instruction& operator[](addr_t addr) const;
+
+    // Invalidate the pages set in the mask, bit 0 is $8000-$8FFF
+    void invalidate(u8_t page_mask = all_pages);
+
+    void hit();
+    void miss();
+
+    void block_hit();
+    void block_miss();
+
+    [[nodiscard]] u64_t get_hit_count() const;
+    [[nodiscard]] u64_t get_miss_count() const;
+
+    [[nodiscard]] u64_t get_block_hit_count() const;
+    [[nodiscard]] u64_t get_block_miss_count() const;
+
+private:
+    array<cpu_predecoded_instruction, page_size * page_count> _instructions{};
+
+    u64_t _hit_count{0};
+    u64_t _miss_count{0};
+
+    u64_t _block_hit_count{0};
+    u64_t _block_miss_count{0};
+};
+
+inline cpu_predecoded_instruction& cpu_predecode_cache::operator[](addr_t addr)
+{
+    return _instructions[addr - begin_addr];
+}
+
+inline const cpu_predecoded_instruction& cpu_predecode_cache::operator[](addr_t addr) const
+{
+    return _instructions[addr - begin_addr];
+}
+
+inline void cpu_predecode_cache::invalidate(u8_t page_mask)
+{
+    for (size_t page = 0; page < page_count; ++page)
+    {
+        if ((page_mask & (1 << page)) == 0)
+        {
+            continue;
+        }
+
+        // Instructions of the previous page may have their operand in this one
+        const size_t begin = page == 0 ? 0 : page * page_size - 2;
+        const size_t end = (page + 1) * page_size;
+
+        std::fill(_instructions.begin() + begin, _instructions.begin() + end, cpu_predecoded_instruction{});
+    }
+}
+
+inline void cpu_predecode_cache::hit()
+{
+    ++_hit_count;
+}
+
+inline void cpu_predecode_cache::miss()
+{
+    ++_miss_count;
+}
+
+inline void cpu_predecode_cache::block_hit()
+{
+    ++_block_hit_count;
+}
+
+inline void cpu_predecode_cache::block_miss()
+{
+    ++_block_miss_count;
+}
+
+inline u64_t cpu_predecode_cache::get_hit_count() const
+{
+    return _hit_count;
+}
+
+inline u64_t cpu_predecode_cache::get_miss_count() const
+{
+    return _miss_count;
+}
+
+inline u64_t cpu_predecode_cache::get_block_hit_count() const
+{
+    return _block_hit_count;
+}
+
+inline u64_t cpu_predecode_cache::get_block_miss_count() const
+{
+    return _block_miss_count;
+}
+
+} // namespace nese
@@ -0,0 +1,114 @@
+#include <nese/cpu/cpu_profile.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+#include <magic_enum.hpp>
+
+#include <nese/cpu/cpu_opcode.hpp>
+
+namespace nese {
+
+namespace {
+
+void format_entry(string& out, const cpu_profile::entry& entry)
+{
+    fmt::format_to(std::back_inserter(out), R"("executions": {}, "cycles": {}, "page_crossings": {})", entry.executions, entry.cycles, entry.page_crossings);
+}
+
+} // namespace
+
+void cpu_profile::clear()
+{
+    std::fill(_opcodes.begin(), _opcodes.end(), entry{});
+}
+
+cpu_profile::entry cpu_profile::get_addr_mode(cpu_addr_mode addr_mode) const
+{
+    entry total;
+
+    for (size_t i = 0; i < _opcodes.size(); ++i)
+    {
+        if (cpu_opcode_addr_modes[i] == addr_mode)
+        {
+            total += _opcodes[i];
+        }
+    }
+
+    return total;
+}
+
+cpu_profile::entry cpu_profile::get_total() const
+{
+    entry total;
+
+    for (const entry& opcode : _opcodes)
+    {
+        total += opcode;
+    }
+
+    return total;
+}
+
+string cpu_profile::to_json() const
+{
+    const auto by_cycles = [](const auto& lhs, const auto& rhs) { return lhs.second.cycles > rhs.second.cycles; };
+
+    std::vector<std::pair<size_t, entry>> opcodes;
+
+    for (size_t i = 0; i < _opcodes.size(); ++i)
+    {
+        if (_opcodes[i].executions != 0)
+        {
+            opcodes.emplace_back(i, _opcodes[i]);
+        }
+    }
+
+    std::stable_sort(opcodes.begin(), opcodes.end(), by_cycles);
+
+    std::vector<std::pair<cpu_addr_mode, entry>> addr_modes;
+
+    for (size_t i = 0; i < static_cast<size_t>(cpu_addr_mode::count); ++i)
+    {
+        const auto addr_mode = static_cast<cpu_addr_mode>(i);
+        const entry total = get_addr_mode(addr_mode);
+
+        if (total.executions != 0)
+        {
+            addr_modes.emplace_back(addr_mode, total);
+        }
+    }
+
+    std::stable_sort(addr_modes.begin(), addr_modes.end(), by_cycles);
+
+    string out = "{\n  \"total\": {";
+    format_entry(out, get_total());
+    out += "},\n  \"opcodes\": [";
+
+    for (size_t i = 0; i < opcodes.size(); ++i)
+    {
+        const auto& [opcode, opcode_entry] = opcodes[i];
+
+        fmt::format_to(std::back_inserter(out), R"({}{}    {{"opcode": {}, "mnemonic": "{}", "addr_mode": "{}", )", i == 0 ? "" : ",", '\n', opcode, cpu_opcode_mnemonics[opcode], magic_enum::enum_name(cpu_opcode_addr_modes[opcode]));
+        format_entry(out, opcode_entry);
+        out += '}';
+    }
+
+    out += "\n  ],\n  \"addr_modes\": [";
+
+    for (size_t i = 0; i < addr_modes.size(); ++i)
+    {
+        const auto& [addr_mode, addr_mode_entry] = addr_modes[i];
+
+        fmt::format_to(std::back_inserter(out), R"({}{}    {{"addr_mode": "{}", )", i == 0 ? "" : ",", '\n', magic_enum::enum_name(addr_mode));
+        format_entry(out, addr_mode_entry);
+        out += '}';
+    }
+
+    out += "\n  ]\n}\n";
+
+    return out;
+}
+
+} // namespace nese
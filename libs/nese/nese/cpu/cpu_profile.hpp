@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include <nese/basic_types.hpp>
+#include <nese/cpu/cpu_addr_mode.hpp>
+
+namespace nese {
+
+// Executions, cycles and page crossings of every opcode, the interrupt sequences, DMA stalls and skipped idle loops aren't counted
+class cpu_profile
+{
+public:
+    struct entry
+    {
+        u64_t executions{0};
+        u64_t cycles{0};
+
+        // Extra cycle of an indexed read or a taken branch crossing a page
+        u64_t page_crossings{0};
+
+        entry& operator+=(const entry& other);
+    };
+
+public:
+    void begin(byte_t opcode);
+    void end(cpu_cycle_t cycles);
+    void record_page_crossing();
+
+    void clear();
+
+    [[nodiscard]] const entry& get_opcode(byte_t opcode) const;
+    [[nodiscard]] entry get_addr_mode(cpu_addr_mode addr_mode) const;
+    [[nodiscard]] entry get_total() const;
+
+    // Every executed opcode and addressing mode, most cycles first
+    [[nodiscard]] string to_json() const;
+
+private:
+    // On the heap, the cpu is often a member of a bus on the stack
+    std::vector<entry> _opcodes = std::vector<entry>(256);
+
+    byte_t _opcode{0};
+};
+
+inline cpu_profile::entry& cpu_profile::entry::operator+=(const entry& other)
+{
+    executions += other.executions;
+    cycles += other.cycles;
+    page_crossings += other.page_crossings;
+
+    return *this;
+}
+
+inline void cpu_profile::begin(byte_t opcode)
+{
+    _opcode = opcode;
+    ++_opcodes[opcode].executions;
+}
+
+inline void cpu_profile::end(cpu_cycle_t cycles)
+{
+    _opcodes[_opcode].cycles += static_cast<u64_t>(cycles.count());
+}
+
+inline void cpu_profile::record_page_crossing()
+{
+    ++_opcodes[_opcode].page_crossings;
+}
+
+inline const cpu_profile::entry& cpu_profile::get_opcode(byte_t opcode) const
+{
+    return _opcodes[opcode];
+}
+
+} // namespace nese
@@ -14,6 +14,8 @@ struct cpu_registers
     constexpr void set_status(cpu_status flag);
     constexpr void clear_status(cpu_status flag);
 
+    [[nodiscard]] constexpr bool operator==(const cpu_registers&) const = default;
+
     byte_t a{0};
     byte_t x{0};
     byte_t y{0};
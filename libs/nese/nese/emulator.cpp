@@ -12,6 +12,11 @@ void emulator::power_on()
 
     _state = state::on;
     _cycle = cycle_t{0};
+    _bus.scheduler.reset();
+    _bus.scheduler.schedule(scheduler_event::vblank, ppu_vblank_cycle);
+    _bus.scheduler.schedule(scheduler_event::vblank_end, ppu_vblank_end_cycle);
+    _frame_idle_cycles = cpu_cycle_t{0};
+    _frame_start_idle_cycles = cpu_cycle_t{0};
     _bus.ppu.reset();
     _bus.cpu.reset();
     _bus.ram.fill(0);
@@ -31,7 +36,7 @@ void emulator::load_cartridge(cartridge&& cartridge)
 {
     NESE_TRACE("[emulator] load cartridge {}", cartridge);
 
-    _bus.cartridge = std::move(cartridge);
+    _bus.load_cartridge(std::move(cartridge));
 }
 
 void emulator::reset()
@@ -41,6 +46,12 @@ void emulator::reset()
 
     _state = state::off;
     _cycle = cycle_t{0};
+    _bus.scheduler.reset();
+    _bus.scheduler.schedule(scheduler_event::vblank, ppu_vblank_cycle);
+    _bus.scheduler.schedule(scheduler_event::vblank_end, ppu_vblank_end_cycle);
+    _frame_idle_cycles = cpu_cycle_t{0};
+    _frame_start_idle_cycles = cpu_cycle_t{0};
+    _bus.ppu.reset();
     _bus.cpu.reset();
     _bus.ram.fill(0);
 
@@ -49,27 +60,85 @@ void emulator::reset()
 
 void emulator::update(f32_t dt [[maybe_unused]])
 {
-    if (_state != state::on && _state != state::step && _state != state::step_to)
+    switch (_state)
     {
-        return;
+    case state::on:
+        on_stopped(run_frame());
+        break;
+
+    case state::step:
+        on_stopped(run_until([first = true](const bus&) mutable { return !std::exchange(first, false); }, ppu_frame_cycle));
+        break;
+
+    case state::step_to:
+        on_stopped(run_until([this, first = true](const bus& bus) mutable { return !std::exchange(first, false) && bus.cpu.get_state().registers.pc == _step_to_addr; }, ppu_frame_cycle));
+        break;
+
+    case state::off:
+    case state::pause:
+    case state::error:
+        break;
     }
+}
+
+stop_reason emulator::run_cycles(cycle_t cycles)
+{
+    return run(_cycle + cycles, cpu_no_stop{});
+}
+
+stop_reason emulator::run_frame()
+{
+    const cycle_t frame_end = (_cycle / ppu_frame_cycle + 1) * ppu_frame_cycle;
 
-    ++_cycle;
+    const stop_reason reason = run(frame_end, cpu_no_stop{});
 
-    _bus.ppu.step(_cycle);
+    return reason == stop_reason::cycles_complete ? stop_reason::frame_complete : reason;
+}
 
-    if (_bus.cpu.step(_cycle))
+void emulator::on_stopped(stop_reason reason)
+{
+    switch (reason)
     {
+    case stop_reason::cycles_complete:
+    case stop_reason::frame_complete:
+        break;
+
+    case stop_reason::breakpoint:
         NESE_TRACE("{}", nintendulator::format(_bus));
+        _state = state::pause;
+        break;
 
-        if (_state == state::step || (_state == state::step_to && _step_to_addr == _bus.cpu.get_state().registers.pc))
-        {
-            _state = state::pause;
-        }
+    case stop_reason::jam:
+        NESE_TRACE("{}", nintendulator::format(_bus));
+        _state = state::error;
+        break;
     }
-    else
+}
+
+void emulator::on_event(scheduler_event event)
+{
+    switch (event)
     {
-        _state = state::error;
+    case scheduler_event::vblank:
+        // The ppu caught up first, it raised the NMI itself
+        _frame_idle_cycles = _bus.cpu.get_idle_loop_cycles() - _frame_start_idle_cycles;
+        _frame_start_idle_cycles = _bus.cpu.get_idle_loop_cycles();
+        _bus.scheduler.schedule(scheduler_event::vblank, (_cycle / ppu_frame_cycle + 1) * ppu_frame_cycle + ppu_vblank_cycle);
+        break;
+
+    case scheduler_event::vblank_end:
+        // Only ends the run there, the ppu clears its status flags when it catches up
+        _bus.scheduler.schedule(scheduler_event::vblank_end, (_cycle / ppu_frame_cycle + 1) * ppu_frame_cycle + ppu_vblank_end_cycle);
+        _bus.schedule_sprite_zero_hit();
+        break;
+
+    case scheduler_event::sprite_zero_hit:
+        // The ppu rendered the scanline, the next one is only needed while the flag isn't set
+        _bus.schedule_sprite_zero_hit();
+        break;
+
+    case scheduler_event::count:
+        break;
     }
 }
 
@@ -2,6 +2,10 @@
 
 #include <nese/basic_types.hpp>
 #include <nese/bus.hpp>
+#include <nese/stop_reason.hpp>
+
+#include <algorithm>
+#include <utility>
 
 namespace nese {
 
@@ -35,16 +39,82 @@ public:
     void pause();
     void unpause();
 
+    // Batch runs, the cpu runs uninterrupted up to the next scheduled event and the ppu catches up after each chunk
+    stop_reason run_cycles(cycle_t cycles);
+    stop_reason run_frame();
+
+    // The predicate receives the bus before each instruction, with the ppu caught up to the cpu
+    template<typename PredicateT>
+    stop_reason run_until(PredicateT&& predicate, cycle_t max_cycles = cycle_t::max());
+
     [[nodiscard]] const bus& get_bus() const;
     [[nodiscard]] state get_state() const;
 
+    // Cycles the cpu jumped over in idle loops between the last two vblanks
+    [[nodiscard]] cpu_cycle_t get_frame_idle_cycles() const;
+
+private:
+    template<typename PredicateT>
+    stop_reason run(cycle_t to_cycle, PredicateT&& predicate);
+
+    void on_stopped(stop_reason reason);
+    void on_event(scheduler_event event);
+
 private:
     bus _bus;
     state _state{state::off};
     cycle_t _cycle{0};
     addr_t _step_to_addr{0};
+
+    cpu_cycle_t _frame_idle_cycles{0};
+    cpu_cycle_t _frame_start_idle_cycles{0};
 };
 
+template<typename PredicateT>
+stop_reason emulator::run_until(PredicateT&& predicate, cycle_t max_cycles)
+{
+    const cycle_t to_cycle = max_cycles < cycle_t::max() - _cycle ? _cycle + max_cycles : cycle_t::max();
+
+    return run(to_cycle, [this, &predicate] {
+        _bus.ppu.step(_bus.cpu.get_state().cycle);
+        return predicate(std::as_const(_bus));
+    });
+}
+
+template<typename PredicateT>
+stop_reason emulator::run(cycle_t to_cycle, PredicateT&& predicate)
+{
+    while (_cycle < to_cycle)
+    {
+        const cycle_t chunk_end = std::min(to_cycle, _bus.scheduler.get_next_cycle());
+
+        const stop_reason reason = _bus.cpu.run_until(cycle_cast<cpu_cycle_t>(chunk_end), predicate);
+
+        if (reason == stop_reason::cycles_complete)
+        {
+            _cycle = chunk_end;
+        }
+        else
+        {
+            _cycle = std::max(_cycle, cycle_t{_bus.cpu.get_state().cycle});
+        }
+
+        _bus.ppu.step(cycle_cast<ppu_cycle_t>(_cycle));
+
+        while (const std::optional<scheduler_event> event = _bus.scheduler.pop(_cycle))
+        {
+            on_event(*event);
+        }
+
+        if (reason != stop_reason::cycles_complete)
+        {
+            return reason;
+        }
+    }
+
+    return stop_reason::cycles_complete;
+}
+
 inline const bus& emulator::get_bus() const
 {
     return _bus;
@@ -55,4 +125,9 @@ inline emulator::state emulator::get_state() const
     return _state;
 }
 
+inline cpu_cycle_t emulator::get_frame_idle_cycles() const
+{
+    return _frame_idle_cycles;
+}
+
 } // namespace nese
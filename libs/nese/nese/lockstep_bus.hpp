@@ -0,0 +1,388 @@
+#pragma once
+
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include <fmt/format.h>
+#include <magic_enum.hpp>
+
+#include <nese/basic_types.hpp>
+#include <nese/cpu.hpp>
+
+namespace nese {
+
+struct lockstep_write
+{
+    [[nodiscard]] bool operator==(const lockstep_write&) const = default;
+
+    addr_t addr{0};
+    byte_t value{0};
+};
+
+// One side of a lockstep_bus, forwards every access of its cpu to its own BusT and records the writes
+// Without a ram member the zero page and the stack writes go through write and are recorded too
+template<typename BusT, typename PolicyT>
+struct lockstep_cpu_bus
+{
+    explicit lockstep_cpu_bus(BusT& target);
+
+    [[nodiscard]] byte_t read(addr_t addr);
+    [[nodiscard]] word_t read_word(addr_t addr);
+    void write(addr_t addr, byte_t value);
+    void write_word(addr_t addr, word_t value);
+
+    ref_wrap<BusT> bus;
+    std::vector<lockstep_write> writes;
+    cpu<lockstep_cpu_bus, PolicyT> cpu{*this};
+};
+
+// Runs the same program on two cpu instantiations and compares them after each instruction, or after each run of a budget
+// The registers, the cycle and every write must match, consecutive writes to an address count as the last one
+// The first divergence stops it with a trace of the instructions before
+// Both buses must start with the same content, each core only sees its own
+// The interrupt lines are driven through nmi and irq, a write to BusT::oam_dma_addr stalls the core like the bus does for its own cpu
+template<typename BusT, typename PolicyT, typename ReferencePolicyT = cpu_policy>
+class lockstep_bus
+{
+public:
+    static constexpr size_t trace_size = 16;
+
+    struct trace_entry
+    {
+        cpu_state state;
+        byte_t opcode{0};
+        std::vector<lockstep_write> writes;
+    };
+
+public:
+    lockstep_bus(BusT& bus, BusT& reference_bus);
+
+    // Same registers and cycle on both cores
+    void set_state(const cpu_state& state);
+
+    // Execute the next instruction on both cores, false once they diverged
+    // Each core goes through its run loop with a 1 cycle budget, so the dispatch, the predecoded fetch and the blocks of its policy are used
+    bool step();
+
+    // Run both cores for the budget without a stop predicate and compare them at the end, false once they diverged
+    // The fused pairs and the idle loop skip only engage in such runs, both cores stop on the first instruction boundary past the budget
+    // The writes of the whole run are compared, the trace keeps the first instruction of each run
+    bool run(cpu_cycle_t budget);
+
+    // Step until the predicate evaluated before each instruction is true or a JAM opcode halted both cores, false once they diverged
+    template<typename PredicateT>
+    bool run_until(PredicateT&& predicate);
+
+    void nmi(cycle_t cycle);
+    void irq(bool asserted, cycle_t cycle);
+
+    [[nodiscard]] bool has_diverged() const;
+
+    // The differences and the last instructions executed, empty until the cores diverged
+    [[nodiscard]] const string& get_report() const;
+
+    [[nodiscard]] const cpu_state& get_state() const;
+    [[nodiscard]] size_t get_instruction_count() const;
+
+    // The core checked against the reference, its caches and counters show which paths ran
+    [[nodiscard]] const cpu<lockstep_cpu_bus<BusT, PolicyT>, PolicyT>& get_cpu() const;
+
+private:
+    [[nodiscard]] byte_t peek(addr_t addr) const;
+
+    // Trace the instruction about to run and forget the writes of the previous one
+    trace_entry& begin_trace();
+
+    void report_divergence(bool stepped, bool reference_stepped, string_view where);
+
+private:
+    lockstep_cpu_bus<BusT, PolicyT> _core;
+    lockstep_cpu_bus<BusT, ReferencePolicyT> _reference;
+
+    std::deque<trace_entry> _trace;
+    size_t _instruction_count{0};
+
+    string _report;
+};
+
+template<typename BusT, typename PolicyT>
+lockstep_cpu_bus<BusT, PolicyT>::lockstep_cpu_bus(BusT& target)
+    : bus(target)
+{
+}
+
+template<typename BusT, typename PolicyT>
+byte_t lockstep_cpu_bus<BusT, PolicyT>::read(addr_t addr)
+{
+    return bus.get().read(addr);
+}
+
+template<typename BusT, typename PolicyT>
+word_t lockstep_cpu_bus<BusT, PolicyT>::read_word(addr_t addr)
+{
+    return read(addr) + static_cast<word_t>(static_cast<word_t>(read(addr + 1)) << 8);
+}
+
+template<typename BusT, typename PolicyT>
+void lockstep_cpu_bus<BusT, PolicyT>::write(addr_t addr, byte_t value)
+{
+    // The cycle-accurate core writes the unmodified value of a read-modify-write first, only the last one is compared
+    if (!writes.empty() && writes.back().addr == addr)
+    {
+        writes.back().value = value;
+    }
+    else
+    {
+        writes.push_back({addr, value});
+    }
+
+    bus.get().write(addr, value);
+
+    // BusT reports these to its own cpu
+    if constexpr (requires { BusT::oam_dma_addr; })
+    {
+        if (addr == BusT::oam_dma_addr)
+        {
+            cpu.stall_oam_dma();
+        }
+    }
+
+    if constexpr (PolicyT::predecode)
+    {
+        if (cpu_predecode_cache::contains(addr))
+        {
+            cpu.invalidate_predecode();
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void lockstep_cpu_bus<BusT, PolicyT>::write_word(addr_t addr, word_t value)
+{
+    write(addr, static_cast<byte_t>(value & 0xff));
+    write(addr + 1, static_cast<byte_t>(value >> 8));
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+lockstep_bus<BusT, PolicyT, ReferencePolicyT>::lockstep_bus(BusT& bus, BusT& reference_bus)
+    : _core(bus)
+    , _reference(reference_bus)
+{
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+void lockstep_bus<BusT, PolicyT, ReferencePolicyT>::set_state(const cpu_state& state)
+{
+    _core.cpu.get_state() = state;
+    _reference.cpu.get_state() = state;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+bool lockstep_bus<BusT, PolicyT, ReferencePolicyT>::step()
+{
+    if (has_diverged())
+    {
+        return false;
+    }
+
+    trace_entry& entry = begin_trace();
+
+    const bool stepped = _core.cpu.run(cpu_cycle_t(1));
+    const bool reference_stepped = _reference.cpu.run(cpu_cycle_t(1));
+
+    entry.writes = _core.writes;
+    ++_instruction_count;
+
+    report_divergence(stepped, reference_stepped, fmt::format("at instruction {}", _instruction_count));
+
+    return !has_diverged();
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+bool lockstep_bus<BusT, PolicyT, ReferencePolicyT>::run(cpu_cycle_t budget)
+{
+    if (has_diverged())
+    {
+        return false;
+    }
+
+    trace_entry& entry = begin_trace();
+
+    const cpu_cycle_t to_cycle = _core.cpu.get_state().cycle + budget;
+
+    const bool ran = _core.cpu.run_until(to_cycle, cpu_no_stop{}) != stop_reason::jam;
+    const bool reference_ran = _reference.cpu.run_until(to_cycle, cpu_no_stop{}) != stop_reason::jam;
+
+    entry.writes = _core.writes;
+
+    report_divergence(ran, reference_ran, fmt::format("in the run from cycle {}", entry.state.cycle.count()));
+
+    return !has_diverged();
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+template<typename PredicateT>
+bool lockstep_bus<BusT, PolicyT, ReferencePolicyT>::run_until(PredicateT&& predicate)
+{
+    while (!predicate() && !_core.cpu.is_jammed())
+    {
+        if (!step())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+void lockstep_bus<BusT, PolicyT, ReferencePolicyT>::nmi(cycle_t cycle)
+{
+    _core.cpu.nmi(cycle);
+    _reference.cpu.nmi(cycle);
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+void lockstep_bus<BusT, PolicyT, ReferencePolicyT>::irq(bool asserted, cycle_t cycle)
+{
+    _core.cpu.irq(asserted, cycle);
+    _reference.cpu.irq(asserted, cycle);
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+bool lockstep_bus<BusT, PolicyT, ReferencePolicyT>::has_diverged() const
+{
+    return !_report.empty();
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+const string& lockstep_bus<BusT, PolicyT, ReferencePolicyT>::get_report() const
+{
+    return _report;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+const cpu_state& lockstep_bus<BusT, PolicyT, ReferencePolicyT>::get_state() const
+{
+    return _core.cpu.get_state();
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+size_t lockstep_bus<BusT, PolicyT, ReferencePolicyT>::get_instruction_count() const
+{
+    return _instruction_count;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+const cpu<lockstep_cpu_bus<BusT, PolicyT>, PolicyT>& lockstep_bus<BusT, PolicyT, ReferencePolicyT>::get_cpu() const
+{
+    return _core.cpu;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+typename lockstep_bus<BusT, PolicyT, ReferencePolicyT>::trace_entry& lockstep_bus<BusT, PolicyT, ReferencePolicyT>::begin_trace()
+{
+    trace_entry& entry = _trace.emplace_back(_core.cpu.get_state(), peek(_core.cpu.get_state().registers.pc));
+
+    if (_trace.size() > trace_size)
+    {
+        _trace.pop_front();
+    }
+
+    _core.writes.clear();
+    _reference.writes.clear();
+
+    return entry;
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+byte_t lockstep_bus<BusT, PolicyT, ReferencePolicyT>::peek(addr_t addr) const
+{
+    // Only for the trace, without the side effects of a read
+    if constexpr (requires(const BusT& bus) { bus.readonly(addr); })
+    {
+        return _core.bus.get().readonly(addr);
+    }
+    else
+    {
+        return _core.bus.get().read(addr);
+    }
+}
+
+template<typename BusT, typename PolicyT, typename ReferencePolicyT>
+void lockstep_bus<BusT, PolicyT, ReferencePolicyT>::report_divergence(bool stepped, bool reference_stepped, string_view where)
+{
+    const cpu_state& state = _core.cpu.get_state();
+    const cpu_state& reference_state = _reference.cpu.get_state();
+
+    auto out = std::back_inserter(_report);
+
+    const auto compare = [&out](string_view name, auto value, auto reference_value, int width) {
+        if (value != reference_value)
+        {
+            fmt::format_to(out, "  {}: ${:0{}X}, reference ${:0{}X}\n", name, value, width, reference_value, width);
+        }
+    };
+
+    compare("pc", state.registers.pc, reference_state.registers.pc, 4);
+    compare("a", state.registers.a, reference_state.registers.a, 2);
+    compare("x", state.registers.x, reference_state.registers.x, 2);
+    compare("y", state.registers.y, reference_state.registers.y, 2);
+    compare("sp", state.registers.sp, reference_state.registers.sp, 2);
+    compare("status", state.registers.status, reference_state.registers.status, 2);
+
+    if (state.cycle != reference_state.cycle)
+    {
+        fmt::format_to(out, "  cycle: {}, reference {}\n", state.cycle.count(), reference_state.cycle.count());
+    }
+
+    if (stepped != reference_stepped)
+    {
+        fmt::format_to(out, "  jammed: {}, reference {}\n", !stepped, !reference_stepped);
+    }
+
+    const auto format_writes = [](const std::vector<lockstep_write>& writes) {
+        string result;
+
+        for (const lockstep_write& write : writes)
+        {
+            fmt::format_to(std::back_inserter(result), "{}${:04X}=${:02X}", result.empty() ? "" : " ", write.addr, write.value);
+        }
+
+        return result;
+    };
+
+    if (_core.writes != _reference.writes)
+    {
+        fmt::format_to(out, "  writes: [{}], reference [{}]\n", format_writes(_core.writes), format_writes(_reference.writes));
+    }
+
+    if (_report.empty())
+    {
+        return;
+    }
+
+    _report = fmt::format("Diverged {}\n{}Last instructions, oldest first:\n", where, _report);
+
+    for (const trace_entry& entry : _trace)
+    {
+        const cpu_registers& registers = entry.state.registers;
+
+        fmt::format_to(out,
+                       "  {:04X}  {:02X} {} {:<16} A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} CYC:{} [{}]\n",
+                       registers.pc,
+                       entry.opcode,
+                       cpu_opcode_mnemonics[entry.opcode],
+                       magic_enum::enum_name(cpu_opcode_addr_modes[entry.opcode]),
+                       registers.a,
+                       registers.x,
+                       registers.y,
+                       registers.status,
+                       registers.sp,
+                       entry.state.cycle.count(),
+                       format_writes(entry.writes));
+    }
+}
+
+} // namespace nese
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <limits>
+
+namespace nese {
+
+// Count of clock periods lasting TicksT ticks of the master clock
+// Converting to a finer clock only multiplies and is implicit, converting to a coarser one divides and requires cycle_cast
+template<std::int64_t TicksT>
+class basic_cycle
+{
+    static_assert(TicksT > 0);
+
+public:
+    using rep = std::int64_t;
+
+    static constexpr rep ticks = TicksT;
+
+public:
+    constexpr basic_cycle() = default;
+    constexpr explicit basic_cycle(rep count);
+
+    template<rep FromTicksT>
+        requires(FromTicksT % TicksT == 0)
+    constexpr basic_cycle(basic_cycle<FromTicksT> cycle)
+        : _count(cycle.count() * (FromTicksT / TicksT))
+    {
+    }
+
+    [[nodiscard]] static constexpr basic_cycle zero();
+    [[nodiscard]] static constexpr basic_cycle max();
+
+    [[nodiscard]] constexpr rep count() const;
+
+    constexpr basic_cycle& operator++();
+    constexpr basic_cycle operator++(int);
+
+    constexpr basic_cycle& operator+=(basic_cycle rhs);
+    constexpr basic_cycle& operator-=(basic_cycle rhs);
+    constexpr basic_cycle& operator%=(basic_cycle rhs);
+
+    // Hidden friends, mixed clocks convert to the finer one
+    [[nodiscard]] friend constexpr basic_cycle operator+(basic_cycle lhs, basic_cycle rhs) { return lhs += rhs; }
+    [[nodiscard]] friend constexpr basic_cycle operator-(basic_cycle lhs, basic_cycle rhs) { return lhs -= rhs; }
+    [[nodiscard]] friend constexpr basic_cycle operator%(basic_cycle lhs, basic_cycle rhs) { return lhs %= rhs; }
+    [[nodiscard]] friend constexpr rep operator/(basic_cycle lhs, basic_cycle rhs) { return lhs._count / rhs._count; }
+
+    [[nodiscard]] friend constexpr basic_cycle operator*(basic_cycle lhs, rep rhs) { return basic_cycle{lhs._count * rhs}; }
+    [[nodiscard]] friend constexpr basic_cycle operator*(rep lhs, basic_cycle rhs) { return basic_cycle{lhs * rhs._count}; }
+
+    [[nodiscard]] friend constexpr bool operator==(basic_cycle lhs, basic_cycle rhs) = default;
+    [[nodiscard]] friend constexpr auto operator<=>(basic_cycle lhs, basic_cycle rhs) = default;
+
+private:
+    rep _count{0};
+};
+
+// Convert between clocks, truncating toward zero like std::chrono::duration_cast
+template<typename ToT, std::int64_t FromTicksT>
+[[nodiscard]] constexpr ToT cycle_cast(basic_cycle<FromTicksT> cycle)
+{
+    if constexpr (FromTicksT % ToT::ticks == 0)
+    {
+        return ToT{cycle.count() * (FromTicksT / ToT::ticks)};
+    }
+    else if constexpr (ToT::ticks % FromTicksT == 0)
+    {
+        return ToT{cycle.count() / (ToT::ticks / FromTicksT)};
+    }
+    else
+    {
+        return ToT{cycle.count() * FromTicksT / ToT::ticks};
+    }
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT>::basic_cycle(rep count)
+    : _count(count)
+{
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT> basic_cycle<TicksT>::zero()
+{
+    return basic_cycle{0};
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT> basic_cycle<TicksT>::max()
+{
+    return basic_cycle{std::numeric_limits<rep>::max()};
+}
+
+template<std::int64_t TicksT>
+constexpr typename basic_cycle<TicksT>::rep basic_cycle<TicksT>::count() const
+{
+    return _count;
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT>& basic_cycle<TicksT>::operator++()
+{
+    ++_count;
+    return *this;
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT> basic_cycle<TicksT>::operator++(int)
+{
+    const basic_cycle previous = *this;
+    ++_count;
+    return previous;
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT>& basic_cycle<TicksT>::operator+=(basic_cycle rhs)
+{
+    _count += rhs._count;
+    return *this;
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT>& basic_cycle<TicksT>::operator-=(basic_cycle rhs)
+{
+    _count -= rhs._count;
+    return *this;
+}
+
+template<std::int64_t TicksT>
+constexpr basic_cycle<TicksT>& basic_cycle<TicksT>::operator%=(basic_cycle rhs)
+{
+    _count %= rhs._count;
+    return *this;
+}
+
+} // namespace nese
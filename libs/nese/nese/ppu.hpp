@@ -1,6 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <variant>
+
 #include <nese/basic_types.hpp>
+#include <nese/cartridge/cartridge_mapper.hpp>
+#include <nese/ppu/ppu_pipeline.hpp>
+#include <nese/ppu/ppu_policy.hpp>
+#include <nese/ppu/ppu_tile_cache.hpp>
 #include <nese/utility/assert.hpp>
 
 namespace nese {
@@ -10,17 +20,53 @@ inline static constexpr size_t screen_width = 256;
 
 using ppu_frame_buffer = array<u32_t, screen_height * screen_width>;
 
-template<typename BusT>
+template<typename BusT, typename PolicyT = ppu_policy>
 class ppu
 {
 public:
     explicit ppu(BusT& bus);
 
 public:
+    // Jump from one dot with work on it to the next, each visible scanline renders in one pass at its dot 256
+    // The registers written while the ppu is behind apply from the next of these dots
+    // The dot-accurate policy steps every dot of the rendering scanlines instead, the writes apply from the next dot
     void step();
     void step(ppu_cycle_t to_cycle);
     void reset();
 
+    // Next dot the renderer may set the sprite 0 hit flag this frame, the emulator schedules it so idle loops polling $2002 see the flag
+    [[nodiscard]] std::optional<ppu_cycle_t> get_next_sprite_zero_hit_cycle() const;
+
+    // The bus calls it once the CHR seen by the ppu changed under it, a new cartridge or a CHR bank switch
+    void invalidate_chr();
+
+public:
+    // $2000-$2007 seen by the cpu, the bus catches the ppu up to the cpu cycle before each access
+    // Entering vblank or enabling the NMI during vblank with PPUCTRL bit 7 raises the cpu NMI
+    void write_control(byte_t value);
+    void write_mask(byte_t value);
+    [[nodiscard]] byte_t read_status();
+    void write_status(byte_t value);
+    void write_scroll(byte_t value);
+    void write_ppu_addr(byte_t value);
+    [[nodiscard]] byte_t read_ppu_data();
+    void write_ppu_data(byte_t value);
+
+    // Reads without side effects for the debugger
+    [[nodiscard]] byte_t peek_status() const;
+    [[nodiscard]] byte_t peek_ppu_data() const;
+
+    // Value left on the data bus by the last register access, the write only registers read it back
+    [[nodiscard]] byte_t read_open_bus() const;
+
+    // $2003 and $2004, the cpu side of the OAM
+    void write_oam_addr(byte_t value);
+    [[nodiscard]] byte_t read_oam_data() const;
+    void write_oam_data(byte_t value);
+
+    // The 256 bytes of an OAM DMA, written like $2004 from the OAM address and wrapping around
+    void write_oam_dma(std::span<const byte_t, 256> page);
+
 public:
     [[nodiscard]] const ppu_frame_buffer& frame_buffer() const;
 
@@ -30,7 +76,52 @@ public:
     [[nodiscard]] size_t get_scanline() const;
 
 private:
-    [[maybe_unused]] void swap_buffers();
+    void swap_buffers();
+
+    // Scanline dot after _scanline_cycle that may have work on it, the end of the scanline otherwise
+    [[nodiscard]] ppu_cycle_t get_next_dot() const;
+    void run_dot();
+
+    // The status flags change at fixed dots, the scheduler has an event at each so idle loops polling $2002 see them
+    void update_status();
+
+    [[nodiscard]] bool is_rendering() const;
+
+    // The whole scanline from the current VRAM address, fine X and OAM into the back frame buffer
+    void render_scanline();
+
+    // Palette indexes of the scanline, 0 is transparent, the tile rows come decoded from the tile cache
+    void render_background(std::span<byte_t, screen_width> background) const;
+    void render_sprites(std::span<const byte_t, screen_width> background, std::span<byte_t, screen_width> sprites, std::span<bool, screen_width> behind);
+
+    // Dot-accurate pipeline, the fetches of a tile take 8 dots and the pixel of dot N is drawn from the shifters at dot N
+    void run_pipeline_dot();
+    void fetch_background();
+    void reload_background_shifters();
+    void shift_background();
+    void draw_pixel();
+
+    // The sprites of the next scanline are evaluated in one go at dot 256, their patterns fetched one per 8 dots from dot 257
+    void evaluate_sprites();
+    void fetch_sprite(size_t slot, bool high);
+
+    [[nodiscard]] addr_t get_sprite_pattern_addr(byte_t tile_index, size_t row) const;
+
+    // The VRAM address moves like the rendering fetches do, down a row at dot 256, back to the left at dot 257 and to the top on the pre-render scanline
+    void increment_coarse_x();
+    void increment_y();
+    void copy_horizontal();
+    void copy_vertical();
+
+    // $0000-$3FFF of the ppu address space
+    [[nodiscard]] byte_t read_vram(addr_t addr) const;
+    void write_vram(addr_t addr, byte_t value);
+
+    [[nodiscard]] size_t get_nametable_index(addr_t addr) const;
+    [[nodiscard]] static size_t get_nametable_index(addr_t addr, cartridge_mapper::mirroring mirroring);
+    [[nodiscard]] static size_t get_palette_index(addr_t addr);
+
+    void increment_vram_addr();
 
 private:
     // clang-format off
@@ -44,8 +135,45 @@ private:
     };
     // clang-format on
 
-    static constexpr ppu_cycle_t scanline_max_cycle{341};
-    static constexpr size_t scanline_count{362};
+    static constexpr ppu_cycle_t scanline_max_cycle{ppu_scanline_cycle};
+    static constexpr size_t scanline_count{ppu_scanline_count};
+
+    static constexpr size_t vblank_scanline{241};
+    static constexpr size_t pre_render_scanline{261};
+
+    static constexpr ppu_cycle_t status_dot{1};
+    static constexpr ppu_cycle_t render_dot{256};
+    static constexpr ppu_cycle_t copy_horizontal_dot{257};
+    static constexpr ppu_cycle_t copy_vertical_dot{304};
+
+    static constexpr ppu_cycle_t copy_vertical_first_dot{280};
+    static constexpr ppu_cycle_t sprite_fetch_first_dot{257};
+    static constexpr ppu_cycle_t prefetch_first_dot{321};
+    static constexpr ppu_cycle_t prefetch_last_dot{336};
+
+    static constexpr size_t sprite_count{64};
+    static constexpr size_t scanline_sprite_count{8};
+
+    static constexpr byte_t control_increment{0x04};
+    static constexpr byte_t control_sprite_table{0x08};
+    static constexpr byte_t control_background_table{0x10};
+    static constexpr byte_t control_sprite_size{0x20};
+    static constexpr byte_t control_nmi{0x80};
+
+    static constexpr byte_t mask_grayscale{0x01};
+    static constexpr byte_t mask_background_left{0x02};
+    static constexpr byte_t mask_sprites_left{0x04};
+    static constexpr byte_t mask_background{0x08};
+    static constexpr byte_t mask_sprites{0x10};
+
+    static constexpr byte_t sprite_palette{0x03};
+    static constexpr byte_t sprite_behind{0x20};
+    static constexpr byte_t sprite_flip_x{0x40};
+    static constexpr byte_t sprite_flip_y{0x80};
+
+    static constexpr byte_t status_sprite_overflow{0x20};
+    static constexpr byte_t status_sprite_zero_hit{0x40};
+    static constexpr byte_t status_vblank{0x80};
 
 public:
     ref_wrap<BusT> _bus;
@@ -54,13 +182,37 @@ public:
     ref_wrap<ppu_frame_buffer> _front_frame_buffer{_frame_buffers[0]};
     ref_wrap<ppu_frame_buffer> _back_frame_buffer{_frame_buffers[1]};
 
-    array<array<byte_t, 4096>, 2> _pattern_tables;
-    array<byte_t, 32> _palette_table;
+    array<byte_t, 32> _palette_table{};
+
+    array<byte_t, 256> _oam{};
+    byte_t _oam_addr{0};
+
+    // 2K of nametables, the cartridge mirroring maps the 4 of the address space on them
+    array<byte_t, 0x800> _nametables{};
+
+    byte_t _control{0};
+    byte_t _mask{0};
+    byte_t _status{0};
+    byte_t _open_bus{0};
+
+    // $2007 returns the byte read by the previous access below the palette
+    byte_t _read_buffer{0};
+
+    // Current and temporary VRAM addresses, fine X scroll and first or second write of $2005 and $2006
+    addr_t _vram_addr{0};
+    addr_t _temp_vram_addr{0};
+    byte_t _fine_x{0};
+    bool _write_toggle{false};
 
     ppu_cycle_t _cycle{0};
     ppu_cycle_t _scanline_cycle{0};
 
     size_t _scanline{0};
+
+    [[no_unique_address]] std::conditional_t<PolicyT::dot_accurate, ppu_pipeline, std::monostate> _pipeline{};
+
+    // The pipeline fetches each byte through the cartridge instead
+    [[no_unique_address]] std::conditional_t<PolicyT::dot_accurate, std::monostate, ppu_tile_cache> _tile_cache{};
 };
 
 } // namespace nese
@@ -1,93 +1,1009 @@
 namespace nese {
 
-template<typename BusT>
-ppu<BusT>::ppu(BusT& bus)
+template<typename BusT, typename PolicyT>
+ppu<BusT, PolicyT>::ppu(BusT& bus)
     : _bus(bus)
 {
-    for (size_t y = 0; y < screen_height; ++y)
+    // Black until the first frame is rendered
+    _frame_buffers[0].fill(pal_screen[0x0F]);
+    _frame_buffers[1].fill(pal_screen[0x0F]);
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::reset()
+{
+    _cycle = ppu_cycle_t(0);
+    _scanline_cycle = ppu_cycle_t(0);
+    _scanline = 0;
+
+    _control = 0;
+    _mask = 0;
+    _status = 0;
+    _open_bus = 0;
+    _read_buffer = 0;
+
+    _vram_addr = 0;
+    _temp_vram_addr = 0;
+    _fine_x = 0;
+    _write_toggle = false;
+
+    if constexpr (PolicyT::dot_accurate)
     {
-        for (size_t x = 0; x < screen_width; ++x)
-        {
-            const size_t index = y * screen_width + x;
-            _frame_buffers[0][index] = pal_screen[rand() % 2 ? 0x3F : 0x30];
-            _frame_buffers[1][index] = _frame_buffers[0][index];
-        }
+        _pipeline = {};
     }
 }
 
-template<typename BusT>
-void ppu<BusT>::reset()
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::step()
 {
+    step(_cycle + ppu_cycle_t(1));
 }
 
-template<typename BusT>
-void ppu<BusT>::step()
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::step(ppu_cycle_t to_cycle)
 {
-    ++_cycle;
-    ++_scanline_cycle;
+    while (_cycle < to_cycle)
+    {
+        NESE_ASSERT_CODE(const ppu_cycle_t pre_step_cycle = _cycle);
+
+        ppu_cycle_t next_dot = get_next_dot();
+
+        if constexpr (PolicyT::dot_accurate)
+        {
+            // Vblank still jumps from dot to dot
+            if (_scanline < screen_height || _scanline == pre_render_scanline)
+            {
+                next_dot = _scanline_cycle + ppu_cycle_t(1);
+            }
+        }
+
+        const ppu_cycle_t cycles = std::min(next_dot - _scanline_cycle, to_cycle - _cycle);
+
+        _cycle += cycles;
+        _scanline_cycle += cycles;
+
+        if (_scanline_cycle >= scanline_max_cycle)
+        {
+            _scanline_cycle %= scanline_max_cycle;
+
+            ++_scanline;
+
+            if (_scanline >= scanline_count)
+            {
+                _scanline %= scanline_count;
+                swap_buffers();
+            }
+        }
+
+        if constexpr (PolicyT::dot_accurate)
+        {
+            run_pipeline_dot();
+        }
+        else
+        {
+            run_dot();
+        }
 
-    if (_scanline_cycle >= scanline_max_cycle)
+        NESE_ASSERT(_cycle > pre_step_cycle);
+    }
+}
+
+template<typename BusT, typename PolicyT>
+std::optional<ppu_cycle_t> ppu<BusT, PolicyT>::get_next_sprite_zero_hit_cycle() const
+{
+    if ((_status & status_sprite_zero_hit) || (_mask & (mask_background | mask_sprites)) != (mask_background | mask_sprites))
     {
-        _scanline_cycle %= scanline_max_cycle;
+        return std::nullopt;
+    }
+
+    // Sprites show one scanline below their OAM Y
+    const size_t first_scanline = static_cast<size_t>(_oam[0]) + 1;
+    const size_t end_scanline = std::min(first_scanline + ((_control & control_sprite_size) ? 16 : 8), screen_height);
 
-        ++_scanline;
+    // The scanline renderer sets the flag at its render dot, the pipeline on the pixel of the sprite where it happens
+    ppu_cycle_t first_dot = render_dot;
+    ppu_cycle_t last_dot = render_dot;
 
-        if (_scanline >= scanline_count)
+    if constexpr (PolicyT::dot_accurate)
+    {
+        // Pixel x is drawn on dot x + 1, never a hit on the last pixel nor on the left column unless both layers show there
+        const size_t left_x = (_mask & (mask_background_left | mask_sprites_left)) == (mask_background_left | mask_sprites_left) ? 0 : 8;
+        const size_t first_x = std::max(static_cast<size_t>(_oam[3]), left_x);
+        const size_t last_x = std::min(static_cast<size_t>(_oam[3]) + 7, screen_width - 2);
+
+        if (first_x > last_x)
         {
-            _scanline %= scanline_count;
-            swap_buffers();
+            return std::nullopt;
         }
+
+        first_dot = ppu_cycle_t(static_cast<s64_t>(first_x) + 1);
+        last_dot = ppu_cycle_t(static_cast<s64_t>(last_x) + 1);
     }
 
-    const size_t index = _scanline * screen_width + _scanline_cycle.count();
-    
-    if (ppu_frame_buffer& fb = _back_frame_buffer; index < fb.size())
+    ppu_cycle_t frame_cycle = _cycle - _scanline_cycle - scanline_max_cycle * static_cast<s64_t>(_scanline);
+    size_t scanline = first_scanline;
+
+    if (_scanline == pre_render_scanline)
     {
-        fb[index] = pal_screen[rand() % 2 ? 0x3F : 0x30];
+        frame_cycle += ppu_frame_cycle;
     }
+    else
+    {
+        scanline = std::max(scanline, _scanline_cycle < last_dot ? _scanline : _scanline + 1);
+    }
+
+    if (scanline >= end_scanline)
+    {
+        return std::nullopt;
+    }
+
+    // The next dot of the sprite left on the current scanline, the emulator asks again after each one without the hit
+    const ppu_cycle_t dot = scanline == _scanline ? std::max(first_dot, _scanline_cycle + ppu_cycle_t(1)) : first_dot;
+
+    return frame_cycle + scanline_max_cycle * static_cast<s64_t>(scanline) + dot;
 }
 
-template<typename BusT>
-void ppu<BusT>::step(ppu_cycle_t to_cycle)
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::invalidate_chr()
 {
-    while (_cycle < to_cycle)
+    if constexpr (!PolicyT::dot_accurate)
     {
-        NESE_ASSERT_CODE(const ppu_cycle_t pre_step_cycle = _cycle);
+        _tile_cache.invalidate();
+    }
+}
 
-        step();
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_control(byte_t value)
+{
+    const bool enables_nmi = !(_control & control_nmi) && (value & control_nmi);
 
-        NESE_ASSERT(_cycle > pre_step_cycle);
+    _open_bus = value;
+    _control = value;
+
+    // Nametable select in bits 10-11
+    _temp_vram_addr = static_cast<addr_t>((_temp_vram_addr & 0xF3FF) | ((value & 0x03) << 10));
+
+    if (enables_nmi && (_status & status_vblank))
+    {
+        _bus.get().cpu.nmi(_cycle);
     }
 }
 
-template<typename BusT>
-const ppu_frame_buffer& ppu<BusT>::frame_buffer() const
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_mask(byte_t value)
+{
+    _open_bus = value;
+    _mask = value;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::read_status()
+{
+    const byte_t value = peek_status();
+
+    _open_bus = value;
+    _status &= static_cast<byte_t>(~status_vblank);
+    _write_toggle = false;
+
+    return value;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_status(byte_t value)
+{
+    // Read only, the write still drives the data bus
+    _open_bus = value;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_scroll(byte_t value)
+{
+    _open_bus = value;
+
+    if (!_write_toggle)
+    {
+        // Coarse X in bits 0-4
+        _temp_vram_addr = static_cast<addr_t>((_temp_vram_addr & 0xFFE0) | (value >> 3));
+        _fine_x = value & 0x07;
+    }
+    else
+    {
+        // Fine Y in bits 12-14, coarse Y in bits 5-9
+        _temp_vram_addr = static_cast<addr_t>((_temp_vram_addr & 0x8C1F) | ((value & 0x07) << 12) | ((value & 0xF8) << 2));
+    }
+
+    _write_toggle = !_write_toggle;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_ppu_addr(byte_t value)
+{
+    _open_bus = value;
+
+    if (!_write_toggle)
+    {
+        // High byte first, bit 14 is cleared
+        _temp_vram_addr = static_cast<addr_t>((_temp_vram_addr & 0x00FF) | ((value & 0x3F) << 8));
+    }
+    else
+    {
+        _temp_vram_addr = static_cast<addr_t>((_temp_vram_addr & 0xFF00) | value);
+        _vram_addr = _temp_vram_addr;
+    }
+
+    _write_toggle = !_write_toggle;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::read_ppu_data()
+{
+    const addr_t addr = _vram_addr & 0x3FFF;
+    const byte_t value = peek_ppu_data();
+
+    // The palette is returned right away, the buffer gets the nametable byte under it
+    _read_buffer = read_vram(addr >= 0x3F00 ? static_cast<addr_t>(addr - 0x1000) : addr);
+    _open_bus = value;
+
+    increment_vram_addr();
+
+    return value;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_ppu_data(byte_t value)
+{
+    _open_bus = value;
+
+    write_vram(_vram_addr & 0x3FFF, value);
+    increment_vram_addr();
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::peek_status() const
+{
+    // The low bits are the stale data bus
+    return static_cast<byte_t>((_status & 0xE0) | (_open_bus & 0x1F));
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::peek_ppu_data() const
+{
+    const addr_t addr = _vram_addr & 0x3FFF;
+
+    if (addr >= 0x3F00)
+    {
+        // 6 bits of palette, the top 2 from the data bus
+        return static_cast<byte_t>((read_vram(addr) & 0x3F) | (_open_bus & 0xC0));
+    }
+
+    return _read_buffer;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::read_open_bus() const
+{
+    return _open_bus;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_oam_addr(byte_t value)
+{
+    _open_bus = value;
+    _oam_addr = value;
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::read_oam_data() const
+{
+    return _oam[_oam_addr];
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_oam_data(byte_t value)
+{
+    _open_bus = value;
+    _oam[_oam_addr++] = value;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_oam_dma(std::span<const byte_t, 256> page)
+{
+    const size_t size_to_end = _oam.size() - _oam_addr;
+
+    // The OAM address is back where it started after 256 writes
+    std::memcpy(_oam.data() + _oam_addr, page.data(), size_to_end);
+    std::memcpy(_oam.data(), page.data() + size_to_end, _oam_addr);
+}
+
+template<typename BusT, typename PolicyT>
+const ppu_frame_buffer& ppu<BusT, PolicyT>::frame_buffer() const
 {
     return _front_frame_buffer;
 }
 
-template<typename BusT>
-ppu_cycle_t ppu<BusT>::get_cycle() const
+template<typename BusT, typename PolicyT>
+ppu_cycle_t ppu<BusT, PolicyT>::get_cycle() const
 {
     return _cycle;
 }
 
-template<typename BusT>
-ppu_cycle_t ppu<BusT>::get_scanline_cycle() const
+template<typename BusT, typename PolicyT>
+ppu_cycle_t ppu<BusT, PolicyT>::get_scanline_cycle() const
 {
     return _scanline_cycle;
 }
 
-template<typename BusT>
-size_t ppu<BusT>::get_scanline() const
+template<typename BusT, typename PolicyT>
+size_t ppu<BusT, PolicyT>::get_scanline() const
 {
     return _scanline;
 }
 
-template<typename BusT>
-void ppu<BusT>::swap_buffers()
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::swap_buffers()
 {
     std::swap(_front_frame_buffer, _back_frame_buffer);
 }
 
+template<typename BusT, typename PolicyT>
+ppu_cycle_t ppu<BusT, PolicyT>::get_next_dot() const
+{
+    constexpr array<ppu_cycle_t, 5> dots{status_dot, render_dot, copy_horizontal_dot, copy_vertical_dot, scanline_max_cycle};
+
+    for (const ppu_cycle_t dot : dots)
+    {
+        if (dot > _scanline_cycle)
+        {
+            return dot;
+        }
+    }
+
+    return scanline_max_cycle;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::run_dot()
+{
+    const bool is_visible = _scanline < screen_height;
+    const bool is_pre_render = _scanline == pre_render_scanline;
+
+    if (_scanline_cycle == status_dot)
+    {
+        update_status();
+    }
+    else if (_scanline_cycle == render_dot)
+    {
+        if (is_visible)
+        {
+            render_scanline();
+        }
+
+        if (is_rendering() && (is_visible || is_pre_render))
+        {
+            increment_y();
+        }
+    }
+    else if (_scanline_cycle == copy_horizontal_dot)
+    {
+        if (is_rendering() && (is_visible || is_pre_render))
+        {
+            copy_horizontal();
+        }
+    }
+    else if (_scanline_cycle == copy_vertical_dot)
+    {
+        if (is_rendering() && is_pre_render)
+        {
+            copy_vertical();
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::update_status()
+{
+    if (_scanline == vblank_scanline)
+    {
+        _status |= status_vblank;
+
+        if (_control & control_nmi)
+        {
+            _bus.get().cpu.nmi(_cycle);
+        }
+    }
+    else if (_scanline == pre_render_scanline)
+    {
+        _status &= static_cast<byte_t>(~(status_vblank | status_sprite_zero_hit | status_sprite_overflow));
+    }
+}
+
+template<typename BusT, typename PolicyT>
+bool ppu<BusT, PolicyT>::is_rendering() const
+{
+    return _mask & (mask_background | mask_sprites);
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::render_scanline()
+{
+    ppu_frame_buffer& fb = _back_frame_buffer;
+    const std::span<u32_t, screen_width> line(fb.data() + _scanline * screen_width, screen_width);
+
+    const auto& cartridge = _bus.get().cartridge;
+
+    if (!is_rendering() || !cartridge.is_valid())
+    {
+        std::fill(line.begin(), line.end(), pal_screen[_palette_table[0] & 0x3F]);
+        return;
+    }
+
+    NESE_ASSERT(cartridge.get_chr().size() >= 0x2000);
+    _tile_cache.update(cartridge.get_chr());
+
+    array<byte_t, screen_width> background{};
+    array<byte_t, screen_width> sprites{};
+    array<bool, screen_width> behind{};
+
+    if (_mask & mask_background)
+    {
+        render_background(background);
+    }
+
+    if (_mask & mask_sprites)
+    {
+        render_sprites(background, sprites, behind);
+    }
+
+    const byte_t color_mask = (_mask & mask_grayscale) ? 0x30 : 0x3F;
+
+    for (size_t x = 0; x < screen_width; ++x)
+    {
+        const byte_t index = sprites[x] != 0 && (!behind[x] || background[x] == 0) ? sprites[x] : background[x];
+
+        line[x] = pal_screen[_palette_table[index] & color_mask];
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::render_background(std::span<byte_t, screen_width> background) const
+{
+    const cartridge_mapper::mirroring mirroring = _bus.get().cartridge.get_mirroring();
+    const size_t pattern_table = (_control & control_background_table) ? 0x1000 : 0x0000;
+    const size_t fine_y = (_vram_addr >> 12) & 0x07;
+
+    // 33 tiles cover the 256 pixels shifted by fine X
+    array<byte_t, 33 * 8> pixels;
+
+    addr_t addr = _vram_addr;
+
+    for (size_t tile = 0; tile < 33; ++tile)
+    {
+        const byte_t tile_index = _nametables[get_nametable_index(static_cast<addr_t>(0x2000 | (addr & 0x0FFF)), mirroring)];
+        const byte_t attribute = _nametables[get_nametable_index(static_cast<addr_t>(0x23C0 | (addr & 0x0C00) | ((addr >> 4) & 0x38) | ((addr >> 2) & 0x07)), mirroring)];
+
+        // 2 bits per 2x2 tiles quadrant
+        const byte_t palette = (attribute >> (((addr >> 4) & 0x04) | (addr & 0x02))) & 0x03;
+
+        // The palette goes on the opaque pixels of the 8 bytes at once, a byte is 0-3 so no bit crosses into the next
+        u64_t row;
+        std::memcpy(&row, _tile_cache.get_row(pattern_table + static_cast<size_t>(tile_index) * 16 + fine_y, false), sizeof(row));
+
+        const u64_t opaque = (row | (row >> 1)) & 0x0101010101010101;
+        row |= opaque * static_cast<u64_t>(palette << 2);
+
+        std::memcpy(pixels.data() + tile * 8, &row, sizeof(row));
+
+        // Coarse X wraps into the next horizontal nametable
+        if ((addr & 0x001F) == 0x001F)
+        {
+            addr = static_cast<addr_t>((addr & ~0x001F) ^ 0x0400);
+        }
+        else
+        {
+            ++addr;
+        }
+    }
+
+    std::copy_n(pixels.begin() + _fine_x, screen_width, background.begin());
+
+    if (!(_mask & mask_background_left))
+    {
+        std::fill_n(background.begin(), 8, byte_t{0});
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::render_sprites(std::span<const byte_t, screen_width> background, std::span<byte_t, screen_width> sprites, std::span<bool, screen_width> behind)
+{
+    const size_t height = (_control & control_sprite_size) ? 16 : 8;
+    const size_t first_x = (_mask & mask_sprites_left) ? 0 : 8;
+
+    size_t count = 0;
+
+    // Lower OAM indexes are drawn in front, the first opaque pixel of a column wins
+    for (size_t sprite = 0; sprite < sprite_count; ++sprite)
+    {
+        const byte_t* entry = _oam.data() + sprite * 4;
+
+        // Shown one scanline below its Y
+        const size_t top = static_cast<size_t>(entry[0]) + 1;
+
+        if (_scanline < top || _scanline >= top + height)
+        {
+            continue;
+        }
+
+        if (++count > scanline_sprite_count)
+        {
+            _status |= status_sprite_overflow;
+            break;
+        }
+
+        const byte_t tile_index = entry[1];
+        const byte_t attributes = entry[2];
+        const size_t left = entry[3];
+
+        size_t row = _scanline - top;
+
+        if (attributes & sprite_flip_y)
+        {
+            row = height - 1 - row;
+        }
+
+        const byte_t* pixels = _tile_cache.get_row(get_sprite_pattern_addr(tile_index, row), attributes & sprite_flip_x);
+
+        for (size_t column = 0; column < 8 && left + column < screen_width; ++column)
+        {
+            const size_t x = left + column;
+            const byte_t pixel = pixels[column];
+
+            if (pixel == 0 || sprites[x] != 0 || x < first_x)
+            {
+                continue;
+            }
+
+            sprites[x] = static_cast<byte_t>(0x10 | ((attributes & sprite_palette) << 2) | pixel);
+            behind[x] = attributes & sprite_behind;
+
+            if (sprite == 0 && background[x] != 0 && x != screen_width - 1)
+            {
+                _status |= status_sprite_zero_hit;
+            }
+        }
+    }
+}
+
+template<typename BusT, typename PolicyT>
+addr_t ppu<BusT, PolicyT>::get_sprite_pattern_addr(byte_t tile_index, size_t row) const
+{
+    // 8x16 sprites take their pattern table from bit 0 of the tile index
+    if (_control & control_sprite_size)
+    {
+        return static_cast<addr_t>(static_cast<size_t>(tile_index & 0x01) * 0x1000 + static_cast<size_t>(tile_index & 0xFE) * 16 + (row & 0x08) * 2 + (row & 0x07));
+    }
+
+    return static_cast<addr_t>(((_control & control_sprite_table) ? size_t{0x1000} : size_t{0x0000}) + static_cast<size_t>(tile_index) * 16 + row);
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::run_pipeline_dot()
+{
+    const bool is_visible = _scanline < screen_height;
+    const bool is_pre_render = _scanline == pre_render_scanline;
+
+    if (_scanline_cycle == status_dot)
+    {
+        update_status();
+    }
+
+    if (!is_visible && !is_pre_render)
+    {
+        return;
+    }
+
+    const bool is_drawing = _scanline_cycle >= status_dot && _scanline_cycle <= render_dot;
+
+    if (is_visible && is_drawing)
+    {
+        draw_pixel();
+    }
+
+    if (!is_rendering())
+    {
+        return;
+    }
+
+    if (is_drawing || (_scanline_cycle >= prefetch_first_dot && _scanline_cycle <= prefetch_last_dot))
+    {
+        shift_background();
+        fetch_background();
+    }
+    else if (_scanline_cycle >= sprite_fetch_first_dot && _scanline_cycle < prefetch_first_dot)
+    {
+        // Low then high pattern byte on the last 4 dots of each sprite
+        const size_t dot = static_cast<size_t>((_scanline_cycle - sprite_fetch_first_dot).count());
+
+        if (dot % 8 == 4 || dot % 8 == 6)
+        {
+            fetch_sprite(dot / 8, dot % 8 == 6);
+        }
+    }
+
+    if (_scanline_cycle == render_dot)
+    {
+        increment_y();
+        evaluate_sprites();
+    }
+    else if (_scanline_cycle == copy_horizontal_dot)
+    {
+        copy_horizontal();
+
+        _pipeline.line_sprite_count = _pipeline.secondary_count;
+        _pipeline.line_has_sprite_zero = _pipeline.secondary_has_sprite_zero;
+    }
+    else if (is_pre_render && _scanline_cycle >= copy_vertical_first_dot && _scanline_cycle <= copy_vertical_dot)
+    {
+        copy_vertical();
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::fetch_background()
+{
+    ppu_pipeline& pipeline = _pipeline;
+
+    // Nametable, attribute, low and high pattern bytes, the tile goes to the shifters on the 8th dot
+    switch ((_scanline_cycle.count() - 1) % 8)
+    {
+    case 0:
+        pipeline.nametable = read_vram(static_cast<addr_t>(0x2000 | (_vram_addr & 0x0FFF)));
+        break;
+
+    case 2:
+    {
+        const byte_t attribute = read_vram(static_cast<addr_t>(0x23C0 | (_vram_addr & 0x0C00) | ((_vram_addr >> 4) & 0x38) | ((_vram_addr >> 2) & 0x07)));
+
+        // 2 bits per 2x2 tiles quadrant
+        pipeline.attribute = (attribute >> (((_vram_addr >> 4) & 0x04) | (_vram_addr & 0x02))) & 0x03;
+        break;
+    }
+
+    case 4:
+    case 6:
+    {
+        const size_t pattern_table = (_control & control_background_table) ? 0x1000 : 0x0000;
+        const size_t fine_y = (_vram_addr >> 12) & 0x07;
+        const auto addr = static_cast<addr_t>(pattern_table + static_cast<size_t>(pipeline.nametable) * 16 + fine_y);
+
+        if ((_scanline_cycle.count() - 1) % 8 == 4)
+        {
+            pipeline.pattern_low = read_vram(addr);
+        }
+        else
+        {
+            pipeline.pattern_high = read_vram(static_cast<addr_t>(addr + 8));
+        }
+        break;
+    }
+
+    case 7:
+        reload_background_shifters();
+        increment_coarse_x();
+        break;
+
+    default:
+        break;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::reload_background_shifters()
+{
+    ppu_pipeline& pipeline = _pipeline;
+
+    pipeline.pattern_shift_low = static_cast<u16_t>((pipeline.pattern_shift_low & 0xFF00) | pipeline.pattern_low);
+    pipeline.pattern_shift_high = static_cast<u16_t>((pipeline.pattern_shift_high & 0xFF00) | pipeline.pattern_high);
+    pipeline.attribute_shift_low = static_cast<u16_t>((pipeline.attribute_shift_low & 0xFF00) | ((pipeline.attribute & 0x01) ? 0xFF : 0x00));
+    pipeline.attribute_shift_high = static_cast<u16_t>((pipeline.attribute_shift_high & 0xFF00) | ((pipeline.attribute & 0x02) ? 0xFF : 0x00));
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::shift_background()
+{
+    ppu_pipeline& pipeline = _pipeline;
+
+    pipeline.pattern_shift_low = static_cast<u16_t>(pipeline.pattern_shift_low << 1);
+    pipeline.pattern_shift_high = static_cast<u16_t>(pipeline.pattern_shift_high << 1);
+    pipeline.attribute_shift_low = static_cast<u16_t>(pipeline.attribute_shift_low << 1);
+    pipeline.attribute_shift_high = static_cast<u16_t>(pipeline.attribute_shift_high << 1);
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::draw_pixel()
+{
+    const size_t x = static_cast<size_t>((_scanline_cycle - status_dot).count());
+    u32_t& pixel = _back_frame_buffer.get()[_scanline * screen_width + x];
+
+    if (!is_rendering())
+    {
+        pixel = pal_screen[_palette_table[0] & 0x3F];
+        return;
+    }
+
+    const ppu_pipeline& pipeline = _pipeline;
+
+    byte_t background = 0;
+    byte_t sprite = 0;
+    bool behind = false;
+
+    if ((_mask & mask_background) && (x >= 8 || (_mask & mask_background_left)))
+    {
+        const auto bit = static_cast<u16_t>(0x8000 >> _fine_x);
+        const byte_t value = static_cast<byte_t>(((pipeline.pattern_shift_low & bit) ? 0x01 : 0x00) | ((pipeline.pattern_shift_high & bit) ? 0x02 : 0x00));
+
+        if (value != 0)
+        {
+            const byte_t palette = static_cast<byte_t>(((pipeline.attribute_shift_low & bit) ? 0x01 : 0x00) | ((pipeline.attribute_shift_high & bit) ? 0x02 : 0x00));
+            background = static_cast<byte_t>((palette << 2) | value);
+        }
+    }
+
+    if ((_mask & mask_sprites) && (x >= 8 || (_mask & mask_sprites_left)))
+    {
+        // Lower slots are drawn in front, the first opaque pixel wins
+        for (size_t slot = 0; slot < pipeline.line_sprite_count; ++slot)
+        {
+            const size_t column = x - pipeline.sprite_x[slot];
+
+            if (x < pipeline.sprite_x[slot] || column >= 8)
+            {
+                continue;
+            }
+
+            const size_t bit = 7 - column;
+            const byte_t value = static_cast<byte_t>(((pipeline.sprite_pattern_low[slot] >> bit) & 0x01) | (((pipeline.sprite_pattern_high[slot] >> bit) & 0x01) << 1));
+
+            if (value == 0)
+            {
+                continue;
+            }
+
+            const byte_t attributes = pipeline.sprite_attributes[slot];
+
+            sprite = static_cast<byte_t>(0x10 | ((attributes & sprite_palette) << 2) | value);
+            behind = attributes & sprite_behind;
+
+            if (slot == 0 && pipeline.line_has_sprite_zero && background != 0 && x != screen_width - 1)
+            {
+                _status |= status_sprite_zero_hit;
+            }
+
+            break;
+        }
+    }
+
+    const byte_t color_mask = (_mask & mask_grayscale) ? 0x30 : 0x3F;
+    const byte_t index = sprite != 0 && (!behind || background == 0) ? sprite : background;
+
+    pixel = pal_screen[_palette_table[index] & color_mask];
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::evaluate_sprites()
+{
+    ppu_pipeline& pipeline = _pipeline;
+
+    pipeline.secondary_count = 0;
+    pipeline.secondary_has_sprite_zero = false;
+
+    // Nothing is shown on scanline 0
+    if (_scanline >= screen_height)
+    {
+        return;
+    }
+
+    const size_t height = (_control & control_sprite_size) ? 16 : 8;
+
+    for (size_t sprite = 0; sprite < sprite_count; ++sprite)
+    {
+        const byte_t* entry = _oam.data() + sprite * 4;
+
+        // Shown on the next scanline when it is one of the rows below Y
+        if (_scanline < entry[0] || _scanline - entry[0] >= height)
+        {
+            continue;
+        }
+
+        if (pipeline.secondary_count == scanline_sprite_count)
+        {
+            _status |= status_sprite_overflow;
+            break;
+        }
+
+        std::copy(entry, entry + 4, pipeline.secondary_oam.begin() + pipeline.secondary_count * 4);
+
+        pipeline.secondary_has_sprite_zero |= sprite == 0;
+        ++pipeline.secondary_count;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::fetch_sprite(size_t slot, bool high)
+{
+    ppu_pipeline& pipeline = _pipeline;
+
+    // The empty slots still fetch tile $FF and stay transparent
+    const bool is_used = slot < pipeline.secondary_count;
+    const byte_t* entry = pipeline.secondary_oam.data() + slot * 4;
+
+    const byte_t tile_index = is_used ? entry[1] : byte_t{0xFF};
+    const byte_t attributes = is_used ? entry[2] : byte_t{0x00};
+
+    size_t row = is_used ? _scanline - entry[0] : 0;
+
+    if (attributes & sprite_flip_y)
+    {
+        row = ((_control & control_sprite_size) ? 16 : 8) - 1 - row;
+    }
+
+    const addr_t addr = get_sprite_pattern_addr(tile_index, row);
+    byte_t value = read_vram(high ? static_cast<addr_t>(addr + 8) : addr);
+
+    if (!is_used)
+    {
+        value = 0;
+    }
+    else if (attributes & sprite_flip_x)
+    {
+        value = static_cast<byte_t>(((value & 0xF0) >> 4) | ((value & 0x0F) << 4));
+        value = static_cast<byte_t>(((value & 0xCC) >> 2) | ((value & 0x33) << 2));
+        value = static_cast<byte_t>(((value & 0xAA) >> 1) | ((value & 0x55) << 1));
+    }
+
+    if (high)
+    {
+        pipeline.sprite_pattern_high[slot] = value;
+        pipeline.sprite_attributes[slot] = attributes;
+        pipeline.sprite_x[slot] = is_used ? entry[3] : byte_t{0xFF};
+    }
+    else
+    {
+        pipeline.sprite_pattern_low[slot] = value;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::increment_coarse_x()
+{
+    // Wraps into the next horizontal nametable
+    if ((_vram_addr & 0x001F) == 0x001F)
+    {
+        _vram_addr = static_cast<addr_t>((_vram_addr & ~0x001F) ^ 0x0400);
+    }
+    else
+    {
+        ++_vram_addr;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::increment_y()
+{
+    if ((_vram_addr & 0x7000) != 0x7000)
+    {
+        // Fine Y
+        _vram_addr = static_cast<addr_t>(_vram_addr + 0x1000);
+        return;
+    }
+
+    _vram_addr &= static_cast<addr_t>(~0x7000);
+
+    // Coarse Y wraps into the next vertical nametable after the 30 rows, rows 30 and 31 are the attributes and wrap in place
+    size_t coarse_y = (_vram_addr & 0x03E0) >> 5;
+
+    if (coarse_y == 29)
+    {
+        coarse_y = 0;
+        _vram_addr ^= 0x0800;
+    }
+    else if (coarse_y == 31)
+    {
+        coarse_y = 0;
+    }
+    else
+    {
+        ++coarse_y;
+    }
+
+    _vram_addr = static_cast<addr_t>((_vram_addr & ~0x03E0) | (coarse_y << 5));
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::copy_horizontal()
+{
+    _vram_addr = static_cast<addr_t>((_vram_addr & ~0x041F) | (_temp_vram_addr & 0x041F));
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::copy_vertical()
+{
+    _vram_addr = static_cast<addr_t>((_vram_addr & ~0x7BE0) | (_temp_vram_addr & 0x7BE0));
+}
+
+template<typename BusT, typename PolicyT>
+byte_t ppu<BusT, PolicyT>::read_vram(addr_t addr) const
+{
+    if (addr < 0x2000)
+    {
+        return _bus.get().cartridge.read_chr(addr);
+    }
+    else if (addr < 0x3F00)
+    {
+        return _nametables[get_nametable_index(addr)];
+    }
+
+    return _palette_table[get_palette_index(addr)];
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::write_vram(addr_t addr, byte_t value)
+{
+    if (addr < 0x2000)
+    {
+        _bus.get().cartridge.write_chr(addr, value);
+
+        if constexpr (!PolicyT::dot_accurate)
+        {
+            _tile_cache.invalidate(addr);
+        }
+    }
+    else if (addr < 0x3F00)
+    {
+        _nametables[get_nametable_index(addr)] = value;
+    }
+    else
+    {
+        _palette_table[get_palette_index(addr)] = value;
+    }
+}
+
+template<typename BusT, typename PolicyT>
+size_t ppu<BusT, PolicyT>::get_nametable_index(addr_t addr) const
+{
+    return get_nametable_index(addr, _bus.get().cartridge.get_mirroring());
+}
+
+template<typename BusT, typename PolicyT>
+size_t ppu<BusT, PolicyT>::get_nametable_index(addr_t addr, cartridge_mapper::mirroring mirroring)
+{
+    // $3000-$3EFF mirrors $2000-$2EFF
+    switch (mirroring)
+    {
+    case cartridge_mapper::mirroring::horizontal:
+        // $2000 = $2400 and $2800 = $2C00
+        return ((addr >> 1) & 0x400) | (addr & 0x3FF);
+
+    case cartridge_mapper::mirroring::vertical:
+        // $2000 = $2800 and $2400 = $2C00
+        return addr & 0x7FF;
+    }
+
+    return addr & 0x7FF;
+}
+
+template<typename BusT, typename PolicyT>
+size_t ppu<BusT, PolicyT>::get_palette_index(addr_t addr)
+{
+    // The backdrop entries of the sprite palettes $3F10, $3F14, $3F18 and $3F1C mirror the background ones
+    const size_t index = addr & 0x1F;
+
+    return (index & 0x13) == 0x10 ? index & 0x0F : index;
+}
+
+template<typename BusT, typename PolicyT>
+void ppu<BusT, PolicyT>::increment_vram_addr()
+{
+    _vram_addr = static_cast<addr_t>((_vram_addr + ((_control & control_increment) ? 32 : 1)) & 0x7FFF);
+}
+
 } // namespace nese
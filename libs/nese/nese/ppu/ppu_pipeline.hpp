@@ -0,0 +1,39 @@
+#pragma once
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+// Latches and shift registers of the dot-accurate ppu
+struct ppu_pipeline
+{
+    static constexpr size_t sprite_count{8};
+
+    // Bytes of the next tile, fetched 2 dots each
+    byte_t nametable{0};
+    byte_t attribute{0};
+    byte_t pattern_low{0};
+    byte_t pattern_high{0};
+
+    // The high byte is the tile being drawn, the next one is reloaded in the low byte every 8 dots
+    // The attribute shifters hold the palette bits of each pixel like the pattern ones
+    u16_t pattern_shift_low{0};
+    u16_t pattern_shift_high{0};
+    u16_t attribute_shift_low{0};
+    u16_t attribute_shift_high{0};
+
+    // Sprites found by the evaluation for the next scanline, OAM order
+    array<byte_t, sprite_count * 4> secondary_oam{};
+    byte_t secondary_count{0};
+    bool secondary_has_sprite_zero{false};
+
+    // Sprites of the scanline being drawn, fetched from the secondary OAM at dots 257-320, the patterns already flipped
+    array<byte_t, sprite_count> sprite_pattern_low{};
+    array<byte_t, sprite_count> sprite_pattern_high{};
+    array<byte_t, sprite_count> sprite_attributes{};
+    array<byte_t, sprite_count> sprite_x{};
+    byte_t line_sprite_count{0};
+    bool line_has_sprite_zero{false};
+};
+
+} // namespace nese
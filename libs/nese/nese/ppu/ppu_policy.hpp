@@ -0,0 +1,22 @@
+#pragma once
+
+#ifndef NESE_PPU_DOT_ACCURATE_ENABLED
+#define NESE_PPU_DOT_ACCURATE_ENABLED 0
+#endif
+
+namespace nese {
+
+struct ppu_policy
+{
+    // Run the background fetches, the shift registers and the sprite fetches on every dot of the rendering scanlines
+    // Slower, for the games changing the scroll mid-scanline or whose mapper watches the pattern fetches
+    static constexpr bool dot_accurate = false;
+};
+
+// The exact pipeline, selected for the games needing it while the bulk runs keep the scanline renderer
+struct dot_accurate_ppu_policy : ppu_policy
+{
+    static constexpr bool dot_accurate = true;
+};
+
+} // namespace nese
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <bit>
+#include <span>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+// The 512 tiles of the 8K CHR window expanded to one palette index per pixel, 0-3, with a horizontally flipped copy
+// Rebuilt from the cartridge CHR once invalidated by a load or a bank switch, a CHR RAM write only dirties its tile
+class ppu_tile_cache
+{
+public:
+    static constexpr size_t tile_count = 512;
+    static constexpr size_t tile_size = 16;
+    static constexpr size_t row_size = 8;
+
+public:
+    ppu_tile_cache();
+
+    void invalidate();
+
+    // Dirty the tile holding the CHR address
+    void invalidate(addr_t addr);
+
+    // Decode the dirty tiles, the renderer calls it before reading rows
+    void update(std::span<const byte_t> chr);
+
+    [[nodiscard]] bool is_dirty() const;
+
+    // 8 pixels of the row at a pattern address, tile * 16 + row like the low plane fetch
+    [[nodiscard]] const byte_t* get_row(size_t addr, bool flip) const;
+
+private:
+    void decode(size_t tile, std::span<const byte_t> chr);
+
+private:
+    using tile_pixels = array<byte_t, row_size * 8>;
+
+    array<tile_pixels, tile_count> _tiles{};
+    array<tile_pixels, tile_count> _flipped_tiles{};
+
+    array<u64_t, tile_count / 64> _dirty_tiles{};
+    bool _is_dirty{false};
+};
+
+inline ppu_tile_cache::ppu_tile_cache()
+{
+    invalidate();
+}
+
+inline void ppu_tile_cache::invalidate()
+{
+    _dirty_tiles.fill(~u64_t{0});
+    _is_dirty = true;
+}
+
+inline void ppu_tile_cache::invalidate(addr_t addr)
+{
+    const size_t tile = (addr / tile_size) % tile_count;
+
+    _dirty_tiles[tile / 64] |= u64_t{1} << (tile % 64);
+    _is_dirty = true;
+}
+
+inline void ppu_tile_cache::update(std::span<const byte_t> chr)
+{
+    if (!_is_dirty)
+    {
+        return;
+    }
+
+    for (size_t word = 0; word < _dirty_tiles.size(); ++word)
+    {
+        for (u64_t bits = _dirty_tiles[word]; bits != 0; bits &= bits - 1)
+        {
+            decode(word * 64 + static_cast<size_t>(std::countr_zero(bits)), chr);
+        }
+
+        _dirty_tiles[word] = 0;
+    }
+
+    _is_dirty = false;
+}
+
+inline bool ppu_tile_cache::is_dirty() const
+{
+    return _is_dirty;
+}
+
+inline const byte_t* ppu_tile_cache::get_row(size_t addr, bool flip) const
+{
+    const tile_pixels& pixels = (flip ? _flipped_tiles : _tiles)[(addr / tile_size) % tile_count];
+
+    return pixels.data() + (addr % 8) * row_size;
+}
+
+inline void ppu_tile_cache::decode(size_t tile, std::span<const byte_t> chr)
+{
+    // Transparent past the end of a CHR smaller than the window
+    const size_t begin = tile * tile_size;
+
+    for (size_t row = 0; row < 8; ++row)
+    {
+        const byte_t low = begin + tile_size <= chr.size() ? chr[begin + row] : byte_t{0};
+        const byte_t high = begin + tile_size <= chr.size() ? chr[begin + row + 8] : byte_t{0};
+
+        for (size_t column = 0; column < row_size; ++column)
+        {
+            const byte_t pixel = static_cast<byte_t>(((low >> (7 - column)) & 0x01) | (((high >> (7 - column)) & 0x01) << 1));
+
+            _tiles[tile][row * row_size + column] = pixel;
+            _flipped_tiles[tile][row * row_size + row_size - 1 - column] = pixel;
+        }
+    }
+}
+
+} // namespace nese
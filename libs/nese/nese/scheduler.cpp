@@ -0,0 +1,55 @@
+#include <nese/scheduler.hpp>
+
+#include <nese/utility/assert.hpp>
+
+namespace nese {
+
+void scheduler::reset()
+{
+    _cycles.fill(unscheduled);
+    update_next();
+}
+
+void scheduler::schedule(scheduler_event event, cycle_t cycle)
+{
+    NESE_ASSERT(event != scheduler_event::count);
+
+    _cycles[static_cast<size_t>(event)] = cycle;
+    update_next();
+}
+
+void scheduler::cancel(scheduler_event event)
+{
+    schedule(event, unscheduled);
+}
+
+std::optional<scheduler_event> scheduler::pop(cycle_t cycle)
+{
+    if (_next_cycle == unscheduled || _next_cycle > cycle)
+    {
+        return std::nullopt;
+    }
+
+    const scheduler_event event = _next_event;
+
+    cancel(event);
+
+    return event;
+}
+
+void scheduler::update_next()
+{
+    _next_cycle = unscheduled;
+    _next_event = scheduler_event::count;
+
+    for (size_t i = 0; i < _cycles.size(); ++i)
+    {
+        if (_cycles[i] < _next_cycle)
+        {
+            _next_cycle = _cycles[i];
+            _next_event = static_cast<scheduler_event>(i);
+        }
+    }
+}
+
+} // namespace nese
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <optional>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+enum class scheduler_event : u8_t
+{
+    vblank,
+    vblank_end,
+    sprite_zero_hit,
+
+    // The mapper IRQ counters and the APU frame counter get their event along with the code raising and acknowledging their IRQ line
+
+    count
+};
+
+// Timestamped events on the master clock
+// Components register the next cycle they need attention, the emulator runs the cpu uninterrupted up to the nearest one
+class scheduler
+{
+public:
+    static constexpr cycle_t unscheduled = cycle_t::max();
+
+public:
+    void reset();
+
+    void schedule(scheduler_event event, cycle_t cycle);
+    void cancel(scheduler_event event);
+
+    // Remove and return the earliest event due at or before cycle
+    [[nodiscard]] std::optional<scheduler_event> pop(cycle_t cycle);
+
+    [[nodiscard]] bool is_scheduled(scheduler_event event) const;
+    [[nodiscard]] cycle_t get_cycle(scheduler_event event) const;
+    [[nodiscard]] cycle_t get_next_cycle() const;
+
+private:
+    void update_next();
+
+private:
+    array<cycle_t, static_cast<size_t>(scheduler_event::count)> _cycles{[] {
+        array<cycle_t, static_cast<size_t>(scheduler_event::count)> cycles;
+        cycles.fill(unscheduled);
+        return cycles;
+    }()};
+
+    cycle_t _next_cycle{unscheduled};
+    scheduler_event _next_event{scheduler_event::count};
+};
+
+inline bool scheduler::is_scheduled(scheduler_event event) const
+{
+    return get_cycle(event) != unscheduled;
+}
+
+inline cycle_t scheduler::get_cycle(scheduler_event event) const
+{
+    return _cycles[static_cast<size_t>(event)];
+}
+
+inline cycle_t scheduler::get_next_cycle() const
+{
+    return _next_cycle;
+}
+
+} // namespace nese
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+// Why a batch run returned to its caller
+enum class stop_reason : u8_t
+{
+    cycles_complete, // The cycle budget is spent
+    frame_complete,  // The ppu reached the end of a frame
+    breakpoint,      // The predicate asked to stop
+    jam              // A JAM opcode halted the cpu until a reset
+};
+
+} // namespace nese
@@ -74,33 +74,6 @@ constexpr char to_upper(char c)
     return static_cast<char>(c - ('a' - 'A'));
 }
 
-constexpr byte_t get_operand_size(cpu_addr_mode mode)
-{
-    switch (mode)
-    {
-    case cpu_addr_mode::implied:
-    case cpu_addr_mode::accumulator:
-        return 0;
-
-    case cpu_addr_mode::relative:
-    case cpu_addr_mode::immediate:
-    case cpu_addr_mode::zero_page:
-    case cpu_addr_mode::zero_page_x:
-    case cpu_addr_mode::zero_page_y:
-    case cpu_addr_mode::indexed_indirect:
-    case cpu_addr_mode::indirect_indexed:
-        return 1;
-
-    case cpu_addr_mode::indirect:
-    case cpu_addr_mode::absolute:
-    case cpu_addr_mode::absolute_x:
-    case cpu_addr_mode::absolute_y:
-        return 2;
-    }
-
-    NESE_ASSUME(false);
-}
-
 constexpr void append_char(auto& out, char c)
 {
     *out = c;
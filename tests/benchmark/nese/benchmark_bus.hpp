@@ -0,0 +1,62 @@
+#pragma once
+
+#include <nese/basic_types.hpp>
+#include <nese/cartridge.hpp>
+#include <nese/cpu.hpp>
+
+namespace nese {
+
+// Minimal bus without ppu so the benchmark only measures the cpu
+template<typename CpuPolicyT>
+struct benchmark_bus
+{
+    using cpu_t = cpu<benchmark_bus, CpuPolicyT>;
+
+    [[nodiscard]] byte_t read(addr_t addr)
+    {
+        if (addr < 0x2000)
+        {
+            return ram[addr & 0x07FF];
+        }
+        else if (addr < 0x4020)
+        {
+            return 0xFF;
+        }
+
+        return cartridge.read(addr);
+    }
+
+    void write(addr_t addr, byte_t value)
+    {
+        if (addr < 0x2000)
+        {
+            ram[addr & 0x07FF] = value;
+        }
+        else if (addr >= 0x4020)
+        {
+            cartridge.write(addr, value);
+
+            if (const u8_t switched_pages = cartridge.take_switched_prg_pages(); switched_pages != 0)
+            {
+                cpu.invalidate_predecode(switched_pages);
+            }
+        }
+    }
+
+    [[nodiscard]] word_t read_word(addr_t addr)
+    {
+        return read(addr) + static_cast<word_t>(static_cast<word_t>(read(addr + 1)) << 8);
+    }
+
+    void write_word(addr_t addr, word_t value)
+    {
+        write(addr, static_cast<byte_t>(value & 0xff));
+        write(addr + 1, static_cast<byte_t>(value >> 8));
+    }
+
+    array<byte_t, 2048> ram{};
+    cartridge cartridge{};
+    cpu_t cpu{*this};
+};
+
+} // namespace nese
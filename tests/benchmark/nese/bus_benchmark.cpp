@@ -0,0 +1,114 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <nese/bus.hpp>
+#include <nese/cartridge/nrom_cartridge_mapper.hpp>
+
+#include "test_config.hpp"
+
+namespace nese {
+
+namespace {
+
+// Address decoding of the bus before the page table, range checks then the mapper read
+struct range_decoder
+{
+    [[nodiscard]] byte_t read(addr_t addr) const
+    {
+        if (addr < 0x2000)
+        {
+            return ram[addr & 0x07FF];
+        }
+        else if (addr < 0x4020)
+        {
+            return 0xFF;
+        }
+
+        return cartridge.read(addr);
+    }
+
+    const array<byte_t, 2048>& ram;
+    const nese::cartridge& cartridge;
+};
+
+// Addresses the cpu mostly reads, RAM and PRG interleaved like operand and opcode fetches
+array<addr_t, 0x1000> create_addresses()
+{
+    array<addr_t, 0x1000> addresses{};
+
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        addresses[i] = static_cast<addr_t>(i % 2 == 0 ? (i * 7) & 0x07FF : 0x8000 + ((i * 13) & 0x7FFF));
+    }
+
+    return addresses;
+}
+
+template<typename ReaderT>
+size_t read_all(ReaderT& reader, const array<addr_t, 0x1000>& addresses)
+{
+    size_t sum = 0;
+
+    for (const addr_t addr : addresses)
+    {
+        sum += reader.read(addr);
+    }
+
+    return sum;
+}
+
+template<typename ReaderT>
+void benchmark(const char* name, ReaderT& reader, const array<addr_t, 0x1000>& addresses)
+{
+    BENCHMARK(name)
+    {
+        return read_all(reader, addresses);
+    };
+
+    constexpr int runs = 10'000;
+
+    size_t sum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        sum += read_all(reader, addresses);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double reads_per_second = static_cast<double>(addresses.size() * runs) / elapsed.count();
+    fmt::print("{}: {:.2f}M reads/sec ({})\n", name, reads_per_second / 1'000'000.0, sum);
+}
+
+} // namespace
+
+TEST_CASE("bus read", "[benchmark]")
+{
+    bus bus;
+    bus.load_cartridge(cartridge::from_file(nestest_rom_path));
+
+    // The same PRG behind the virtual interface
+    const cartridge virtual_cartridge{std::make_unique<nrom_cartridge_mapper>(std::vector<byte_t>(bus.cartridge.get_prg()), std::vector<byte_t>(bus.cartridge.get_chr()), cartridge_mapper::mirroring::horizontal)};
+
+    range_decoder decoder{bus.ram, bus.cartridge};
+    range_decoder virtual_decoder{bus.ram, virtual_cartridge};
+
+    const array<addr_t, 0x1000> addresses = create_addresses();
+
+    // All must see the same memory
+    REQUIRE(bus.cartridge.is_mapper_concrete());
+    REQUIRE(read_all(bus, addresses) == read_all(decoder, addresses));
+    REQUIRE(read_all(bus, addresses) == read_all(virtual_decoder, addresses));
+
+    benchmark("range checks, virtual mapper", virtual_decoder, addresses);
+    benchmark("range checks, concrete mapper", decoder, addresses);
+    benchmark("page table", bus, addresses);
+}
+
+} // namespace nese
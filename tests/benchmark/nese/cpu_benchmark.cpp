@@ -0,0 +1,299 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <nese/benchmark_bus.hpp>
+#include <nese/cartridge/nrom_cartridge_mapper.hpp>
+
+#include "test_config.hpp"
+
+namespace nese {
+
+namespace {
+
+struct table_dispatch_policy : cpu_policy
+{
+    static constexpr cpu_dispatch dispatch = cpu_dispatch::table;
+};
+
+struct switch_dispatch_policy : cpu_policy
+{
+    static constexpr cpu_dispatch dispatch = cpu_dispatch::switch_case;
+};
+
+struct predecode_policy : switch_dispatch_policy
+{
+    static constexpr bool predecode = true;
+};
+
+struct block_cache_policy : predecode_policy
+{
+    static constexpr bool block_cache = true;
+};
+
+struct eager_flags_policy : block_cache_policy
+{
+    static constexpr bool lazy_flags = false;
+};
+
+struct fusion_policy : block_cache_policy
+{
+    static constexpr bool fusion = true;
+};
+
+// Every fast path of bus_cpu_policy, the loops of the workloads aren't idle so it measures what the detection costs
+struct idle_loop_skip_policy : fusion_policy
+{
+    static constexpr bool idle_loop_skip = true;
+};
+
+// Every bus access at its own cycle, the cost of exact timing against switch dispatch
+struct cycle_accurate_policy : switch_dispatch_policy
+{
+    static constexpr bool cycle_accurate = true;
+};
+
+// Stepping policy of the measure, the pair histogram is the data behind cpu_fused_pairs
+struct pair_profiling_policy : table_dispatch_policy
+{
+    static constexpr bool pair_profiling = true;
+};
+
+constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
+
+struct nestest_workload
+{
+    static constexpr addr_t start_pc = 0xC000;
+    static constexpr addr_t end_pc = 0x0001;
+
+    static cartridge create_cartridge()
+    {
+        return cartridge::from_file(nestest_rom_path);
+    }
+
+    template<typename CpuT>
+    static bool is_done(const CpuT& cpu)
+    {
+        return cpu.get_state().registers.pc == end_pc;
+    }
+};
+
+// Nested loops summing a RAM table, most of the time is spent in a handful of instructions
+struct loop_workload
+{
+    static constexpr addr_t start_pc = 0xC000;
+    static constexpr cpu_cycle_t cycles = cpu_cycle_t(1'000'000);
+
+    static cartridge create_cartridge()
+    {
+        // clang-format off
+        constexpr array<byte_t, 20> program{
+            0xA2, 0x00,       // C000: LDX #$00
+            0xA0, 0x00,       // C002: LDY #$00
+            0xB9, 0x00, 0x02, // C004: LDA $0200,Y
+            0x65, 0x10,       // C007: ADC $10
+            0x85, 0x10,       // C009: STA $10
+            0xC8,             // C00B: INY
+            0xD0, 0xF6,       // C00C: BNE $C004
+            0xE8,             // C00E: INX
+            0xD0, 0xF1,       // C00F: BNE $C002
+            0x4C, 0x00, 0xC0  // C011: JMP $C000
+        };
+        // clang-format on
+
+        std::vector<byte_t> prg(0x4000, 0xEA);
+        std::copy(program.begin(), program.end(), prg.begin());
+
+        return cartridge{nrom_cartridge_mapper(std::move(prg), std::vector<byte_t>(0x2000), cartridge_mapper::mirroring::horizontal)};
+    }
+
+    template<typename CpuT>
+    static bool is_done(const CpuT& cpu)
+    {
+        return cpu.get_state().cycle - start_cycle >= cycles;
+    }
+};
+
+// Register only loop without operand memory accesses, the time is spent moving the cpu state around
+struct registers_workload
+{
+    static constexpr addr_t start_pc = 0xC000;
+    static constexpr cpu_cycle_t cycles = cpu_cycle_t(1'000'000);
+
+    static cartridge create_cartridge()
+    {
+        // clang-format off
+        constexpr array<byte_t, 17> program{
+            0xA2, 0x10,       // C000: LDX #$10
+            0x8A,             // C002: TXA
+            0x69, 0x03,       // C003: ADC #$03
+            0xA8,             // C005: TAY
+            0xC8,             // C006: INY
+            0x98,             // C007: TYA
+            0x29, 0x7F,       // C008: AND #$7F
+            0xAA,             // C00A: TAX
+            0xCA,             // C00B: DEX
+            0xD0, 0xF4,       // C00C: BNE $C002
+            0x4C, 0x00, 0xC0  // C00E: JMP $C000
+        };
+        // clang-format on
+
+        std::vector<byte_t> prg(0x4000, 0xEA);
+        std::copy(program.begin(), program.end(), prg.begin());
+
+        return cartridge{nrom_cartridge_mapper(std::move(prg), std::vector<byte_t>(0x2000), cartridge_mapper::mirroring::horizontal)};
+    }
+
+    template<typename CpuT>
+    static bool is_done(const CpuT& cpu)
+    {
+        return cpu.get_state().cycle - start_cycle >= cycles;
+    }
+};
+
+// Same workload with the mapper behind the virtual interface, every PRG read of benchmark_bus is a virtual call
+template<typename WorkloadT>
+struct virtual_mapper_workload : WorkloadT
+{
+    static cartridge create_cartridge()
+    {
+        const cartridge concrete = WorkloadT::create_cartridge();
+
+        return cartridge{std::make_unique<nrom_cartridge_mapper>(std::vector<byte_t>(concrete.get_prg()), std::vector<byte_t>(concrete.get_chr()), cartridge_mapper::mirroring::horizontal)};
+    }
+};
+
+template<typename CpuPolicyT>
+cpu_state power_on(benchmark_bus<CpuPolicyT>& bus, addr_t start_pc)
+{
+    bus.cpu.reset();
+    bus.cpu.get_state().registers.pc = start_pc;
+    bus.cpu.get_state().cycle = start_cycle;
+
+    return bus.cpu.get_state();
+}
+
+// Restart the workload without cpu::reset so the predecode cache stays warm between runs
+template<typename CpuPolicyT>
+void restart(benchmark_bus<CpuPolicyT>& bus, const cpu_state& initial_state)
+{
+    bus.ram = {};
+    bus.cpu.get_state() = initial_state;
+}
+
+// Number of instructions and cycles a workload takes
+struct workload_size
+{
+    size_t instructions{0};
+    cpu_cycle_t cycles{0};
+};
+
+template<typename WorkloadT>
+workload_size measure()
+{
+    benchmark_bus<pair_profiling_policy> bus;
+    bus.cartridge = WorkloadT::create_cartridge();
+
+    power_on(bus, WorkloadT::start_pc);
+
+    workload_size size;
+    while (!WorkloadT::is_done(bus.cpu) && bus.cpu.step())
+    {
+        ++size.instructions;
+    }
+
+    size.cycles = bus.cpu.get_state().cycle - start_cycle;
+
+    fmt::print("most frequent pairs:\n");
+
+    for (const cpu_pair_histogram::entry& pair : bus.cpu.get_pair_histogram().get_most_frequent(8))
+    {
+        fmt::print("  {} {}: {}\n", magic_enum::enum_name(static_cast<cpu_opcode>(pair.first)), magic_enum::enum_name(static_cast<cpu_opcode>(pair.second)), pair.count);
+    }
+
+    return size;
+}
+
+template<typename WorkloadT, typename CpuPolicyT>
+void benchmark(const char* name, const workload_size& size)
+{
+    benchmark_bus<CpuPolicyT> bus;
+    bus.cartridge = WorkloadT::create_cartridge();
+
+    const cpu_state initial_state = power_on(bus, WorkloadT::start_pc);
+
+    // Sanity check, the budget must stop the run exactly where the measure did
+    REQUIRE(bus.cpu.run(size.cycles));
+    REQUIRE(WorkloadT::is_done(bus.cpu));
+
+    BENCHMARK_ADVANCED(name)(Catch::Benchmark::Chronometer meter)
+    {
+        meter.measure([&] {
+            restart(bus, initial_state);
+            return bus.cpu.run(size.cycles);
+        });
+    };
+
+    constexpr int runs = 100;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i)
+    {
+        restart(bus, initial_state);
+        bus.cpu.run(size.cycles);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double instructions_per_second = static_cast<double>(size.instructions * runs) / elapsed.count();
+    fmt::print("{}: {:.2f}M instructions/sec\n", name, instructions_per_second / 1'000'000.0);
+
+    if constexpr (CpuPolicyT::predecode)
+    {
+        const cpu_predecode_cache& cache = bus.cpu.get_predecode_cache();
+        fmt::print("{}: {} hits, {} misses, {} block hits, {} block misses\n", name, cache.get_hit_count(), cache.get_miss_count(), cache.get_block_hit_count(), cache.get_block_miss_count());
+    }
+}
+
+template<typename WorkloadT>
+void benchmark_all(const char* name)
+{
+    const workload_size size = measure<WorkloadT>();
+
+    REQUIRE(size.instructions > 0);
+
+    fmt::print("{}: {} instructions, {} cycles\n", name, size.instructions, size.cycles.count());
+
+    benchmark<WorkloadT, table_dispatch_policy>("table dispatch", size);
+    benchmark<WorkloadT, switch_dispatch_policy>("switch dispatch", size);
+    benchmark<virtual_mapper_workload<WorkloadT>, switch_dispatch_policy>("switch dispatch, virtual mapper", size);
+    benchmark<WorkloadT, predecode_policy>("switch dispatch + predecode", size);
+    benchmark<WorkloadT, block_cache_policy>("switch dispatch + block cache", size);
+    benchmark<WorkloadT, eager_flags_policy>("switch dispatch + block cache, eager flags", size);
+    benchmark<WorkloadT, fusion_policy>("switch dispatch + block cache + fusion", size);
+    benchmark<WorkloadT, idle_loop_skip_policy>("switch dispatch + block cache + fusion + idle loop skip", size);
+    benchmark<WorkloadT, cycle_accurate_policy>("switch dispatch, cycle accurate", size);
+}
+
+} // namespace
+
+TEST_CASE("cpu nestest", "[benchmark]")
+{
+    benchmark_all<nestest_workload>("nestest");
+}
+
+TEST_CASE("cpu loop", "[benchmark]")
+{
+    benchmark_all<loop_workload>("loop");
+}
+
+TEST_CASE("cpu registers", "[benchmark]")
+{
+    benchmark_all<registers_workload>("registers");
+}
+
+} // namespace nese
@@ -0,0 +1,101 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+
+#include <fmt/format.h>
+
+#include <nese/cartridge.hpp>
+#include <nese/ppu.hpp>
+
+#include "test_config.hpp"
+
+namespace nese {
+
+namespace {
+
+// Minimal bus without cpu so the benchmark only measures the ppu
+struct ppu_benchmark_bus
+{
+    struct nmi_sink
+    {
+        void nmi(cycle_t) {}
+    };
+
+    nmi_sink cpu{};
+    cartridge cartridge{};
+};
+
+// The nestest font over the whole screen with both renderings enabled and 64 sprites
+template<typename PpuT>
+void load_scene(PpuT& ppu)
+{
+    ppu.write_ppu_addr(0x20);
+    ppu.write_ppu_addr(0x00);
+
+    for (size_t i = 0; i < 0x800; ++i)
+    {
+        ppu.write_ppu_data(static_cast<byte_t>(0x20 + i % 0x40));
+    }
+
+    ppu.write_ppu_addr(0x3F);
+    ppu.write_ppu_addr(0x00);
+
+    for (size_t i = 0; i < 0x20; ++i)
+    {
+        ppu.write_ppu_data(static_cast<byte_t>(i * 5 + 1));
+    }
+
+    for (size_t i = 0; i < 64; ++i)
+    {
+        ppu._oam[i * 4 + 0] = static_cast<byte_t>((i * 29) % 232);
+        ppu._oam[i * 4 + 1] = static_cast<byte_t>(0x30 + i % 10);
+        ppu._oam[i * 4 + 2] = static_cast<byte_t>(i & 0x03);
+        ppu._oam[i * 4 + 3] = static_cast<byte_t>(i * 41);
+    }
+
+    ppu.write_mask(0x1E);
+    ppu.write_scroll(0x00);
+    ppu.write_scroll(0x00);
+}
+
+template<typename PolicyT>
+double benchmark(const char* name, ppu_benchmark_bus& bus)
+{
+    ppu<ppu_benchmark_bus, PolicyT> ppu{bus};
+    load_scene(ppu);
+
+    BENCHMARK(name)
+    {
+        ppu.step(ppu.get_cycle() + ppu_frame_cycle);
+        return ppu.frame_buffer()[0];
+    };
+
+    constexpr int frames = 600;
+
+    const auto start = std::chrono::steady_clock::now();
+    ppu.step(ppu.get_cycle() + ppu_frame_cycle * frames);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double frames_per_second = frames / elapsed.count();
+    fmt::print("{}: {:.0f} frames/sec\n", name, frames_per_second);
+
+    return frames_per_second;
+}
+
+} // namespace
+
+TEST_CASE("ppu render", "[benchmark]")
+{
+    ppu_benchmark_bus bus;
+    bus.cartridge = cartridge::from_file(nestest_rom_path);
+
+    REQUIRE(bus.cartridge.get_chr().size() >= 0x2000);
+
+    const double scanline_frames_per_second = benchmark<ppu_policy>("scanline renderer", bus);
+    const double dot_frames_per_second = benchmark<dot_accurate_ppu_policy>("dot-accurate pipeline", bus);
+
+    fmt::print("dot-accurate cost: {:.2f}x the scanline renderer\n", scanline_frames_per_second / dot_frames_per_second);
+}
+
+} // namespace nese
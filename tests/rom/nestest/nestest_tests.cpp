@@ -3,6 +3,7 @@
 #include <spdlog/sinks/basic_file_sink.h>
 
 #include <nese/bus.hpp>
+#include <nese/lockstep_bus.hpp>
 #include <nese/utility/format.hpp>
 #include <nese/utility/hex.hpp>
 #include <nese/utility/log.hpp>
@@ -12,13 +13,60 @@
 
 namespace nestest {
 
+// Same memory map as nese::bus, its cpu runs the plain interpreter
+template<typename CpuPolicyT = nese::cpu_policy>
+struct reference_bus
+{
+    [[nodiscard]] nese::byte_t read(nese::addr_t addr) const
+    {
+        if (addr < 0x2000)
+        {
+            return ram[addr & 0x07FF];
+        }
+        else if (addr < 0x4020)
+        {
+            return 0xFF;
+        }
+
+        return cartridge.read(addr);
+    }
+
+    [[nodiscard]] nese::word_t read_word(nese::addr_t addr) const
+    {
+        return read(addr) + static_cast<nese::word_t>(static_cast<nese::word_t>(read(addr + 1)) << 8);
+    }
+
+    void write(nese::addr_t addr, nese::byte_t value)
+    {
+        if (addr < 0x2000)
+        {
+            ram[addr & 0x07FF] = value;
+        }
+        else if (addr >= 0x4020)
+        {
+            cartridge.write(addr, value);
+        }
+    }
+
+    void write_word(nese::addr_t addr, nese::word_t value)
+    {
+        write(addr, static_cast<nese::byte_t>(value & 0xff));
+        write(addr + 1, static_cast<nese::byte_t>(value >> 8));
+    }
+
+    nese::array<nese::byte_t, 2048> ram{};
+    nese::cartridge cartridge{};
+    nese::cpu<reference_bus, CpuPolicyT> cpu{*this};
+};
+
 TEST_CASE("nestest", "[romtest]")
 {
     using namespace nese;
 
     constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
     constexpr addr_x start_pc = 0xC000;
-    constexpr addr_x end_pc = 0x0005;
+    // The final RTS returns to $0001, the zeroed results after it would run as BRK
+    constexpr addr_x end_pc = 0x0001;
 
     bus bus;
 
@@ -26,25 +74,52 @@ TEST_CASE("nestest", "[romtest]")
     nintendulator_logger->set_level(spdlog::level::trace);
     nintendulator_logger->set_pattern("%v");
 
-    bus.cartridge = cartridge::from_file(nestest_rom_path);
+    bus.load_cartridge(cartridge::from_file(nestest_rom_path));
     bus.cpu.get_state().registers.pc = start_pc;
     bus.cpu.get_state().cycle = start_cycle;
     bus.ppu._cycle = ppu_cycle_t(21);
     bus.ppu._scanline_cycle = ppu_cycle_t(21);
 
-    auto cycle = cycle_t(21);
-    bool last_instruction_succeeded = true;
-    while (last_instruction_succeeded && bus.cpu.get_state().registers.pc != end_pc)
-    {
-        if (cycle == bus.cpu.get_state().cycle)
+    // Catch the ppu up to the cpu before each instruction so the log matches nintendulator
+    const stop_reason reason = bus.cpu.run_until(cpu_cycle_t::max(), [&] {
+        if (bus.cpu.get_state().registers.pc == end_pc)
         {
-            nintendulator_logger->trace(nintendulator::format(bus));
+            return true;
         }
 
-        ++cycle;
+        bus.ppu.step(bus.cpu.get_state().cycle);
+        nintendulator_logger->trace(nintendulator::format(bus));
+        return false;
+    });
+
+    REQUIRE(reason == stop_reason::breakpoint);
+    REQUIRE(bus.cpu.get_state().registers.pc == end_pc);
+
+    CHECK(bus.cpu.get_state().registers.sp == 0xff);
+
+    CHECK(bus.read(0x2) == 0);
+    CHECK(bus.read(0x3) == 0);
+}
+
+TEST_CASE("nestest run", "[romtest]")
+{
+    using namespace nese;
+
+    constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
+    constexpr addr_x start_pc = 0xC000;
+    constexpr addr_x end_pc = 0x0001;
+
+    bus bus;
+
+    bus.load_cartridge(cartridge::from_file(nestest_rom_path));
+    bus.cpu.get_state().registers.pc = start_pc;
+    bus.cpu.get_state().cycle = start_cycle;
 
-        bus.ppu.step(cycle);
-        last_instruction_succeeded = bus.cpu.step(cycle);
+    // A one cycle budget runs exactly one instruction
+    bool last_instruction_succeeded = true;
+    while (last_instruction_succeeded && bus.cpu.get_state().registers.pc != end_pc)
+    {
+        last_instruction_succeeded = bus.cpu.run(cpu_cycle_t(1));
     }
 
     REQUIRE(bus.cpu.get_state().registers.pc == end_pc);
@@ -55,4 +130,147 @@ TEST_CASE("nestest", "[romtest]")
     CHECK(bus.read(0x3) == 0);
 }
 
+TEST_CASE("nestest lockstep", "[romtest]")
+{
+    using namespace nese;
+
+    constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
+    constexpr addr_x start_pc = 0xC000;
+    constexpr addr_x end_pc = 0x0001;
+
+    bus bus;
+    reference_bus<> reference;
+
+    bus.load_cartridge(cartridge::from_file(nestest_rom_path));
+    bus.cpu.get_state().registers.pc = start_pc;
+    bus.cpu.get_state().cycle = start_cycle;
+
+    reference.cartridge = cartridge::from_file(nestest_rom_path);
+    reference.cpu.get_state() = bus.cpu.get_state();
+
+    const auto check_lockstep = [&] {
+        const cpu_state& state = bus.cpu.get_state();
+        const cpu_state& reference_state = reference.cpu.get_state();
+
+        REQUIRE(state.registers.pc == reference_state.registers.pc);
+        REQUIRE(state.registers.a == reference_state.registers.a);
+        REQUIRE(state.registers.x == reference_state.registers.x);
+        REQUIRE(state.registers.y == reference_state.registers.y);
+        REQUIRE(state.registers.sp == reference_state.registers.sp);
+        REQUIRE(state.registers.status == reference_state.registers.status);
+        REQUIRE(state.cycle == reference_state.cycle);
+        REQUIRE(bus.ram == reference.ram);
+    };
+
+    SECTION("instruction")
+    {
+        while (bus.cpu.get_state().registers.pc != end_pc)
+        {
+            REQUIRE(bus.cpu.run(cpu_cycle_t(1)));
+            REQUIRE(reference.cpu.run(cpu_cycle_t(1)));
+
+            check_lockstep();
+        }
+    }
+
+    SECTION("scanline")
+    {
+        constexpr cpu_cycle_t scanline_cycle = cycle_cast<cpu_cycle_t>(ppu_scanline_cycle);
+
+        while (bus.cpu.get_state().registers.pc != end_pc)
+        {
+            const cpu_cycle_t to_cycle = bus.cpu.get_state().cycle + scanline_cycle;
+
+            REQUIRE(bus.cpu.run_until(to_cycle, [&] { return bus.cpu.get_state().registers.pc == end_pc; }) != stop_reason::jam);
+            REQUIRE(reference.cpu.run_until(to_cycle, [&] { return reference.cpu.get_state().registers.pc == end_pc; }) != stop_reason::jam);
+
+            check_lockstep();
+        }
+    }
+}
+
+TEST_CASE("nestest cycle accurate", "[romtest]")
+{
+    using namespace nese;
+
+    constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
+    constexpr addr_x start_pc = 0xC000;
+    constexpr addr_x end_pc = 0x0001;
+
+    reference_bus<cycle_accurate_cpu_policy> accurate;
+    reference_bus<> reference;
+
+    accurate.cartridge = cartridge::from_file(nestest_rom_path);
+    accurate.cpu.get_state().registers.pc = start_pc;
+    accurate.cpu.get_state().cycle = start_cycle;
+
+    reference.cartridge = cartridge::from_file(nestest_rom_path);
+    reference.cpu.get_state() = accurate.cpu.get_state();
+
+    // Same results at the same cycles, only the bus sees more accesses
+    while (accurate.cpu.get_state().registers.pc != end_pc)
+    {
+        REQUIRE(accurate.cpu.run(cpu_cycle_t(1)));
+        REQUIRE(reference.cpu.run(cpu_cycle_t(1)));
+
+        const cpu_state& state = accurate.cpu.get_state();
+        const cpu_state& reference_state = reference.cpu.get_state();
+
+        REQUIRE(state.registers.pc == reference_state.registers.pc);
+        REQUIRE(state.registers.a == reference_state.registers.a);
+        REQUIRE(state.registers.x == reference_state.registers.x);
+        REQUIRE(state.registers.y == reference_state.registers.y);
+        REQUIRE(state.registers.sp == reference_state.registers.sp);
+        REQUIRE(state.registers.status == reference_state.registers.status);
+        REQUIRE(state.cycle == reference_state.cycle);
+        REQUIRE(accurate.ram == reference.ram);
+    }
+}
+
+TEST_CASE("nestest lockstep bus", "[romtest]")
+{
+    using namespace nese;
+
+    constexpr cpu_cycle_t start_cycle = cpu_cycle_t(7);
+    constexpr addr_x start_pc = 0xC000;
+    constexpr addr_x end_pc = 0x0001;
+
+    // Both cores behind the full memory map, every write compared
+    const auto run_lockstep = [&]<typename PolicyT>(std::type_identity<PolicyT>, const auto& check_core) {
+        bus bus;
+        nese::bus reference_bus;
+
+        bus.load_cartridge(cartridge::from_file(nestest_rom_path));
+        reference_bus.load_cartridge(cartridge::from_file(nestest_rom_path));
+
+        lockstep_bus<nese::bus, PolicyT> lockstep(bus, reference_bus);
+        lockstep.set_state({.registers = {.pc = start_pc}, .cycle = start_cycle});
+
+        const bool agreed = lockstep.run_until([&] { return lockstep.get_state().registers.pc == end_pc; });
+
+        INFO(lockstep.get_report());
+        REQUIRE(agreed);
+        CHECK(lockstep.get_state().registers.pc == end_pc);
+        CHECK(bus.ram == reference_bus.ram);
+
+        check_core(lockstep.get_cpu());
+    };
+
+    SECTION("bus core")
+    {
+        // Ran on the predecoded blocks, not the table fallback
+        run_lockstep(std::type_identity<bus_cpu_policy>{}, [](const auto& core) {
+            if constexpr (bus_cpu_policy::block_cache)
+            {
+                CHECK(core.get_predecode_cache().get_block_hit_count() > 0);
+            }
+        });
+    }
+
+    SECTION("cycle-accurate core")
+    {
+        run_lockstep(std::type_identity<cycle_accurate_cpu_policy>{}, [](const auto&) {});
+    }
+}
+
 } // namespace nese
@@ -0,0 +1,237 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <nese/bus.hpp>
+#include <nese/cartridge/nrom_cartridge_mapper.hpp>
+
+namespace nese {
+
+namespace {
+
+std::vector<byte_t> create_prg(size_t prg_size)
+{
+    std::vector<byte_t> prg(prg_size);
+
+    for (size_t i = 0; i < prg.size(); ++i)
+    {
+        prg[i] = static_cast<byte_t>(i * 7 + (i >> 8));
+    }
+
+    return prg;
+}
+
+cartridge create_cartridge(size_t prg_size)
+{
+    return cartridge{std::make_unique<nrom_cartridge_mapper>(create_prg(prg_size), std::vector<byte_t>(0x2000), cartridge_mapper::mirroring::horizontal)};
+}
+
+} // namespace
+
+TEST_CASE("bus page table", "[bus]")
+{
+    bus bus;
+
+    SECTION("ram mirrors")
+    {
+        bus.write(0x0012, 0x34);
+        bus.write(0x1FFF, 0x56);
+
+        CHECK(bus.ram[0x0012] == 0x34);
+        CHECK(bus.read(0x0812) == 0x34);
+        CHECK(bus.read(0x1012) == 0x34);
+        CHECK(bus.readonly(0x1812) == 0x34);
+
+        CHECK(bus.ram[0x07FF] == 0x56);
+        CHECK(bus.read(0x07FF) == 0x56);
+    }
+
+    SECTION("32K prg")
+    {
+        bus.load_cartridge(create_cartridge(0x8000));
+
+        for (size_t addr = 0x8000; addr <= 0xFFFF; ++addr)
+        {
+            REQUIRE(bus.read(static_cast<addr_t>(addr)) == bus.cartridge.read(static_cast<addr_t>(addr)));
+        }
+    }
+
+    SECTION("16K prg is mirrored")
+    {
+        bus.load_cartridge(create_cartridge(0x4000));
+
+        for (size_t addr = 0x8000; addr <= 0xBFFF; ++addr)
+        {
+            REQUIRE(bus.read(static_cast<addr_t>(addr)) == bus.read(static_cast<addr_t>(addr + 0x4000)));
+            REQUIRE(bus.readonly(static_cast<addr_t>(addr)) == bus.cartridge.read(static_cast<addr_t>(addr)));
+        }
+    }
+
+    SECTION("prg is read only")
+    {
+        bus.load_cartridge(create_cartridge(0x8000));
+
+        const byte_t value = bus.read(0x8000);
+
+        bus.write(0x8000, static_cast<byte_t>(~value));
+
+        CHECK(bus.read(0x8000) == value);
+    }
+}
+
+TEST_CASE("bus concrete mapper", "[bus]")
+{
+    const cartridge reference = create_cartridge(0x4000);
+    REQUIRE_FALSE(reference.is_mapper_concrete());
+
+    cartridge concrete{nrom_cartridge_mapper(create_prg(0x4000), std::vector<byte_t>(0x2000), cartridge_mapper::mirroring::horizontal)};
+    REQUIRE(concrete.is_mapper_concrete());
+
+    // Moved into the bus, the pages still point to the PRG
+    bus bus;
+    bus.load_cartridge(std::move(concrete));
+
+    REQUIRE(bus.cartridge.is_mapper_concrete());
+
+    for (size_t addr = 0x8000; addr <= 0xFFFF; ++addr)
+    {
+        REQUIRE(bus.read(static_cast<addr_t>(addr)) == reference.read(static_cast<addr_t>(addr)));
+        REQUIRE(bus.cartridge.read(static_cast<addr_t>(addr)) == reference.read(static_cast<addr_t>(addr)));
+    }
+
+    CHECK(bus.cartridge.get_prg_page(0xC000) == bus.cartridge.get_prg().data());
+}
+
+TEST_CASE("bus oam dma", "[bus][ppu]")
+{
+    bus bus;
+    bus.load_cartridge(create_cartridge(0x8000));
+
+    for (size_t i = 0; i < 0x100; ++i)
+    {
+        bus.ram[0x200 + i] = static_cast<byte_t>(0xFF - i);
+    }
+
+    SECTION("ram page")
+    {
+        bus.write(0x4014, 0x02);
+
+        for (size_t i = 0; i < 0x100; ++i)
+        {
+            REQUIRE(bus.ppu._oam[i] == bus.ram[0x200 + i]);
+        }
+    }
+
+    SECTION("ram mirror page")
+    {
+        bus.write(0x4014, 0x0A);
+
+        for (size_t i = 0; i < 0x100; ++i)
+        {
+            REQUIRE(bus.ppu._oam[i] == bus.ram[0x200 + i]);
+        }
+    }
+
+    SECTION("prg page")
+    {
+        bus.write(0x4014, 0x91);
+
+        for (size_t i = 0; i < 0x100; ++i)
+        {
+            REQUIRE(bus.ppu._oam[i] == bus.cartridge.read(static_cast<addr_t>(0x9100 + i)));
+        }
+    }
+
+    SECTION("io page")
+    {
+        array<byte_t, 0x100> expected{};
+
+        for (size_t i = 0; i < 0x100; ++i)
+        {
+            expected[i] = bus.readonly(static_cast<addr_t>(0x2100 + i));
+        }
+
+        // PPU registers mirrors
+        bus.write(0x4014, 0x21);
+
+        CHECK(bus.ppu._oam == expected);
+    }
+
+    SECTION("starts at the oam address")
+    {
+        bus.write(0x2003, 0x10);
+        bus.write(0x4014, 0x02);
+
+        CHECK(bus.ppu._oam[0x10] == bus.ram[0x200]);
+        CHECK(bus.ppu._oam[0xFF] == bus.ram[0x2EF]);
+        CHECK(bus.ppu._oam[0x00] == bus.ram[0x2F0]);
+        CHECK(bus.ppu._oam[0x0F] == bus.ram[0x2FF]);
+
+        // Back where it started
+        CHECK(bus.read(0x2004) == bus.ram[0x200]);
+    }
+
+    SECTION("catches the ppu up")
+    {
+        bus.cpu.get_state().cycle = cpu_cycle_t(1000);
+
+        bus.write(0x4014, 0x02);
+
+        CHECK(bus.ppu.get_cycle() == cycle_cast<ppu_cycle_t>(cpu_cycle_t(1000)));
+    }
+
+    SECTION("predicts the sprite 0 hit again")
+    {
+        // Rendering on, the old sprite 0 was under the screen
+        bus.write(0x2001, 0x18);
+        bus.scheduler.schedule(scheduler_event::sprite_zero_hit, ppu_frame_cycle);
+
+        // Sprite 0 at Y $20 in the new page
+        bus.ram[0x200] = 0x20;
+        bus.write(0x4014, 0x02);
+
+        REQUIRE(bus.ppu.get_next_sprite_zero_hit_cycle().has_value());
+        CHECK(bus.scheduler.get_cycle(scheduler_event::sprite_zero_hit) == cycle_t{*bus.ppu.get_next_sprite_zero_hit_cycle()});
+
+        // Nothing to hit below the screen
+        bus.ram[0x200] = 0xF0;
+        bus.write(0x4014, 0x02);
+
+        CHECK_FALSE(bus.scheduler.is_scheduled(scheduler_event::sprite_zero_hit));
+    }
+
+    SECTION("halts the cpu")
+    {
+        // LDA #$02, STA $4014, NOP
+        bus.ram[0x000] = 0xA9;
+        bus.ram[0x001] = 0x02;
+        bus.ram[0x002] = 0x8D;
+        bus.write_word(0x003, 0x4014);
+        bus.ram[0x005] = 0xEA;
+
+        auto& state = bus.cpu.get_state();
+
+        const auto stalled_cycle = [&bus, &state](cpu_cycle_t start_cycle) {
+            state.registers.pc = 0x0000;
+            state.cycle = start_cycle;
+
+            REQUIRE(bus.cpu.step());
+            REQUIRE(bus.cpu.step());
+
+            // The DMA takes the next step, before the NOP
+            REQUIRE(bus.cpu.step());
+            CHECK(state.registers.pc == 0x0005);
+
+            return state.cycle - start_cycle - cpu_cycle_t(6);
+        };
+
+        CHECK(stalled_cycle(cpu_cycle_t(0)) == cpu_cycle_t(513));
+        CHECK(stalled_cycle(cpu_cycle_t(1)) == cpu_cycle_t(514));
+
+        REQUIRE(bus.cpu.step());
+        CHECK(state.registers.pc == 0x0006);
+    }
+}
+
+} // namespace nese
@@ -138,4 +138,7 @@ struct cpu_bus_mock
     cpu_t cpu{*this};
 };
 
+// The whole address space is mocked, zero page and stack accesses go through read and write
+static_assert(!cpu_ram_bus<cpu_bus_mock>);
+
 } // namespace nese
@@ -0,0 +1,227 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <nese/cpu.hpp>
+#include <nese/cpu/cpu_call_stack.hpp>
+#include <nese/cpu_flat_bus.hpp>
+
+namespace nese {
+
+namespace {
+
+struct cpu_call_stack_policy : cpu_policy
+{
+    static constexpr bool call_stack = true;
+};
+
+struct cpu_cycle_accurate_call_stack_policy : cycle_accurate_cpu_policy
+{
+    static constexpr bool call_stack = true;
+};
+
+template<typename CpuPolicyT>
+void run_to(cpu_flat_bus<CpuPolicyT>& bus, addr_t addr)
+{
+    while (bus.cpu.get_state().registers.pc != addr)
+    {
+        REQUIRE(bus.cpu.step());
+    }
+}
+
+// JSR $0300, JSR $0310 from $0200, $0300 calls $0310 too, $0310 is NOP RTS
+template<typename CpuPolicyT>
+void load_nested_calls(cpu_flat_bus<CpuPolicyT>& bus)
+{
+    bus.load(0x0200, {0x20, 0x00, 0x03, 0x20, 0x10, 0x03});
+    bus.load(0x0300, {0x20, 0x10, 0x03, 0x60});
+    bus.load(0x0310, {0xEA, 0x60});
+}
+
+} // namespace
+
+TEST_CASE("cpu call stack", "[cpu]")
+{
+    cpu_flat_bus<cpu_call_stack_policy> bus;
+    bus.cpu.get_state().registers.pc = 0x0200;
+
+    const cpu_call_stack& call_stack = bus.cpu.get_call_stack();
+
+    SECTION("nested calls")
+    {
+        load_nested_calls(bus);
+
+        run_to(bus, 0x0311);
+
+        REQUIRE(call_stack.get_depth() == 2);
+        CHECK(call_stack.get_routine(0) == 0x0300);
+        CHECK(call_stack.get_routine(1) == 0x0310);
+
+        run_to(bus, 0x0206);
+
+        CHECK(call_stack.get_depth() == 0);
+
+        // JSR is paid by the caller, NOP and RTS by the callee
+        CHECK(call_stack.to_collapsed() == "root 12\n"
+                                           "root;$0300 12\n"
+                                           "root;$0300;$0310 8\n"
+                                           "root;$0310 8\n");
+
+        const std::vector<cpu_call_stack::routine> routines = call_stack.get_routines();
+
+        REQUIRE(routines.size() == 2);
+        CHECK(routines[0].addr == 0x0300);
+        CHECK(routines[0].calls == 1);
+        CHECK(routines[0].inclusive_cycles == 20);
+        CHECK(routines[0].exclusive_cycles == 12);
+        CHECK(routines[1].addr == 0x0310);
+        CHECK(routines[1].calls == 2);
+        CHECK(routines[1].inclusive_cycles == 16);
+        CHECK(routines[1].exclusive_cycles == 16);
+    }
+
+    SECTION("recursion is counted once")
+    {
+        // $0300 calls itself while $10 isn't zero: DEC $10, BEQ +3, JSR $0300, RTS
+        bus.load(0x0200, {0x20, 0x00, 0x03});
+        bus.load(0x0300, {0xC6, 0x10, 0xF0, 0x03, 0x20, 0x00, 0x03, 0x60});
+        bus.memory[0x0010] = 2;
+
+        run_to(bus, 0x0203);
+
+        const std::vector<cpu_call_stack::routine> routines = call_stack.get_routines();
+
+        REQUIRE(routines.size() == 1);
+        CHECK(routines[0].calls == 2);
+        CHECK(routines[0].inclusive_cycles == routines[0].exclusive_cycles);
+        CHECK(routines[0].inclusive_cycles + 6 == static_cast<u64_t>(bus.cpu.get_state().cycle.count()));
+    }
+
+    SECTION("rts jump table stays in the routine")
+    {
+        // LDA #$04, PHA, LDA #$0F, PHA, RTS to $0410
+        bus.load(0x0200, {0x20, 0x00, 0x03});
+        bus.load(0x0300, {0xA9, 0x04, 0x48, 0xA9, 0x0F, 0x48, 0x60});
+
+        run_to(bus, 0x0410);
+
+        REQUIRE(call_stack.get_depth() == 1);
+        CHECK(call_stack.get_routine(0) == 0x0300);
+    }
+
+    SECTION("pla pla leaves the routine")
+    {
+        // PLA, PLA, JMP $0400
+        bus.load(0x0200, {0x20, 0x00, 0x03});
+        bus.load(0x0300, {0x68, 0x68, 0x4C, 0x00, 0x04});
+
+        run_to(bus, 0x0301);
+        CHECK(call_stack.get_depth() == 1);
+
+        run_to(bus, 0x0302);
+        CHECK(call_stack.get_depth() == 0);
+
+        run_to(bus, 0x0400);
+        CHECK(call_stack.to_collapsed() == "root 9\n"
+                                           "root;$0300 8\n");
+    }
+
+    SECTION("interrupt")
+    {
+        // NOP, the handler at $0500 is RTI
+        bus.load(0x0200, {0xEA, 0xEA});
+        bus.load(0x0500, {0x40});
+        bus.write_word(0xFFFA, 0x0500);
+
+        // Seen by the poll before the next instruction
+        REQUIRE(bus.cpu.step());
+        bus.cpu.nmi(cycle_t{cpu_cycle_t(0)});
+
+        REQUIRE(bus.cpu.step());
+        REQUIRE(call_stack.get_depth() == 1);
+        CHECK(call_stack.get_routine(0) == 0x0500);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(call_stack.get_depth() == 0);
+        CHECK(bus.cpu.get_state().registers.pc == 0x0201);
+
+        // The sequence is paid by the interrupted code, RTI by the handler
+        CHECK(call_stack.to_collapsed() == "root 9\n"
+                                           "root;$0500 6\n");
+    }
+
+    SECTION("brk")
+    {
+        // BRK and its padding byte, the handler at $0500 is RTI
+        bus.load(0x0200, {0x00, 0xEA, 0xEA});
+        bus.load(0x0500, {0x40});
+        bus.write_word(0xFFFE, 0x0500);
+
+        REQUIRE(bus.cpu.step());
+        REQUIRE(call_stack.get_depth() == 1);
+        CHECK(call_stack.get_routine(0) == 0x0500);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(call_stack.get_depth() == 0);
+        CHECK(bus.cpu.get_state().registers.pc == 0x0202);
+
+        // BRK is paid by the caller like JSR, RTI by the handler
+        CHECK(call_stack.to_collapsed() == "root 7\n"
+                                           "root;$0500 6\n");
+    }
+
+    SECTION("call wrapping the stack")
+    {
+        // JSR $0300 with S=$00 pushes to $0100 and $01FF, $0300 is PHA PLA RTS
+        bus.load(0x0200, {0x20, 0x00, 0x03, 0xEA});
+        bus.load(0x0300, {0x48, 0x68, 0x60});
+        bus.cpu.get_state().registers.sp = 0x00;
+
+        run_to(bus, 0x0301);
+
+        // Pushing below the entry stays in the routine
+        REQUIRE(call_stack.get_depth() == 1);
+        CHECK(call_stack.get_routine(0) == 0x0300);
+
+        run_to(bus, 0x0203);
+
+        CHECK(call_stack.get_depth() == 0);
+        CHECK(bus.cpu.get_state().registers.sp == 0x00);
+    }
+
+    SECTION("reset leaves every routine")
+    {
+        load_nested_calls(bus);
+        bus.write_word(0xFFFC, 0x0200);
+
+        run_to(bus, 0x0310);
+        REQUIRE(call_stack.get_depth() == 2);
+
+        bus.cpu.reset();
+
+        CHECK(call_stack.get_depth() == 0);
+        CHECK(call_stack.get_routines().size() == 2);
+
+        bus.cpu.get_call_stack().clear();
+
+        CHECK(call_stack.get_routines().empty());
+        CHECK(call_stack.to_collapsed().empty());
+    }
+}
+
+TEST_CASE("cpu call stack cycle accurate", "[cpu][cycle_accurate]")
+{
+    cpu_flat_bus<cpu_call_stack_policy> fast;
+    cpu_flat_bus<cpu_cycle_accurate_call_stack_policy> accurate;
+
+    fast.cpu.get_state().registers.pc = 0x0200;
+    accurate.cpu.get_state().registers.pc = 0x0200;
+
+    load_nested_calls(fast);
+    load_nested_calls(accurate);
+
+    run_to(fast, 0x0206);
+    run_to(accurate, 0x0206);
+
+    CHECK(accurate.cpu.get_call_stack().to_collapsed() == fast.cpu.get_call_stack().to_collapsed());
+}
+
+} // namespace nese
@@ -0,0 +1,246 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <vector>
+
+#include <magic_enum.hpp>
+
+#include <nese/cpu.hpp>
+#include <nese/cpu_bus_mock.hpp>
+#include <nese/cpu_flat_bus.hpp>
+
+namespace nese {
+
+namespace {
+
+using bus_access = cpu_flat_bus_access;
+
+// Every access is recorded with the cpu cycle it happened at
+template<typename CpuPolicyT>
+struct recording_bus : cpu_flat_bus<CpuPolicyT>
+{
+    recording_bus()
+        : cpu_flat_bus<CpuPolicyT>(cpu_bus_mock::default_memory)
+    {
+        this->record_accesses = true;
+    }
+};
+
+using fast_bus = recording_bus<cpu_policy>;
+using cycle_accurate_bus = recording_bus<cycle_accurate_cpu_policy>;
+
+// One instruction at $0200 on both cores from the same registers
+template<typename BusT>
+void setup(BusT& bus, byte_t opcode, byte_t index, byte_t status)
+{
+    bus.memory[0x0200] = opcode;
+
+    cpu_registers& registers = bus.cpu.get_state().registers;
+    registers.pc = 0x0200;
+    registers.sp = 0xFD;
+    registers.a = 0x5A;
+    registers.x = index;
+    registers.y = index;
+    registers.status = status;
+}
+
+bus_access read_at(cpu_cycle_t cycle, addr_t addr, byte_t value)
+{
+    return {cycle, addr, value, false};
+}
+
+bus_access write_at(cpu_cycle_t cycle, addr_t addr, byte_t value)
+{
+    return {cycle, addr, value, true};
+}
+
+} // namespace
+
+TEST_CASE("cpu cycle accurate matches the fast core", "[cpu][cycle_accurate]")
+{
+    // No index with flags clear, then indexes crossing pages and every flag set to take the other branches
+    const auto [index, status] = GENERATE(std::pair<byte_t, byte_t>{0x00, 0x00}, std::pair<byte_t, byte_t>{0xFF, 0xFF});
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        const auto opcode = static_cast<cpu_opcode>(i);
+
+        CAPTURE(magic_enum::enum_name(opcode), index, status);
+
+        fast_bus fast;
+        cycle_accurate_bus accurate;
+
+        setup(fast, static_cast<byte_t>(i), index, status);
+        setup(accurate, static_cast<byte_t>(i), index, status);
+
+        REQUIRE(fast.cpu.step() == accurate.cpu.step());
+
+        const cpu_state& fast_state = fast.cpu.get_state();
+        const cpu_state& accurate_state = accurate.cpu.get_state();
+
+        CHECK(accurate_state.registers.pc == fast_state.registers.pc);
+        CHECK(accurate_state.registers.a == fast_state.registers.a);
+        CHECK(accurate_state.registers.x == fast_state.registers.x);
+        CHECK(accurate_state.registers.y == fast_state.registers.y);
+        CHECK(accurate_state.registers.sp == fast_state.registers.sp);
+        CHECK(accurate_state.registers.status == fast_state.registers.status);
+        CHECK(accurate_state.cycle == fast_state.cycle);
+        CHECK(accurate.memory == fast.memory);
+
+        // One access per cycle, BRK doesn't push yet
+        if (opcode != cpu_opcode::brk_implied)
+        {
+            REQUIRE(cpu_cycle_t(static_cast<cpu_cycle_t::rep>(accurate.accesses.size())) == accurate_state.cycle);
+
+            for (size_t j = 0; j < accurate.accesses.size(); ++j)
+            {
+                CHECK(accurate.accesses[j].cycle == cpu_cycle_t(static_cast<cpu_cycle_t::rep>(j)));
+            }
+        }
+    }
+}
+
+TEST_CASE("cpu cycle accurate bus accesses", "[cpu][cycle_accurate]")
+{
+    cycle_accurate_bus bus;
+
+    cpu_registers& registers = bus.cpu.get_state().registers;
+    registers.pc = 0x0200;
+    registers.sp = 0xFD;
+
+    SECTION("implied reads the next byte")
+    {
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::inx_implied);
+        bus.memory[0x0201] = 0x42;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(bus.accesses == std::vector{read_at(cpu_cycle_t(0), 0x0200, 0xE8), read_at(cpu_cycle_t(1), 0x0201, 0x42)});
+    }
+
+    SECTION("indexed read crossing a page")
+    {
+        // LDA $02F0,X
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::lda_absolute_x);
+        bus.memory[0x0201] = 0xF0;
+        bus.memory[0x0202] = 0x02;
+        bus.memory[0x0220] = 0x11;
+        bus.memory[0x0320] = 0x22;
+        registers.x = 0x30;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(registers.a == 0x22);
+        REQUIRE(bus.accesses.size() == 5);
+        CHECK(bus.accesses[3] == read_at(cpu_cycle_t(3), 0x0220, 0x11));
+        CHECK(bus.accesses[4] == read_at(cpu_cycle_t(4), 0x0320, 0x22));
+    }
+
+    SECTION("indexed read in the same page")
+    {
+        // LDA $0210,X
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::lda_absolute_x);
+        bus.memory[0x0201] = 0x10;
+        bus.memory[0x0202] = 0x02;
+        bus.memory[0x0220] = 0x11;
+        registers.x = 0x10;
+
+        REQUIRE(bus.cpu.step());
+
+        REQUIRE(bus.accesses.size() == 4);
+        CHECK(bus.accesses[3] == read_at(cpu_cycle_t(3), 0x0220, 0x11));
+    }
+
+    SECTION("indexed write always reads first")
+    {
+        // STA $0210,X
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::sta_absolute_x);
+        bus.memory[0x0201] = 0x10;
+        bus.memory[0x0202] = 0x02;
+        bus.memory[0x0220] = 0x11;
+        registers.a = 0x33;
+        registers.x = 0x10;
+
+        REQUIRE(bus.cpu.step());
+
+        REQUIRE(bus.accesses.size() == 5);
+        CHECK(bus.accesses[3] == read_at(cpu_cycle_t(3), 0x0220, 0x11));
+        CHECK(bus.accesses[4] == write_at(cpu_cycle_t(4), 0x0220, 0x33));
+    }
+
+    SECTION("read-modify-write writes twice")
+    {
+        // INC $0300
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::inc_absolute);
+        bus.memory[0x0201] = 0x00;
+        bus.memory[0x0202] = 0x03;
+        bus.memory[0x0300] = 0x41;
+
+        REQUIRE(bus.cpu.step());
+
+        REQUIRE(bus.accesses.size() == 6);
+        CHECK(bus.accesses[3] == read_at(cpu_cycle_t(3), 0x0300, 0x41));
+        CHECK(bus.accesses[4] == write_at(cpu_cycle_t(4), 0x0300, 0x41));
+        CHECK(bus.accesses[5] == write_at(cpu_cycle_t(5), 0x0300, 0x42));
+    }
+
+    SECTION("jsr reads the high byte after the pushes")
+    {
+        // JSR $1234
+        bus.memory[0x0200] = static_cast<byte_t>(cpu_opcode::jsr_absolute);
+        bus.memory[0x0201] = 0x34;
+        bus.memory[0x0202] = 0x12;
+
+        const byte_t stack_value = bus.memory[0x01FD];
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(registers.pc == 0x1234);
+        CHECK(bus.accesses == std::vector{read_at(cpu_cycle_t(0), 0x0200, 0x20),
+                                          read_at(cpu_cycle_t(1), 0x0201, 0x34),
+                                          read_at(cpu_cycle_t(2), 0x01FD, stack_value),
+                                          write_at(cpu_cycle_t(3), 0x01FD, 0x02),
+                                          write_at(cpu_cycle_t(4), 0x01FC, 0x02),
+                                          read_at(cpu_cycle_t(5), 0x0202, 0x12)});
+    }
+
+    SECTION("taken branch crossing a page")
+    {
+        // BNE +$10 at $02F0
+        registers.pc = 0x02F0;
+        bus.memory[0x02F0] = static_cast<byte_t>(cpu_opcode::bne_relative);
+        bus.memory[0x02F1] = 0x10;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(registers.pc == 0x0302);
+        REQUIRE(bus.accesses.size() == 4);
+        CHECK(bus.accesses[2].addr == 0x02F2);
+        CHECK(bus.accesses[3].addr == 0x0202);
+    }
+
+    SECTION("interrupt sequence")
+    {
+        bus.write_word(0xFFFA, 0x9000);
+        bus.accesses.clear();
+
+        // Seen by the poll before the next instruction
+        bus.cpu.get_state().cycle = cpu_cycle_t(10);
+        bus.cpu.nmi(cycle_t{cpu_cycle_t(8)});
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(registers.pc == 0x9000);
+        REQUIRE(bus.accesses.size() == 7);
+        CHECK(bus.accesses[0].addr == 0x0200);
+        CHECK(bus.accesses[1].addr == 0x0200);
+        CHECK(bus.accesses[2] == write_at(cpu_cycle_t(12), 0x01FD, 0x02));
+        CHECK(bus.accesses[3] == write_at(cpu_cycle_t(13), 0x01FC, 0x00));
+        CHECK(bus.accesses[4].is_write);
+        CHECK(bus.accesses[5] == read_at(cpu_cycle_t(15), 0xFFFA, 0x00));
+        CHECK(bus.accesses[6] == read_at(cpu_cycle_t(16), 0xFFFB, 0x90));
+        CHECK(bus.cpu.get_state().cycle == cpu_cycle_t(17));
+    }
+}
+
+} // namespace nese
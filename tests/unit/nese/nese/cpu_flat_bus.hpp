@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+#include <nese/basic_types.hpp>
+#include <nese/cpu.hpp>
+
+namespace nese {
+
+struct cpu_flat_bus_access
+{
+    cpu_cycle_t cycle{0};
+    addr_t addr{0};
+    byte_t value{0};
+    bool is_write{false};
+
+    friend bool operator==(const cpu_flat_bus_access&, const cpu_flat_bus_access&) = default;
+};
+
+// Whole address space in memory for the tests running the cpu on another policy than cpu_bus_mock
+// Writes to $8000-$FFFF behave like a bank switch of the written page, the accesses are recorded with their cpu cycle on demand
+template<typename CpuPolicyT = cpu_policy>
+struct cpu_flat_bus
+{
+    using memory_t = array<byte_t, 0x10000>;
+
+    cpu_flat_bus() = default;
+
+    explicit cpu_flat_bus(const memory_t& initial_memory)
+        : memory(initial_memory)
+    {
+    }
+
+    [[nodiscard]] byte_t read(addr_t addr)
+    {
+        if (record_accesses)
+        {
+            accesses.push_back({cpu.get_state().cycle, addr, memory[addr], false});
+        }
+
+        return memory[addr];
+    }
+
+    [[nodiscard]] word_t read_word(addr_t addr)
+    {
+        return read(addr) + static_cast<word_t>(static_cast<word_t>(read(addr + 1)) << 8);
+    }
+
+    void write(addr_t addr, byte_t value)
+    {
+        if (record_accesses)
+        {
+            accesses.push_back({cpu.get_state().cycle, addr, value, true});
+        }
+
+        memory[addr] = value;
+
+        if (cpu_predecode_cache::contains(addr))
+        {
+            cpu.invalidate_predecode(static_cast<u8_t>(1 << ((addr - cpu_predecode_cache::begin_addr) / cpu_predecode_cache::page_size)));
+        }
+    }
+
+    void write_word(addr_t addr, word_t value)
+    {
+        write(addr, static_cast<byte_t>(value & 0xff));
+        write(addr + 1, static_cast<byte_t>(value >> 8));
+    }
+
+    // Copy without going through write, nothing is recorded
+    void load(addr_t addr, std::initializer_list<byte_t> bytes)
+    {
+        std::copy(bytes.begin(), bytes.end(), memory.begin() + addr);
+    }
+
+    memory_t memory{};
+
+    bool record_accesses{false};
+    std::vector<cpu_flat_bus_access> accesses;
+
+    cpu<cpu_flat_bus, CpuPolicyT> cpu{*this};
+};
+
+} // namespace nese
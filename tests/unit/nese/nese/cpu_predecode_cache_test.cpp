@@ -0,0 +1,360 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
+
+#include <nese/cpu.hpp>
+#include <nese/cpu/cpu_predecode_cache.hpp>
+#include <nese/cpu_flat_bus.hpp>
+
+namespace nese {
+
+namespace {
+
+struct cpu_predecode_policy : cpu_policy
+{
+    static constexpr bool predecode = true;
+};
+
+struct cpu_block_cache_policy : cpu_predecode_policy
+{
+    static constexpr bool block_cache = true;
+};
+
+struct cpu_idle_loop_policy : cpu_block_cache_policy
+{
+    static constexpr bool idle_loop_skip = true;
+};
+
+struct cpu_fusion_policy : cpu_block_cache_policy
+{
+    static constexpr bool fusion = true;
+};
+
+struct cpu_pair_profiling_policy : cpu_policy
+{
+    static constexpr bool pair_profiling = true;
+};
+
+} // namespace
+
+TEST_CASE("cpu_predecode_cache invalidate", "[cpu][predecode]")
+{
+    cpu_predecode_cache cache;
+
+    cache[0x8000] = {.operand = 0x1234, .opcode = 0xAD, .operand_size = 2};
+    cache[0x8FFE] = {.operand = 0x1234, .opcode = 0xAD, .operand_size = 2};
+    cache[0x9000] = {.operand = 0x12, .opcode = 0xA9, .operand_size = 1};
+
+    SECTION("page")
+    {
+        cache.invalidate(0b0000'0010);
+
+        CHECK(cache[0x8000].is_valid());
+        CHECK_FALSE(cache[0x8FFE].is_valid()); // operand in the invalidated page
+        CHECK_FALSE(cache[0x9000].is_valid());
+    }
+
+    SECTION("all")
+    {
+        cache.invalidate();
+
+        CHECK_FALSE(cache[0x8000].is_valid());
+        CHECK_FALSE(cache[0x8FFE].is_valid());
+        CHECK_FALSE(cache[0x9000].is_valid());
+    }
+}
+
+TEST_CASE("cpu predecode", "[cpu][predecode]")
+{
+    cpu_flat_bus<cpu_predecode_policy> bus;
+
+    // LDA #$42, LDA $0010
+    bus.memory[0x8000] = 0xA9;
+    bus.memory[0x8001] = 0x42;
+    bus.memory[0x8002] = 0xAD;
+    bus.memory[0x8003] = 0x10;
+    bus.memory[0x8004] = 0x00;
+    bus.memory[0x0010] = 0x24;
+
+    const auto run_program = [&bus] {
+        bus.cpu.get_state().registers.pc = 0x8000;
+        REQUIRE(bus.cpu.step());
+        REQUIRE(bus.cpu.get_state().registers.a == 0x42);
+        REQUIRE(bus.cpu.step());
+        REQUIRE(bus.cpu.get_state().registers.a == 0x24);
+        REQUIRE(bus.cpu.get_state().registers.pc == 0x8005);
+    };
+
+    run_program();
+
+    CHECK(bus.cpu.get_predecode_cache().get_miss_count() == 2);
+    CHECK(bus.cpu.get_predecode_cache().get_hit_count() == 0);
+
+    run_program();
+
+    CHECK(bus.cpu.get_predecode_cache().get_miss_count() == 2);
+    CHECK(bus.cpu.get_predecode_cache().get_hit_count() == 2);
+
+    SECTION("stale until invalidated")
+    {
+        bus.memory[0x8001] = 0x43;
+
+        bus.cpu.get_state().registers.pc = 0x8000;
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu.get_state().registers.a == 0x42);
+
+        bus.cpu.invalidate_predecode(0b0000'0001);
+
+        bus.cpu.get_state().registers.pc = 0x8000;
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu.get_state().registers.a == 0x43);
+    }
+
+    SECTION("operand wrapping to RAM is not cached")
+    {
+        // LDA #imm at $FFFF, the operand is read from $0000
+        bus.memory[0xFFFF] = 0xA9;
+        bus.memory[0x0000] = 0x11;
+
+        bus.cpu.get_state().registers.pc = 0xFFFF;
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu.get_state().registers.a == 0x11);
+
+        bus.memory[0x0000] = 0x22;
+
+        bus.cpu.get_state().registers.pc = 0xFFFF;
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu.get_state().registers.a == 0x22);
+    }
+}
+
+TEST_CASE("cpu block cache", "[cpu][predecode]")
+{
+    cpu_flat_bus<cpu_block_cache_policy> bus;
+
+    // LDA #$01, STA $8006, LDA #$42, the store patches the operand of the next instruction of the block
+    constexpr array<byte_t, 7> program{0xA9, 0x01, 0x8D, 0x06, 0x80, 0xA9, 0x42};
+    std::copy(program.begin(), program.end(), bus.memory.begin() + 0x8000);
+
+    bus.cpu.get_state().registers.pc = 0x8000;
+    bus.cpu.get_state().cycle = cpu_cycle_t(0);
+
+    REQUIRE(bus.cpu.run(cpu_cycle_t(8)));
+
+    CHECK(bus.cpu.get_state().registers.pc == 0x8007);
+    CHECK(bus.cpu.get_state().registers.a == 0x01);
+    CHECK(bus.cpu.get_predecode_cache().get_block_miss_count() == 2);
+
+    SECTION("block reused")
+    {
+        bus.cpu.get_state().registers.pc = 0x8005;
+
+        REQUIRE(bus.cpu.run(cpu_cycle_t(2)));
+
+        CHECK(bus.cpu.get_state().registers.a == 0x01);
+        CHECK(bus.cpu.get_predecode_cache().get_block_hit_count() == 1);
+    }
+}
+
+TEST_CASE("cpu idle loop", "[cpu][predecode]")
+{
+    cpu_flat_bus<cpu_block_cache_policy> expected_bus;
+    cpu_flat_bus<cpu_idle_loop_policy> bus;
+
+    const auto run_program = [&](std::initializer_list<byte_t> program, cpu_cycle_t cycles) {
+        for (auto* memory : {&expected_bus.memory, &bus.memory})
+        {
+            std::copy(program.begin(), program.end(), memory->begin() + 0x8000);
+        }
+
+        expected_bus.cpu.get_state().registers.pc = 0x8000;
+        expected_bus.cpu.get_state().cycle = cpu_cycle_t(0);
+        bus.cpu.get_state().registers.pc = 0x8000;
+        bus.cpu.get_state().cycle = cpu_cycle_t(0);
+
+        REQUIRE(expected_bus.cpu.run(cycles));
+        REQUIRE(bus.cpu.run(cycles));
+
+        // Skipping must land on the same instruction and cycle as running every iteration
+        CHECK(bus.cpu.get_state().registers == expected_bus.cpu.get_state().registers);
+        CHECK(bus.cpu.get_state().cycle == expected_bus.cpu.get_state().cycle);
+    };
+
+    SECTION("polling RAM")
+    {
+        // LDA $0010, BEQ $8000, 7 cycles an iteration
+        run_program({0xAD, 0x10, 0x00, 0xF0, 0xFB}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() >= cpu_cycle_t(1000 - 3 * 7));
+    }
+
+    SECTION("polling the PPU status")
+    {
+        // BIT $2002, BPL $8000
+        bus.memory[0x2002] = 0x00;
+        expected_bus.memory[0x2002] = 0x00;
+
+        run_program({0x2C, 0x02, 0x20, 0x10, 0xFB}, cpu_cycle_t(1001));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() > cpu_cycle_t(0));
+    }
+
+    SECTION("polling the sprite overflow is not skipped")
+    {
+        // LDA $2002, AND #$20, BEQ $8000
+        bus.memory[0x2002] = 0x00;
+        expected_bus.memory[0x2002] = 0x00;
+
+        run_program({0xAD, 0x02, 0x20, 0x29, 0x20, 0xF0, 0xF9}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() == cpu_cycle_t(0));
+    }
+
+    SECTION("testing the sprite overflow with BIT is not skipped")
+    {
+        // LDA #$20 before, BIT $2002, BEQ $8002
+        bus.memory[0x2002] = 0x00;
+        expected_bus.memory[0x2002] = 0x00;
+
+        run_program({0xA9, 0x20, 0x2C, 0x02, 0x20, 0xF0, 0xFB}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() == cpu_cycle_t(0));
+    }
+
+    SECTION("jump to itself")
+    {
+        run_program({0x4C, 0x00, 0x80}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() > cpu_cycle_t(0));
+    }
+
+    SECTION("counting loop is not skipped")
+    {
+        // INX, BNE $8000
+        run_program({0xE8, 0xD0, 0xFD}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() == cpu_cycle_t(0));
+        CHECK_FALSE(bus.cpu.get_predecode_cache()[0x8000].is_idle_loop);
+    }
+
+    SECTION("loop writing memory is not skipped")
+    {
+        // STA $0010, BEQ $8000
+        bus.cpu.get_state().registers.status = static_cast<byte_t>(cpu_status::zero | cpu_status::unused);
+        expected_bus.cpu.get_state().registers.status = static_cast<byte_t>(cpu_status::zero | cpu_status::unused);
+
+        run_program({0x8D, 0x10, 0x00, 0xF0, 0xFB}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() == cpu_cycle_t(0));
+    }
+
+    SECTION("reading a side effect register is not skipped")
+    {
+        // LDA $4016, BEQ $8000
+        run_program({0xAD, 0x16, 0x40, 0xF0, 0xFB}, cpu_cycle_t(1000));
+
+        CHECK(bus.cpu.get_idle_loop_cycles() == cpu_cycle_t(0));
+    }
+}
+
+TEST_CASE("cpu fusion", "[cpu][predecode]")
+{
+    cpu_flat_bus<cpu_block_cache_policy> expected_bus;
+    cpu_flat_bus<cpu_fusion_policy> bus;
+
+    // clang-format off
+    constexpr array<byte_t, 38> program{
+        0xA2, 0x03,       // 8000: LDX #$03
+        0xA0, 0x02,       // 8002: LDY #$02
+        0x88,             // 8004: DEY
+        0xD0, 0xFD,       // 8005: BNE $8004
+        0xCA,             // 8007: DEX
+        0xD0, 0xF8,       // 8008: BNE $8002
+        0xE6, 0x10,       // 800A: INC $10
+        0xA5, 0x10,       // 800C: LDA $10
+        0x8D, 0x00, 0x03, // 800E: STA $0300
+        0xC9, 0x04,       // 8011: CMP #$04
+        0xD0, 0xEB,       // 8013: BNE $8000
+        0xC6, 0x11,       // 8015: DEC $11
+        0xD0, 0xFC,       // 8017: BNE $8015
+        0xE8,             // 8019: INX
+        0xD0, 0xFD,       // 801A: BNE $8019
+        0xC8,             // 801C: INY
+        0xD0, 0xFD,       // 801D: BNE $801C
+        0xC9, 0x00,       // 801F: CMP #$00
+        0xF0, 0xDD,       // 8021: BEQ $8000
+        0x4C, 0x00, 0x80  // 8023: JMP $8000
+    };
+    // clang-format on
+
+    for (auto* memory : {&expected_bus.memory, &bus.memory})
+    {
+        std::copy(program.begin(), program.end(), memory->begin() + 0x8000);
+    }
+
+    // Stop at every cycle of the start then in long runs, to_cycle must split the pairs like the instructions
+    for (const s64_t cycles : {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 100, 1000, 10000, 100000})
+    {
+        for (auto* memory : {&expected_bus.memory, &bus.memory})
+        {
+            std::fill_n(memory->begin(), 0x800, byte_t{0});
+        }
+
+        expected_bus.cpu.get_state().registers = {.pc = 0x8000};
+        expected_bus.cpu.get_state().cycle = cpu_cycle_t(0);
+        bus.cpu.get_state().registers = {.pc = 0x8000};
+        bus.cpu.get_state().cycle = cpu_cycle_t(0);
+
+        REQUIRE(expected_bus.cpu.run(cpu_cycle_t(cycles)));
+        REQUIRE(bus.cpu.run(cpu_cycle_t(cycles)));
+
+        CHECK(bus.cpu.get_state().registers == expected_bus.cpu.get_state().registers);
+        CHECK(bus.cpu.get_state().cycle == expected_bus.cpu.get_state().cycle);
+        CHECK(std::equal(bus.memory.begin(), bus.memory.begin() + 0x800, expected_bus.memory.begin()));
+    }
+
+    const cpu_predecode_cache& cache = bus.cpu.get_predecode_cache();
+
+    CHECK(cache[0x8004].fused_pair == get_fused_pair(0x88, 0xD0));
+    CHECK(cache[0x8007].fused_pair == get_fused_pair(0xCA, 0xD0));
+    CHECK(cache[0x800C].fused_pair == get_fused_pair(0xA5, 0x8D));
+    CHECK(cache[0x8011].fused_pair == get_fused_pair(0xC9, 0xD0));
+    CHECK(cache[0x8021].fused_pair == 0);
+}
+
+TEST_CASE("cpu pair histogram", "[cpu]")
+{
+    cpu_flat_bus<cpu_pair_profiling_policy> bus;
+
+    // LDX #$02, DEX, BNE $8002
+    constexpr array<byte_t, 5> program{0xA2, 0x02, 0xCA, 0xD0, 0xFD};
+    std::copy(program.begin(), program.end(), bus.memory.begin() + 0x8000);
+
+    bus.cpu.get_state().registers.pc = 0x8000;
+
+    while (bus.cpu.get_state().registers.pc != 0x8005)
+    {
+        REQUIRE(bus.cpu.step());
+    }
+
+    const cpu_pair_histogram& histogram = bus.cpu.get_pair_histogram();
+
+    CHECK(histogram.get_count(0xA2, 0xCA) == 1);
+    CHECK(histogram.get_count(0xCA, 0xD0) == 2);
+    CHECK(histogram.get_count(0xD0, 0xCA) == 1);
+    CHECK(histogram.get_count(0xD0, 0xA2) == 0);
+
+    const std::vector<cpu_pair_histogram::entry> most_frequent = histogram.get_most_frequent(2);
+
+    REQUIRE(most_frequent.size() == 2);
+    CHECK(most_frequent[0].first == 0xCA);
+    CHECK(most_frequent[0].second == 0xD0);
+    CHECK(most_frequent[0].count == 2);
+    CHECK(most_frequent[1].count == 1);
+
+    CHECK(histogram.get_most_frequent(10).size() == 3);
+}
+
+} // namespace nese
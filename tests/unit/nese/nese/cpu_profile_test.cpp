@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+#include <nese/cpu.hpp>
+#include <nese/cpu/cpu_profile.hpp>
+#include <nese/cpu_flat_bus.hpp>
+
+namespace nese {
+
+namespace {
+
+struct cpu_profiling_policy : cpu_policy
+{
+    static constexpr bool profiling = true;
+};
+
+struct cpu_cycle_accurate_profiling_policy : cycle_accurate_cpu_policy
+{
+    static constexpr bool profiling = true;
+};
+
+// LDX #$02, LDY #$20, LDA $02F0,Y, DEX, BNE $0204
+template<typename CpuPolicyT>
+void run_profiled_loop(cpu_flat_bus<CpuPolicyT>& bus)
+{
+    constexpr array<byte_t, 10> program{0xA2, 0x02, 0xA0, 0x20, 0xB9, 0xF0, 0x02, 0xCA, 0xD0, 0xFA};
+    std::copy(program.begin(), program.end(), bus.memory.begin() + 0x0200);
+
+    cpu_registers& registers = bus.cpu.get_state().registers;
+    registers.pc = 0x0200;
+    registers.status = 0;
+
+    while (registers.pc != 0x020A)
+    {
+        REQUIRE(bus.cpu.step());
+    }
+}
+
+} // namespace
+
+TEST_CASE("cpu profile", "[cpu]")
+{
+    cpu_flat_bus<cpu_profiling_policy> bus;
+
+    const cpu_profile& profile = bus.cpu.get_profile();
+
+    SECTION("loop")
+    {
+        run_profiled_loop(bus);
+
+        CHECK(profile.get_opcode(0xA2).executions == 1);
+        CHECK(profile.get_opcode(0xA2).cycles == 2);
+
+        CHECK(profile.get_opcode(0xB9).executions == 2);
+        CHECK(profile.get_opcode(0xB9).cycles == 10);
+        CHECK(profile.get_opcode(0xB9).page_crossings == 2);
+
+        // Taken once
+        CHECK(profile.get_opcode(0xD0).executions == 2);
+        CHECK(profile.get_opcode(0xD0).cycles == 5);
+        CHECK(profile.get_opcode(0xD0).page_crossings == 0);
+
+        CHECK(profile.get_opcode(0xEA).executions == 0);
+
+        const cpu_profile::entry immediate = profile.get_addr_mode(cpu_addr_mode::immediate);
+        CHECK(immediate.executions == 2);
+        CHECK(immediate.cycles == 4);
+
+        const cpu_profile::entry total = profile.get_total();
+        CHECK(total.executions == 8);
+        CHECK(total.cycles == static_cast<u64_t>(bus.cpu.get_state().cycle.count()));
+        CHECK(total.page_crossings == 2);
+
+        const string json = profile.to_json();
+
+        // Most cycles first
+        CHECK(json.find(R"({"opcode": 185, "mnemonic": "lda", "addr_mode": "absolute_y", "executions": 2, "cycles": 10, "page_crossings": 2})") < json.find(R"("mnemonic": "bne")"));
+        CHECK(json.find(R"({"addr_mode": "implied", "executions": 2, "cycles": 4, "page_crossings": 0})") != string::npos);
+        CHECK(json.find(R"("mnemonic": "nop")") == string::npos);
+
+        bus.cpu.get_profile().clear();
+
+        CHECK(profile.get_total().executions == 0);
+    }
+
+    SECTION("branch crossing a page")
+    {
+        // BNE +$10 at $02FD
+        bus.memory[0x02FD] = 0xD0;
+        bus.memory[0x02FE] = 0x10;
+
+        cpu_registers& registers = bus.cpu.get_state().registers;
+        registers.pc = 0x02FD;
+        registers.status = 0;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(registers.pc == 0x030F);
+        CHECK(profile.get_opcode(0xD0).cycles == 4);
+        CHECK(profile.get_opcode(0xD0).page_crossings == 1);
+    }
+}
+
+TEST_CASE("cpu profile cycle accurate", "[cpu][cycle_accurate]")
+{
+    cpu_flat_bus<cpu_profiling_policy> fast;
+    cpu_flat_bus<cpu_cycle_accurate_profiling_policy> accurate;
+
+    run_profiled_loop(fast);
+    run_profiled_loop(accurate);
+
+    // The dummy reads spend the same cycles, the page crossings are counted the same
+    CHECK(accurate.cpu.get_profile().to_json() == fast.cpu.get_profile().to_json());
+}
+
+} // namespace nese
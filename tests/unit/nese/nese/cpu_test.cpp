@@ -1,4 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+
+#include <magic_enum.hpp>
 
 #include <nese/cpu.hpp>
 #include <nese/cpu_fixture.hpp>
@@ -873,6 +878,56 @@ TEST_CASE_METHOD(cpu_branch_if_clear_fixture, "bpl", "[cpu][instruction]")
     test_relative(cpu_opcode::bpl_relative, behavior_scenarios<cpu_status::negative>);
 }
 
+TEST_CASE_METHOD(cpu_fixture, "brk", "[cpu][instruction]")
+{
+    static constexpr cpu_cycle_t cycle_cost = cpu_cycle_t(7);
+    static constexpr cpu_status mandatory_flags = static_cast<cpu_status>(0x30);
+
+    // The opcode is at $0200, the return address skips the padding byte at $0201
+    // clang-format off
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        // vector
+        {
+            .initial = {set_sp(0xFF), set_memoryw(0xFFFE, 0x0400)},
+            .expected = {set_pc(0x0400), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(mandatory_flags)), set_status_interrupt()},
+            .cycle_cost = cycle_cost
+        },
+        {
+            .initial = {set_sp(0xFF), set_memoryw(0xFFFE, 0xC123)},
+            .expected = {set_pc(0xC123), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(mandatory_flags)), set_status_interrupt()},
+            .cycle_cost = cycle_cost
+        },
+
+        // stack wrap
+        {
+            .initial = {set_sp(0x01), set_memoryw(0xFFFE, 0x0400)},
+            .expected = {set_pc(0x0400), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(mandatory_flags)), set_status_interrupt()},
+            .description = "SP at 01 to simulate edge case of wrapping around from 0x0100 to 0x01FF",
+            .cycle_cost = cycle_cost
+        },
+
+        // flag pushed
+        {
+            .initial = {set_sp(0xFF), set_status(cpu_status::carry), set_memoryw(0xFFFE, 0x0400)},
+            .expected = {set_pc(0x0400), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(cpu_status::carry | mandatory_flags)), set_status_interrupt()},
+            .cycle_cost = cycle_cost
+        },
+        {
+            .initial = {set_sp(0xFF), set_status(cpu_status::negative), set_memoryw(0xFFFE, 0x0400)},
+            .expected = {set_pc(0x0400), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(cpu_status::negative | mandatory_flags)), set_status_interrupt()},
+            .cycle_cost = cycle_cost
+        },
+        {
+            .initial = {set_sp(0xFF), set_status(cpu_status::interrupt), set_memoryw(0xFFFE, 0x0400)},
+            .expected = {set_pc(0x0400), push_stack(0x02), push_stack(0x02), push_stack(static_cast<byte_t>(cpu_status::interrupt | mandatory_flags))},
+            .cycle_cost = cycle_cost
+        },
+    });
+    // clang-format on
+
+    test_implied(cpu_opcode::brk_implied, behavior_scenarios);
+}
+
 TEST_CASE_METHOD(cpu_branch_if_clear_fixture, "bvc", "[cpu][instruction]")
 {
     test_relative(cpu_opcode::bvc_relative, behavior_scenarios<cpu_status::overflow>);
@@ -2061,7 +2116,139 @@ TEST_CASE_METHOD(cpu_transfer_fixture, "tya", "[cpu][instruction]")
     test_implied(cpu_opcode::tya_implied, behavior_scenarios<cpu_register_id::y, cpu_register_id::a>);
 }
 
-#if NESE_UNOFFICIAL_INSTRUCTIONS_ENABLED
+
+TEST_CASE_METHOD(cpu_fixture, "alr", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_operand(0x00)},
+        .expected = {set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0xFF), set_operand(0x06)},
+            .expected = {set_a(0x03)}
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0x03)},
+            .expected = {set_a(0x01), set_status_carry()}
+        },
+        {
+            .initial = {set_a(0x0F), set_operand(0x01)},
+            .expected = {set_a(0x00), set_status_carry(), set_status_zero()}
+        },
+        {
+            .initial = {set_a(0xF0), set_operand(0x0F), set_status_carry()},
+            .expected = {set_a(0x00), clear_status_carry(), set_status_zero()}
+        }
+    });
+    // clang-format on
+
+    test_immediate(cpu_opcode::alr_immediate_unofficial, addr_mode_scenario, behavior_scenarios);
+}
+
+TEST_CASE_METHOD(cpu_fixture, "anc", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_operand(0x00)},
+        .expected = {set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0xFF), set_operand(0x7F)},
+            .expected = {set_a(0x7F)}
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0x80)},
+            .expected = {set_a(0x80), set_status_carry(), set_status_negative()}
+        },
+        {
+            .initial = {set_a(0x0F), set_operand(0xF0), set_status_carry()},
+            .expected = {set_a(0x00), clear_status_carry(), set_status_zero()}
+        }
+    });
+    // clang-format on
+
+    const cpu_opcode opcode = GENERATE(cpu_opcode::anc_immediate_unofficial_0B, cpu_opcode::anc_immediate_unofficial_2B);
+
+    test_immediate(opcode, addr_mode_scenario, behavior_scenarios);
+}
+
+TEST_CASE_METHOD(cpu_fixture, "arr", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_operand(0x00)},
+        .expected = {set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0xFF), set_operand(0x01)},
+            .expected = {set_a(0x00), set_status_zero()},
+            .description = "bit 0 is dropped"
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0x00), set_status_carry()},
+            .expected = {set_a(0x80), clear_status_carry(), set_status_negative()},
+            .description = "carry rotated in"
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0x40)},
+            .expected = {set_a(0x20), set_status_overflow()},
+            .description = "bit 5 set, overflow"
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0x80)},
+            .expected = {set_a(0x40), set_status_carry(), set_status_overflow()},
+            .description = "bit 6 set, carry and overflow"
+        },
+        {
+            .initial = {set_a(0xFF), set_operand(0xC0)},
+            .expected = {set_a(0x60), set_status_carry()},
+            .description = "bit 6 and 5 set, carry"
+        }
+    });
+    // clang-format on
+
+    test_immediate(cpu_opcode::arr_immediate_unofficial, addr_mode_scenario, behavior_scenarios);
+}
+
+TEST_CASE_METHOD(cpu_fixture, "axs", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_x(0x00), set_operand(0x00)},
+        .expected = {set_status_carry(), set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0x0F), set_x(0xFF), set_operand(0x01)},
+            .expected = {set_x(0x0E), set_status_carry()}
+        },
+        {
+            .initial = {set_a(0xFF), set_x(0x05), set_operand(0x05)},
+            .expected = {set_x(0x00), set_status_carry(), set_status_zero()}
+        },
+        {
+            .initial = {set_a(0xFF), set_x(0x01), set_operand(0x02)},
+            .expected = {set_x(0xFF), set_status_negative()},
+            .description = "borrow"
+        },
+        {
+            .initial = {set_a(0xFF), set_x(0x01), set_operand(0x02), set_status_carry()},
+            .expected = {set_x(0xFF), clear_status_carry(), set_status_negative()},
+            .description = "carry ignored"
+        }
+    });
+    // clang-format on
+
+    test_immediate(cpu_opcode::axs_immediate_unofficial, addr_mode_scenario, behavior_scenarios);
+}
 
 TEST_CASE_METHOD(cpu_fixture, "dcp", "[cpu][instruction]")
 {
@@ -2300,6 +2487,34 @@ TEST_CASE_METHOD(cpu_fixture, "lax", "[cpu][instruction]")
     test_indirect_indexed(cpu_opcode::lax_indirect_indexed_unofficial, addr_mode_scenario, behavior_scenarios);
 }
 
+TEST_CASE_METHOD(cpu_fixture, "lxa", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_operand(0x00)},
+        .expected = {set_x(0x00), set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0x00), set_operand(0xFF)},
+            .expected = {set_a(0xEE), set_x(0xEE), set_status_negative()},
+            .description = "unstable constant"
+        },
+        {
+            .initial = {set_a(0x11), set_x(0x22), set_operand(0x1F)},
+            .expected = {set_a(0x1F), set_x(0x1F)}
+        },
+        {
+            .initial = {set_a(0x00), set_x(0x22), set_operand(0x11)},
+            .expected = {set_a(0x00), set_x(0x00), set_status_zero()}
+        }
+    });
+    // clang-format on
+
+    test_immediate(cpu_opcode::lxa_immediate_unofficial, addr_mode_scenario, behavior_scenarios);
+}
+
 TEST_CASE_METHOD(cpu_fixture, "sax", "[cpu][instruction]")
 {
     // clang-format off
@@ -2458,6 +2673,322 @@ TEST_CASE_METHOD(cpu_fixture, "slo", "[cpu][instruction]")
     test_indirect_indexed(cpu_opcode::slo_indirect_indexed_unofficial, addr_mode_scenario, behavior_scenarios);
 }
 
-#endif
+
+TEST_CASE_METHOD(cpu_fixture, "xaa", "[cpu][instruction]")
+{
+    // clang-format off
+    static const scenario addr_mode_scenario{
+        .initial = {set_a(0x00), set_x(0x00), set_operand(0x00)},
+        .expected = {set_status_zero()}
+    };
+
+    static const std::array behavior_scenarios = std::to_array<scenario>({
+        {
+            .initial = {set_a(0x00), set_x(0xFF), set_operand(0xFF)},
+            .expected = {set_a(0xEE), set_status_negative()},
+            .description = "unstable constant"
+        },
+        {
+            .initial = {set_a(0x11), set_x(0x3F), set_operand(0x7F)},
+            .expected = {set_a(0x3F)}
+        },
+        {
+            .initial = {set_a(0xFF), set_x(0x0F), set_operand(0xF0)},
+            .expected = {set_a(0x00), set_status_zero()}
+        }
+    });
+    // clang-format on
+
+    test_immediate(cpu_opcode::xaa_immediate_unofficial, addr_mode_scenario, behavior_scenarios);
+}
+
+TEST_CASE("cpu illegal stores", "[cpu][instruction]")
+{
+    cpu_bus_mock bus;
+
+    bus.cpu_registers().pc = 0x8000;
+
+    SECTION("shy")
+    {
+        bus.write(0x8000, static_cast<byte_t>(cpu_opcode::shy_absolute_x_unofficial));
+        bus.write_word(0x8001, 0x1210);
+        bus.cpu_registers().x = 0x01;
+        bus.cpu_registers().y = 0xFF;
+
+        REQUIRE(bus.cpu.step());
+
+        // ANDed with the high byte + 1
+        CHECK(bus.read(0x1211) == 0x13);
+        CHECK(bus.cpu_state().cycle == cpu_cycle_t(5));
+    }
+
+    SECTION("shy crossing a page")
+    {
+        bus.write(0x8000, static_cast<byte_t>(cpu_opcode::shy_absolute_x_unofficial));
+        bus.write_word(0x8001, 0x12F0);
+        bus.cpu_registers().x = 0x20;
+        bus.cpu_registers().y = 0x05;
+
+        const byte_t untouched_value = bus.read(0x1310);
+
+        REQUIRE(bus.cpu.step());
+
+        // The stored value is also the high byte of the address, no extra cycle
+        CHECK(bus.read(0x0110) == 0x01);
+        CHECK(bus.read(0x1310) == untouched_value);
+        CHECK(bus.cpu_state().cycle == cpu_cycle_t(5));
+    }
+
+    SECTION("tas")
+    {
+        bus.write(0x8000, static_cast<byte_t>(cpu_opcode::tas_absolute_y_unofficial));
+        bus.write_word(0x8001, 0x3400);
+        bus.cpu_registers().a = 0xF3;
+        bus.cpu_registers().x = 0x3F;
+        bus.cpu_registers().y = 0x02;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(bus.cpu_registers().sp == 0x33);
+        CHECK(bus.read(0x3402) == 0x31);
+    }
+
+    SECTION("las")
+    {
+        bus.write(0x8000, static_cast<byte_t>(cpu_opcode::las_absolute_y_unofficial));
+        bus.write_word(0x8001, 0x34F0);
+        bus.write(0x3510, 0x5A);
+        bus.cpu_registers().sp = 0xF0;
+        bus.cpu_registers().y = 0x20;
+
+        REQUIRE(bus.cpu.step());
+
+        CHECK(bus.cpu_registers().a == 0x50);
+        CHECK(bus.cpu_registers().x == 0x50);
+        CHECK(bus.cpu_registers().sp == 0x50);
+        CHECK(bus.cpu_state().cycle == cpu_cycle_t(5));
+    }
+}
+
+TEST_CASE("cpu opcode table", "[cpu][instruction]")
+{
+    for (size_t i = 0; i < 256; ++i)
+    {
+        CAPTURE(i);
+
+        cpu_bus_mock bus;
+
+        bus.write(0x8000, static_cast<byte_t>(i));
+        bus.cpu_registers().pc = 0x8000;
+        bus.cpu_registers().sp = 0xFD;
+
+        const string_view name = magic_enum::enum_name(static_cast<cpu_opcode>(i));
+
+        // Every opcode executes, only the JAM ones stop the cpu
+        CHECK(!name.empty());
+        CHECK(bus.cpu.step() != name.starts_with("jam"));
+        CHECK(bus.cpu_state().cycle >= cpu_cycle_t(cpu_opcode_cycles[i].base));
+    }
+}
+
+TEST_CASE("cpu jam", "[cpu][instruction]")
+{
+    cpu_bus_mock bus;
+
+    bus.write(0x8000, 0xEA);
+    bus.write(0x8001, static_cast<byte_t>(cpu_opcode::jam_implied_unofficial_02));
+    bus.write(0x8002, 0xEA);
+    bus.write_word(0xFFFA, 0x9000);
+
+    bus.cpu_registers().pc = 0x8000;
+
+    REQUIRE(bus.cpu.step());
+    CHECK_FALSE(bus.cpu.is_jammed());
+
+    CHECK_FALSE(bus.cpu.step());
+    CHECK(bus.cpu.is_jammed());
+    CHECK(bus.cpu_registers().pc == 0x8001);
+
+    SECTION("stays on the opcode")
+    {
+        CHECK_FALSE(bus.cpu.step());
+        CHECK_FALSE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("runs out the budget")
+    {
+        const cpu_cycle_t cycle = bus.cpu_state().cycle;
+
+        CHECK_FALSE(bus.cpu.run(cpu_cycle_t(1000)));
+        CHECK(bus.cpu_state().cycle == cycle + cpu_cycle_t(1000));
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("stops the run")
+    {
+        const cpu_cycle_t cycle = bus.cpu_state().cycle;
+
+        CHECK(bus.cpu.run_until(cycle + cpu_cycle_t(1000), cpu_no_stop{}) == stop_reason::jam);
+        CHECK(bus.cpu_state().cycle == cycle + cpu_cycle_t(1000));
+    }
+
+    SECTION("stops the run it happens in")
+    {
+        bus.cpu.reset();
+        bus.cpu_registers().pc = 0x8000;
+
+        CHECK(bus.cpu.run_until(bus.cpu_state().cycle + cpu_cycle_t(1000), cpu_no_stop{}) == stop_reason::jam);
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("ignores interrupts")
+    {
+        bus.cpu.nmi(cycle_t{bus.cpu_state().cycle});
+
+        CHECK_FALSE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("reset restarts")
+    {
+        bus.write_word(0xFFFC, 0x8002);
+        bus.cpu.reset();
+
+        CHECK_FALSE(bus.cpu.is_jammed());
+        CHECK(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8003);
+    }
+}
+
+TEST_CASE("cpu interrupts", "[cpu][interrupt]")
+{
+    cpu_bus_mock bus;
+
+    // Handlers of NOPs, the program is NOPs unless the section writes its own
+    bus.write_word(0xFFFA, 0x9000);
+    bus.write_word(0xFFFE, 0xA000);
+    std::fill_n(bus.memory.begin() + 0x8000, 0x10, byte_t{0xEA});
+    std::fill_n(bus.memory.begin() + 0x9000, 0x10, byte_t{0xEA});
+    std::fill_n(bus.memory.begin() + 0xA000, 0x10, byte_t{0xEA});
+
+    bus.cpu_registers().pc = 0x8000;
+    bus.cpu_registers().sp = 0xFD;
+    bus.cpu_state().cycle = cpu_cycle_t(100);
+
+    // Before the last cycle of the previous instruction, seen by its poll
+    constexpr cycle_t early_cycle{cpu_cycle_t(98)};
+
+    // During the last cycle of the previous instruction, only seen by the next poll
+    constexpr cycle_t late_cycle{cpu_cycle_t(100)};
+
+    const auto check_interrupt = [&bus](addr_t vector, addr_t return_addr, cpu_cycle_t cycle) {
+        CHECK(bus.cpu_registers().pc == vector);
+        CHECK(bus.cpu_registers().sp == 0xFA);
+        CHECK(bus.read_word(0x01FC) == return_addr);
+        CHECK((bus.read(0x01FB) & cpu_status::break_cmd) == cpu_status::none);
+        CHECK(bus.cpu_registers().is_status_set(cpu_status::interrupt));
+        CHECK(bus.cpu_state().cycle == cycle);
+    };
+
+    SECTION("nmi before the last cycle")
+    {
+        bus.cpu.nmi(early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0x9000, 0x8000, cpu_cycle_t(107));
+
+        // The edge is consumed
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x9001);
+    }
+
+    SECTION("nmi during the last cycle")
+    {
+        bus.cpu.nmi(late_cycle);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0x9000, 0x8001, cpu_cycle_t(109));
+    }
+
+    SECTION("nmi ignores the interrupt disable flag")
+    {
+        bus.cpu_registers().set_status(cpu_status::interrupt);
+        bus.cpu.nmi(early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0x9000, 0x8000, cpu_cycle_t(107));
+    }
+
+    SECTION("irq")
+    {
+        bus.cpu.irq(true, early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0xA000, 0x8000, cpu_cycle_t(107));
+
+        // The line is still asserted but masked by the handler
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0xA001);
+    }
+
+    SECTION("irq masked by the interrupt disable flag")
+    {
+        bus.cpu_registers().set_status(cpu_status::interrupt);
+        bus.cpu.irq(true, early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("irq released before the poll")
+    {
+        bus.cpu.irq(true, early_cycle);
+        bus.cpu.irq(false, early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+    }
+
+    SECTION("irq after the instruction following cli")
+    {
+        bus.cpu_registers().set_status(cpu_status::interrupt);
+        bus.write(0x8000, 0x58); // CLI
+        bus.cpu.irq(true, early_cycle);
+
+        REQUIRE(bus.cpu.step());
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8002);
+
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0xA000, 0x8002, cpu_cycle_t(111));
+    }
+
+    SECTION("irq right after sei")
+    {
+        bus.write(0x8000, 0x78); // SEI
+        bus.cpu.irq(true, late_cycle);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(bus.cpu_registers().pc == 0x8001);
+
+        // Polled before SEI set the flag, the pushed status has it set
+        REQUIRE(bus.cpu.step());
+        check_interrupt(0xA000, 0x8001, cpu_cycle_t(109));
+        CHECK((bus.read(0x01FB) & cpu_status::interrupt) != cpu_status::none);
+    }
+
+    SECTION("run")
+    {
+        bus.cpu.nmi(early_cycle);
+
+        REQUIRE(bus.cpu.run(cpu_cycle_t(9)));
+        CHECK(bus.cpu_registers().pc == 0x9001);
+        CHECK(bus.cpu_state().cycle == cpu_cycle_t(109));
+    }
+}
 
 } // namespace nese
@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+#include <nese/cpu_bus_mock.hpp>
+#include <nese/lockstep_bus.hpp>
+
+namespace nese {
+
+namespace {
+
+struct lockstep_table_dispatch_policy : cpu_policy
+{
+    static constexpr cpu_dispatch dispatch = cpu_dispatch::table;
+};
+
+// Sum $0300-$030F into $10, INC $11 each iteration
+// LDX #$0F, LDA #$00, CLC, ADC $0300,X, INC $11, DEX, BPL $0205, STA $10, JAM
+constexpr array<byte_t, 17> lockstep_program{0xA2, 0x0F, 0xA9, 0x00, 0x18, 0x7D, 0x00, 0x03, 0xE6, 0x11, 0xCA, 0x10, 0xF8, 0x85, 0x10, 0x02, 0x00};
+constexpr addr_t lockstep_program_end = 0x020F;
+
+void load_lockstep_program(cpu_bus_mock& bus)
+{
+    std::copy(lockstep_program.begin(), lockstep_program.end(), bus.memory.begin() + 0x0200);
+
+    for (addr_t i = 0; i < 0x10; ++i)
+    {
+        bus.memory[0x0300 + i] = static_cast<byte_t>(i * 3);
+    }
+
+    bus.memory[0x0011] = 0x00;
+}
+
+struct lockstep_fast_path_policy : cpu_policy
+{
+    static constexpr bool predecode = true;
+    static constexpr bool block_cache = true;
+    static constexpr bool idle_loop_skip = true;
+    static constexpr bool fusion = true;
+};
+
+// Same sum in the predecoded range with a fused DEX, BNE, then poll $11 until it's set
+// LDX #$10, LDA #$00, CLC, ADC $02FF,X, DEX, BNE $8005, STA $10, LDA $11, BEQ $800D, JAM
+constexpr array<byte_t, 18> lockstep_fast_path_program{0xA2, 0x10, 0xA9, 0x00, 0x18, 0x7D, 0xFF, 0x02, 0xCA, 0xD0, 0xFA, 0x85, 0x10, 0xA5, 0x11, 0xF0, 0xFC, 0x02};
+constexpr addr_t lockstep_fast_path_program_addr = 0x8000;
+constexpr addr_t lockstep_fast_path_idle_loop_addr = 0x800D;
+
+void load_lockstep_fast_path_program(cpu_bus_mock& bus)
+{
+    load_lockstep_program(bus);
+
+    std::copy(lockstep_fast_path_program.begin(), lockstep_fast_path_program.end(), bus.memory.begin() + lockstep_fast_path_program_addr);
+}
+
+cpu_state lockstep_start_state()
+{
+    cpu_state state;
+    state.registers.pc = 0x0200;
+    return state;
+}
+
+} // namespace
+
+TEST_CASE("lockstep bus", "[cpu][lockstep]")
+{
+    cpu_bus_mock bus;
+    cpu_bus_mock reference_bus;
+
+    load_lockstep_program(bus);
+    load_lockstep_program(reference_bus);
+
+    SECTION("same program on another dispatch")
+    {
+        lockstep_bus<cpu_bus_mock, lockstep_table_dispatch_policy> lockstep(bus, reference_bus);
+        lockstep.set_state(lockstep_start_state());
+
+        const bool agreed = lockstep.run_until([&] { return lockstep.get_state().registers.pc == lockstep_program_end; });
+
+        INFO(lockstep.get_report());
+        REQUIRE(agreed);
+        CHECK_FALSE(lockstep.has_diverged());
+        CHECK(lockstep.get_instruction_count() == 3 + 16 * 4 + 1);
+        CHECK(bus.memory == reference_bus.memory);
+        CHECK(bus.memory[0x0010] == 0x69);
+        CHECK(bus.memory[0x0011] == 0x10);
+    }
+
+    SECTION("same program on the cycle-accurate core")
+    {
+        lockstep_bus<cpu_bus_mock, cycle_accurate_cpu_policy> lockstep(bus, reference_bus);
+        lockstep.set_state(lockstep_start_state());
+
+        // The double write of INC counts as one
+        const bool agreed = lockstep.run_until([&] { return lockstep.get_state().registers.pc == lockstep_program_end; });
+
+        INFO(lockstep.get_report());
+        REQUIRE(agreed);
+    }
+
+    SECTION("jam stops the run")
+    {
+        lockstep_bus<cpu_bus_mock, lockstep_table_dispatch_policy> lockstep(bus, reference_bus);
+        lockstep.set_state(lockstep_start_state());
+
+        CHECK(lockstep.run_until([] { return false; }));
+        CHECK(lockstep.get_state().registers.pc == lockstep_program_end);
+        CHECK_FALSE(lockstep.has_diverged());
+    }
+
+    SECTION("register divergence")
+    {
+        reference_bus.memory[0x0308] = 0xFF;
+
+        lockstep_bus<cpu_bus_mock, lockstep_table_dispatch_policy> lockstep(bus, reference_bus);
+        lockstep.set_state(lockstep_start_state());
+
+        CHECK_FALSE(lockstep.run_until([&] { return lockstep.get_state().registers.pc == lockstep_program_end; }));
+        CHECK(lockstep.has_diverged());
+
+        // ADC $0300,X with X=8 on the 8th iteration
+        CHECK(lockstep.get_instruction_count() == 3 + 7 * 4 + 1);
+
+        const string& report = lockstep.get_report();
+        CHECK(report.starts_with("Diverged at instruction 32\n"));
+        CHECK(report.find("  a: $14, reference $FB\n") != string::npos);
+        CHECK(report.find("  0205  7D adc absolute_x") != string::npos);
+
+        // Stays stopped
+        CHECK_FALSE(lockstep.step());
+        CHECK(lockstep.get_instruction_count() == 32);
+    }
+
+    SECTION("write divergence")
+    {
+        reference_bus.memory[0x0011] = 0x20;
+
+        lockstep_bus<cpu_bus_mock, lockstep_table_dispatch_policy> lockstep(bus, reference_bus);
+        lockstep.set_state(lockstep_start_state());
+
+        CHECK_FALSE(lockstep.run_until([&] { return lockstep.get_state().registers.pc == lockstep_program_end; }));
+
+        // Same flags, only the value written by INC $11 differs
+        CHECK(lockstep.get_instruction_count() == 5);
+        CHECK(lockstep.get_report().find("  writes: [$0011=$01], reference [$0011=$21]\n") != string::npos);
+    }
+}
+
+TEST_CASE("lockstep bus fast paths", "[cpu][lockstep]")
+{
+    cpu_bus_mock bus;
+    cpu_bus_mock reference_bus;
+
+    load_lockstep_fast_path_program(bus);
+    load_lockstep_fast_path_program(reference_bus);
+
+    // The plain interpreter is the reference, the core must not fall back to it
+    lockstep_bus<cpu_bus_mock, lockstep_fast_path_policy, lockstep_table_dispatch_policy> lockstep(bus, reference_bus);
+
+    cpu_state start_state;
+    start_state.registers.pc = lockstep_fast_path_program_addr;
+    lockstep.set_state(start_state);
+
+    const cpu_predecode_cache& predecode_cache = lockstep.get_cpu().get_predecode_cache();
+
+    SECTION("step")
+    {
+        const bool agreed = lockstep.run_until([&] { return lockstep.get_state().registers.pc == lockstep_fast_path_idle_loop_addr; });
+
+        INFO(lockstep.get_report());
+        REQUIRE(agreed);
+        CHECK(bus.memory == reference_bus.memory);
+        CHECK(predecode_cache.get_hit_count() > 0);
+        CHECK(predecode_cache.get_block_hit_count() > 0);
+    }
+
+    SECTION("run")
+    {
+        // Chunks ending in the middle of the sum and of the idle loop
+        for (int i = 0; i < 8; ++i)
+        {
+            INFO(lockstep.get_report());
+            REQUIRE(lockstep.run(cpu_cycle_t(50)));
+        }
+
+        CHECK(bus.memory == reference_bus.memory);
+        CHECK(predecode_cache.get_block_hit_count() > 0);
+        CHECK(lockstep.get_cpu().get_idle_loop_cycles() > cpu_cycle_t(0));
+
+        bus.memory[0x0011] = 0x01;
+        reference_bus.memory[0x0011] = 0x01;
+
+        const bool agreed = lockstep.run_until([] { return false; });
+
+        INFO(lockstep.get_report());
+        REQUIRE(agreed);
+        CHECK(lockstep.get_cpu().is_jammed());
+        CHECK(bus.memory == reference_bus.memory);
+    }
+
+    SECTION("run divergence")
+    {
+        reference_bus.memory[0x0308] = 0xFF;
+
+        CHECK_FALSE(lockstep.run(cpu_cycle_t(400)));
+        CHECK(lockstep.get_report().starts_with("Diverged in the run from cycle 0\n"));
+
+        // Stays stopped
+        CHECK_FALSE(lockstep.run(cpu_cycle_t(1)));
+    }
+}
+
+} // namespace nese
@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <type_traits>
+
+#include <nese/basic_types.hpp>
+
+namespace nese {
+
+static_assert(std::is_convertible_v<cpu_cycle_t, ppu_cycle_t>);
+static_assert(std::is_convertible_v<ppu_cycle_t, cycle_t>);
+static_assert(!std::is_convertible_v<cycle_t, cpu_cycle_t>);
+static_assert(!std::is_convertible_v<ppu_cycle_t, cpu_cycle_t>);
+
+TEST_CASE("master clock", "[master_clock]")
+{
+    SECTION("finer clocks multiply")
+    {
+        CHECK(ppu_cycle_t{cpu_cycle_t(2)} == ppu_cycle_t(6));
+        CHECK(cycle_t{cpu_cycle_t(2)} == cycle_t(24));
+        CHECK(cycle_t{ppu_cycle_t(2)} == cycle_t(8));
+    }
+
+    SECTION("coarser clocks truncate")
+    {
+        CHECK(cycle_cast<cpu_cycle_t>(ppu_scanline_cycle) == cpu_cycle_t(113));
+        CHECK(cycle_cast<cpu_cycle_t>(cycle_t(23)) == cpu_cycle_t(1));
+        CHECK(cycle_cast<ppu_cycle_t>(cycle_t(24)) == ppu_cycle_t(6));
+    }
+
+    SECTION("mixed clocks compare on the finer one")
+    {
+        CHECK(cpu_cycle_t(1) == ppu_cycle_t(3));
+        CHECK(cpu_cycle_t(1) < ppu_cycle_t(4));
+        CHECK(cycle_t(13) > cpu_cycle_t(1));
+        CHECK(ppu_frame_cycle / cycle_t(4) == 341 * 262);
+    }
+
+    SECTION("pal ratio")
+    {
+        using pal_cpu_cycle_t = basic_cycle<16>;
+        using pal_ppu_cycle_t = basic_cycle<5>;
+
+        CHECK(cycle_cast<pal_ppu_cycle_t>(pal_cpu_cycle_t(5)) == pal_ppu_cycle_t(16));
+        CHECK(cycle_cast<pal_cpu_cycle_t>(pal_ppu_cycle_t(16)) == pal_cpu_cycle_t(5));
+    }
+}
+
+} // namespace nese
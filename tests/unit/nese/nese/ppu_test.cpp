@@ -0,0 +1,583 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include <nese/bus.hpp>
+#include <nese/cartridge/nrom_cartridge_mapper.hpp>
+
+namespace nese {
+
+namespace {
+
+// NMI vector to $9000, an empty CHR is 8K of CHR RAM
+cartridge create_ppu_cartridge(cartridge_mapper::mirroring mirroring, std::vector<byte_t>&& chr = {})
+{
+    std::vector<byte_t> prg(0x8000, 0xEA);
+    prg[0x7FFA] = 0x00;
+    prg[0x7FFB] = 0x90;
+
+    return cartridge{nrom_cartridge_mapper(std::move(prg), std::move(chr), mirroring)};
+}
+
+void set_vram_addr(bus& bus, addr_t addr)
+{
+    bus.write(0x2006, static_cast<byte_t>(addr >> 8));
+    bus.write(0x2006, static_cast<byte_t>(addr & 0xFF));
+}
+
+// Through the read buffer
+byte_t read_vram(bus& bus, addr_t addr)
+{
+    set_vram_addr(bus, addr);
+    (void)bus.read(0x2007);
+    return bus.read(0x2007);
+}
+
+void write_vram(bus& bus, addr_t addr, std::initializer_list<byte_t> bytes)
+{
+    set_vram_addr(bus, addr);
+
+    for (const byte_t value : bytes)
+    {
+        bus.write(0x2007, value);
+    }
+}
+
+// First cpu cycle the ppu is past the dot
+cpu_cycle_t to_cpu_cycle(ppu_cycle_t cycle)
+{
+    return cpu_cycle_t((cycle.count() + 2) / 3);
+}
+
+ppu_cycle_t to_ppu_cycle(size_t frame, size_t scanline, size_t dot)
+{
+    return ppu_frame_cycle * static_cast<s64_t>(frame) + ppu_scanline_cycle * static_cast<s64_t>(scanline) + ppu_cycle_t(static_cast<s64_t>(dot));
+}
+
+// Both renderers on one cartridge, the registers are written to both at the same dot
+struct ppu_compare_bus
+{
+    struct nmi_sink
+    {
+        void nmi(cycle_t) {}
+    };
+
+    ppu_compare_bus()
+        : cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::vertical))
+    {
+    }
+
+    template<typename FuncT>
+    void apply(FuncT&& func)
+    {
+        func(scanline_ppu);
+        func(dot_ppu);
+    }
+
+    void step(ppu_cycle_t cycle)
+    {
+        apply([cycle](auto& ppu) { ppu.step(cycle); });
+    }
+
+    nmi_sink cpu{};
+    nese::cartridge cartridge;
+
+    ppu<ppu_compare_bus> scanline_ppu{*this};
+    ppu<ppu_compare_bus, dot_accurate_ppu_policy> dot_ppu{*this};
+};
+
+// Both pattern tables, nametables, palettes and OAM filled with noise, the sprites overlap and some scanlines have more than 8
+template<typename PpuT>
+void load_compare_scene(PpuT& ppu, bool is_first)
+{
+    // The CHR RAM is shared
+    if (is_first)
+    {
+        ppu.write_ppu_addr(0x00);
+        ppu.write_ppu_addr(0x00);
+
+        for (size_t i = 0; i < 0x2000; ++i)
+        {
+            ppu.write_ppu_data(static_cast<byte_t>((i * 131) ^ (i >> 3) * 17));
+        }
+    }
+
+    ppu.write_ppu_addr(0x20);
+    ppu.write_ppu_addr(0x00);
+
+    for (size_t i = 0; i < 0x800; ++i)
+    {
+        ppu.write_ppu_data(static_cast<byte_t>(i * 7 + (i >> 5)));
+    }
+
+    ppu.write_ppu_addr(0x3F);
+    ppu.write_ppu_addr(0x00);
+
+    for (size_t i = 0; i < 0x20; ++i)
+    {
+        ppu.write_ppu_data(static_cast<byte_t>(i * 5 + 1));
+    }
+
+    for (size_t i = 0; i < 64; ++i)
+    {
+        ppu._oam[i * 4 + 0] = static_cast<byte_t>((i * 29) % 232);
+        ppu._oam[i * 4 + 1] = static_cast<byte_t>(i * 13);
+        ppu._oam[i * 4 + 2] = static_cast<byte_t>(i * 37) & 0xE3;
+        ppu._oam[i * 4 + 3] = static_cast<byte_t>(i * 41);
+    }
+
+    // Sprite 0 over the background
+    ppu._oam[0] = 0x20;
+    ppu._oam[3] = 0x40;
+}
+
+} // namespace
+
+TEST_CASE("ppu registers", "[ppu]")
+{
+    bus bus;
+    bus.load_cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::vertical));
+
+    SECTION("ppu data reads are buffered")
+    {
+        set_vram_addr(bus, 0x2400);
+        bus.write(0x2007, 0x11);
+        bus.write(0x2007, 0x22);
+
+        set_vram_addr(bus, 0x2400);
+        CHECK(bus.read(0x2007) == 0x00);
+        CHECK(bus.read(0x2007) == 0x11);
+        CHECK(bus.read(0x2007) == 0x22);
+    }
+
+    SECTION("increment by 32")
+    {
+        bus.write(0x2000, 0x04);
+
+        set_vram_addr(bus, 0x2000);
+        bus.write(0x2007, 0xAA);
+        bus.write(0x2007, 0xBB);
+
+        CHECK(bus.ppu._nametables[0x00] == 0xAA);
+        CHECK(bus.ppu._nametables[0x20] == 0xBB);
+        CHECK(bus.ppu._vram_addr == 0x2040);
+    }
+
+    SECTION("vertical mirroring")
+    {
+        set_vram_addr(bus, 0x2805);
+        bus.write(0x2007, 0x33);
+        set_vram_addr(bus, 0x2C06);
+        bus.write(0x2007, 0x44);
+
+        CHECK(read_vram(bus, 0x2005) == 0x33);
+        CHECK(read_vram(bus, 0x2406) == 0x44);
+        CHECK(read_vram(bus, 0x3005) == 0x33);
+        CHECK(read_vram(bus, 0x2406 - 0x400) == 0x00);
+    }
+
+    SECTION("palette reads are not buffered")
+    {
+        set_vram_addr(bus, 0x3F10);
+        bus.write(0x2007, 0x2A);
+
+        set_vram_addr(bus, 0x3F00);
+        CHECK(bus.read(0x2007) == 0x2A);
+        CHECK(bus.ppu._palette_table[0x00] == 0x2A);
+    }
+
+    SECTION("chr ram")
+    {
+        REQUIRE(bus.cartridge.get_chr().size() == 0x2000);
+
+        set_vram_addr(bus, 0x0010);
+        bus.write(0x2007, 0x5A);
+
+        CHECK(bus.cartridge.get_chr()[0x0010] == 0x5A);
+        CHECK(read_vram(bus, 0x0010) == 0x5A);
+    }
+
+    SECTION("chr rom is read only")
+    {
+        bus.load_cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::vertical, std::vector<byte_t>(0x2000, 0x77)));
+
+        set_vram_addr(bus, 0x0010);
+        bus.write(0x2007, 0x5A);
+
+        CHECK(read_vram(bus, 0x0010) == 0x77);
+    }
+
+    SECTION("write only registers read the open bus")
+    {
+        bus.write(0x2001, 0x5C);
+
+        CHECK(bus.read(0x2000) == 0x5C);
+        CHECK(bus.readonly(0x2005) == 0x5C);
+        CHECK(bus.read(0x2002) == 0x1C);
+    }
+
+    SECTION("scroll")
+    {
+        bus.write(0x2000, 0x01);
+        bus.write(0x2005, 0x7D);
+        bus.write(0x2005, 0x5E);
+
+        CHECK(bus.ppu._temp_vram_addr == 0x656F);
+        CHECK(bus.ppu._fine_x == 0x05);
+        CHECK(bus.ppu._vram_addr == 0x0000);
+    }
+
+    SECTION("status read resets the write toggle")
+    {
+        bus.write(0x2006, 0x21);
+        (void)bus.read(0x2002);
+
+        set_vram_addr(bus, 0x2300);
+
+        CHECK(bus.ppu._vram_addr == 0x2300);
+    }
+}
+
+TEST_CASE("ppu horizontal mirroring", "[ppu]")
+{
+    bus bus;
+    bus.load_cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::horizontal));
+
+    set_vram_addr(bus, 0x2405);
+    bus.write(0x2007, 0x33);
+    set_vram_addr(bus, 0x2806);
+    bus.write(0x2007, 0x44);
+
+    CHECK(read_vram(bus, 0x2005) == 0x33);
+    CHECK(read_vram(bus, 0x2C06) == 0x44);
+    CHECK(read_vram(bus, 0x2006) == 0x00);
+}
+
+TEST_CASE("ppu catch-up", "[ppu]")
+{
+    bus bus;
+    bus.load_cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::vertical));
+
+    std::fill(bus.ram.begin(), bus.ram.begin() + 0x10, byte_t{0xEA});
+
+    auto& state = bus.cpu.get_state();
+    state.registers.pc = 0x0000;
+
+    SECTION("vblank flag")
+    {
+        state.cycle = to_cpu_cycle(ppu_vblank_cycle) - cpu_cycle_t(1);
+
+        // Idle until a register is touched
+        CHECK(bus.ppu.get_cycle() == ppu_cycle_t(0));
+        CHECK((bus.read(0x2002) & 0x80) == 0);
+        CHECK(bus.ppu.get_cycle() == ppu_cycle_t(state.cycle));
+
+        state.cycle += cpu_cycle_t(1);
+
+        CHECK(bus.readonly(0x2002) == 0x00);
+        CHECK((bus.read(0x2002) & 0x80) != 0);
+        CHECK((bus.read(0x2002) & 0x80) == 0);
+    }
+
+    SECTION("vblank end clears the flag")
+    {
+        state.cycle = to_cpu_cycle(ppu_vblank_end_cycle);
+
+        bus.write(0x2001, 0x00);
+
+        CHECK(bus.ppu.get_scanline() == 261);
+        CHECK((bus.read(0x2002) & 0x80) == 0);
+    }
+
+    SECTION("nmi at vblank")
+    {
+        bus.write(0x2000, 0x80);
+
+        state.cycle = to_cpu_cycle(ppu_vblank_cycle) + cpu_cycle_t(6);
+        (void)bus.read(0x2002);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(state.registers.pc == 0x9000);
+    }
+
+    SECTION("no nmi when disabled")
+    {
+        state.cycle = to_cpu_cycle(ppu_vblank_cycle) + cpu_cycle_t(6);
+        (void)bus.read(0x2002);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(state.registers.pc == 0x0001);
+    }
+
+    SECTION("enabling the nmi during vblank")
+    {
+        state.cycle = to_cpu_cycle(ppu_vblank_cycle) + cpu_cycle_t(6);
+        bus.write(0x2000, 0x80);
+
+        // Raised at the cycle of the write, the poll sees it one instruction later
+        REQUIRE(bus.cpu.step());
+        CHECK(state.registers.pc == 0x0001);
+
+        REQUIRE(bus.cpu.step());
+        CHECK(state.registers.pc == 0x9000);
+    }
+}
+
+TEST_CASE("ppu scanline renderer", "[ppu]")
+{
+    bus bus;
+    bus.load_cartridge(create_ppu_cartridge(cartridge_mapper::mirroring::vertical));
+
+    // Tile 1 is a column at its left edge, pixel value 1
+    write_vram(bus, 0x0010, {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80});
+    write_vram(bus, 0x2000, {0x01});
+
+    // Black backdrop, white background color 1 and red sprite color 1
+    write_vram(bus, 0x3F00, {0x0F, 0x30});
+    write_vram(bus, 0x3F11, {0x16});
+
+    // Rendering starts from the top left
+    set_vram_addr(bus, 0x0000);
+
+    const ppu_frame_buffer& fb = bus.ppu._back_frame_buffer;
+
+    const auto pixel = [&fb](size_t x, size_t y) {
+        return fb[y * screen_width + x];
+    };
+
+    const u32_t black = pixel(0, 0);
+
+    SECTION("rendering disabled shows the backdrop")
+    {
+        bus.ppu.step(ppu_scanline_cycle);
+
+        CHECK(pixel(0, 0) == black);
+        CHECK(bus.ppu._vram_addr == 0x0000);
+    }
+
+    SECTION("background")
+    {
+        bus.write(0x2001, 0x0A);
+        bus.ppu.step(ppu_scanline_cycle * 2);
+
+        CHECK(pixel(0, 0) != black);
+        CHECK(pixel(1, 0) == black);
+        CHECK(pixel(8, 0) == black);
+        CHECK(pixel(0, 1) == pixel(0, 0));
+
+        // Down 2 rows, back to the left
+        CHECK(bus.ppu._vram_addr == 0x2000);
+    }
+
+    SECTION("fine x scroll")
+    {
+        write_vram(bus, 0x0010, {0xC0});
+        set_vram_addr(bus, 0x0000);
+
+        bus.write(0x2005, 0x01);
+        bus.write(0x2001, 0x0A);
+        bus.ppu.step(ppu_scanline_cycle);
+
+        CHECK(pixel(0, 0) != black);
+        CHECK(pixel(1, 0) == black);
+    }
+
+    SECTION("left column clipping")
+    {
+        bus.write(0x2001, 0x08);
+        bus.ppu.step(ppu_scanline_cycle);
+
+        CHECK(pixel(0, 0) == black);
+    }
+
+    SECTION("sprite 0 hit")
+    {
+        // Sprite 0 on scanline 1 over the column
+        bus.ppu._oam[0] = 0x00;
+        bus.ppu._oam[1] = 0x01;
+        bus.ppu._oam[2] = 0x00;
+        bus.ppu._oam[3] = 0x00;
+
+        bus.write(0x2001, 0x1E);
+
+        const std::optional<ppu_cycle_t> hit_cycle = bus.ppu.get_next_sprite_zero_hit_cycle();
+        REQUIRE(hit_cycle.has_value());
+        CHECK(*hit_cycle == ppu_scanline_cycle + ppu_cycle_t(256));
+
+        bus.ppu.step(*hit_cycle - ppu_cycle_t(1));
+        CHECK((bus.ppu.peek_status() & 0x40) == 0);
+
+        bus.ppu.step(*hit_cycle);
+        CHECK((bus.ppu.peek_status() & 0x40) != 0);
+        CHECK_FALSE(bus.ppu.get_next_sprite_zero_hit_cycle().has_value());
+
+        // Cleared on the pre-render scanline
+        bus.ppu.step(ppu_vblank_end_cycle);
+        CHECK((bus.ppu.peek_status() & 0x40) == 0);
+
+        // In front of the background on scanlines 1 to 8
+        CHECK(pixel(0, 1) != pixel(0, 0));
+        CHECK(pixel(0, 8) == pixel(0, 1));
+        CHECK(pixel(0, 9) == black);
+    }
+
+    SECTION("sprite behind the background")
+    {
+        bus.ppu._oam[0] = 0x00;
+        bus.ppu._oam[1] = 0x01;
+        bus.ppu._oam[2] = 0x20;
+        bus.ppu._oam[3] = 0x00;
+
+        bus.write(0x2001, 0x1E);
+        bus.ppu.step(ppu_scanline_cycle * 2);
+
+        CHECK(pixel(0, 1) == pixel(0, 0));
+    }
+
+    SECTION("chr ram writes are seen by the next scanline")
+    {
+        bus.write(0x2001, 0x0A);
+        bus.ppu.step(ppu_scanline_cycle);
+
+        REQUIRE(pixel(0, 0) != black);
+
+        // The column moves one pixel right
+        write_vram(bus, 0x0010, {0x40});
+        set_vram_addr(bus, 0x0000);
+        bus.ppu.step(ppu_scanline_cycle * 2);
+
+        CHECK(pixel(0, 1) == black);
+        CHECK(pixel(1, 1) == pixel(0, 0));
+    }
+
+    SECTION("frames are swapped after the pre-render scanline")
+    {
+        bus.write(0x2001, 0x0A);
+        bus.ppu.step(ppu_frame_cycle);
+
+        CHECK(bus.ppu.frame_buffer()[0] != black);
+        CHECK(bus.ppu.get_scanline() == 0);
+        CHECK(bus.ppu.get_scanline_cycle() == ppu_cycle_t(0));
+    }
+}
+
+TEST_CASE("ppu dot-accurate pipeline", "[ppu]")
+{
+    ppu_compare_bus bus;
+
+    bus.apply([is_first = true](auto& ppu) mutable {
+        load_compare_scene(ppu, is_first);
+        is_first = false;
+    });
+
+    const auto set_scroll = [](auto& ppu, byte_t x, byte_t y) {
+        ppu.write_scroll(x);
+        ppu.write_scroll(y);
+    };
+
+    SECTION("same frames as the scanline renderer")
+    {
+        const byte_t control = GENERATE(byte_t{0x10}, byte_t{0x28}, byte_t{0x39});
+
+        bus.apply([&](auto& ppu) {
+            ppu.write_control(control);
+            ppu.write_mask(0x1E);
+            set_scroll(ppu, 0x23, 0x47);
+        });
+
+        // The first frame starts without the pre-render scanline fetches
+        bus.step(to_ppu_cycle(1, 0, 0));
+
+        for (size_t frame = 1; frame < 4; ++frame)
+        {
+            // A $2006 split during hblank is seen by both
+            bus.step(to_ppu_cycle(frame, 120, 280));
+            bus.apply([](auto& ppu) {
+                ppu.write_ppu_addr(0x25);
+                ppu.write_ppu_addr(0x48);
+            });
+
+            bus.step(to_ppu_cycle(frame, 241, 2));
+            CHECK(bus.dot_ppu.peek_status() == bus.scanline_ppu.peek_status());
+            CHECK((bus.dot_ppu.peek_status() & 0x60) == 0x60);
+
+            bus.step(to_ppu_cycle(frame + 1, 0, 0));
+
+            INFO("frame " << frame);
+            CHECK(bus.dot_ppu.frame_buffer() == bus.scanline_ppu.frame_buffer());
+        }
+    }
+
+    SECTION("sprite 0 hit prediction")
+    {
+        bus.apply([&](auto& ppu) {
+            ppu.write_control(0x10);
+            ppu.write_mask(0x1E);
+            set_scroll(ppu, 0x00, 0x00);
+        });
+
+        bus.step(to_ppu_cycle(1, 0, 0));
+
+        // From the sprite X instead of the render dot
+        std::optional<ppu_cycle_t> hit_cycle = bus.dot_ppu.get_next_sprite_zero_hit_cycle();
+        REQUIRE(hit_cycle.has_value());
+        CHECK(*hit_cycle == to_ppu_cycle(1, 0x21, 0x41));
+
+        // Each prediction without the hit is followed by the next dot, the flag is never set before the predicted one
+        while ((bus.dot_ppu.peek_status() & 0x40) == 0)
+        {
+            hit_cycle = bus.dot_ppu.get_next_sprite_zero_hit_cycle();
+            REQUIRE(hit_cycle.has_value());
+
+            bus.dot_ppu.step(*hit_cycle - ppu_cycle_t(1));
+            REQUIRE((bus.dot_ppu.peek_status() & 0x40) == 0);
+
+            bus.dot_ppu.step(*hit_cycle);
+        }
+
+        CHECK(bus.dot_ppu.get_scanline_cycle() < ppu_cycle_t(0x49));
+        CHECK_FALSE(bus.dot_ppu.get_next_sprite_zero_hit_cycle().has_value());
+    }
+
+    SECTION("mid-scanline split")
+    {
+        bus.apply([&](auto& ppu) {
+            ppu.write_control(0x10);
+            ppu.write_mask(0x0A);
+            set_scroll(ppu, 0x00, 0x00);
+        });
+
+        bus.step(to_ppu_cycle(2, 100, 128));
+
+        // The scene is the same every frame
+        const std::vector<u32_t> unsplit(bus.dot_ppu.frame_buffer().begin(), bus.dot_ppu.frame_buffer().end());
+
+        // Back to the top left tile in the middle of scanline 100
+        bus.apply([](auto& ppu) {
+            ppu.write_ppu_addr(0x00);
+            ppu.write_ppu_addr(0x00);
+        });
+
+        bus.step(to_ppu_cycle(3, 0, 0));
+
+        const auto line = [](std::span<const u32_t> fb, size_t y, size_t x, size_t width) {
+            return fb.subspan(y * screen_width + x, width);
+        };
+
+        const std::span<const u32_t> scanline_fb = bus.scanline_ppu.frame_buffer();
+        const std::span<const u32_t> dot_fb = bus.dot_ppu.frame_buffer();
+
+        // The scanline renderer draws the whole scanline from the write, the pipeline the tiles fetched after it, 2 tiles later
+        CHECK(std::ranges::equal(line(dot_fb, 99, 0, screen_width), line(unsplit, 99, 0, screen_width)));
+        CHECK(std::ranges::equal(line(dot_fb, 100, 0, 128), line(unsplit, 100, 0, 128)));
+        CHECK(std::ranges::equal(line(dot_fb, 100, 144, 112), line(scanline_fb, 100, 0, 112)));
+        CHECK(std::ranges::equal(line(dot_fb, 101, 0, screen_width), line(scanline_fb, 101, 0, screen_width)));
+        CHECK_FALSE(std::ranges::equal(line(scanline_fb, 100, 0, screen_width), line(unsplit, 100, 0, screen_width)));
+    }
+}
+
+} // namespace nese
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <nese/ppu/ppu_tile_cache.hpp>
+
+namespace nese {
+
+namespace {
+
+array<byte_t, 8> get_row(const ppu_tile_cache& cache, size_t addr, bool flip)
+{
+    array<byte_t, 8> row{};
+    std::copy_n(cache.get_row(addr, flip), row.size(), row.begin());
+    return row;
+}
+
+} // namespace
+
+TEST_CASE("ppu tile cache", "[ppu]")
+{
+    std::vector<byte_t> chr(0x2000, 0x00);
+
+    // Row 2 of tile 1 in the second pattern table
+    chr[0x1012] = 0x81;
+    chr[0x101A] = 0xC0;
+
+    ppu_tile_cache cache;
+
+    REQUIRE(cache.is_dirty());
+    cache.update(chr);
+    REQUIRE_FALSE(cache.is_dirty());
+
+    SECTION("decode")
+    {
+        CHECK(get_row(cache, 0x1012, false) == array<byte_t, 8>{3, 2, 0, 0, 0, 0, 0, 1});
+        CHECK(get_row(cache, 0x1012, true) == array<byte_t, 8>{1, 0, 0, 0, 0, 0, 2, 3});
+        CHECK(get_row(cache, 0x1013, false) == array<byte_t, 8>{});
+        CHECK(get_row(cache, 0x0012, false) == array<byte_t, 8>{});
+    }
+
+    SECTION("stale until the tile is invalidated")
+    {
+        chr[0x1012] = 0x00;
+        chr[0x0000] = 0xFF;
+
+        cache.update(chr);
+        CHECK(get_row(cache, 0x1012, false) == array<byte_t, 8>{3, 2, 0, 0, 0, 0, 0, 1});
+
+        // Any byte of the tile, only that tile is decoded again
+        cache.invalidate(0x101A);
+        CHECK(cache.is_dirty());
+
+        cache.update(chr);
+        CHECK(get_row(cache, 0x1012, false) == array<byte_t, 8>{2, 2, 0, 0, 0, 0, 0, 0});
+        CHECK(get_row(cache, 0x0000, false) == array<byte_t, 8>{});
+
+        cache.invalidate();
+        cache.update(chr);
+        CHECK(get_row(cache, 0x0000, false) == array<byte_t, 8>{1, 1, 1, 1, 1, 1, 1, 1});
+    }
+
+    SECTION("chr smaller than the window is transparent")
+    {
+        cache.invalidate();
+        cache.update({});
+
+        CHECK(get_row(cache, 0x1012, false) == array<byte_t, 8>{});
+    }
+}
+
+} // namespace nese
@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <nese/scheduler.hpp>
+
+namespace nese {
+
+TEST_CASE("scheduler", "[scheduler]")
+{
+    scheduler scheduler;
+
+    SECTION("empty")
+    {
+        CHECK(scheduler.get_next_cycle() == scheduler::unscheduled);
+        CHECK_FALSE(scheduler.pop(scheduler::unscheduled).has_value());
+    }
+
+    SECTION("next event is the earliest")
+    {
+        scheduler.schedule(scheduler_event::vblank, cycle_t(100));
+        scheduler.schedule(scheduler_event::sprite_zero_hit, cycle_t(50));
+        scheduler.schedule(scheduler_event::vblank_end, cycle_t(200));
+
+        CHECK(scheduler.get_next_cycle() == cycle_t(50));
+
+        CHECK_FALSE(scheduler.pop(cycle_t(49)).has_value());
+        CHECK(scheduler.pop(cycle_t(150)) == scheduler_event::sprite_zero_hit);
+        CHECK(scheduler.pop(cycle_t(150)) == scheduler_event::vblank);
+        CHECK_FALSE(scheduler.pop(cycle_t(150)).has_value());
+
+        CHECK(scheduler.get_next_cycle() == cycle_t(200));
+    }
+
+    SECTION("reschedule")
+    {
+        scheduler.schedule(scheduler_event::vblank, cycle_t(100));
+        scheduler.schedule(scheduler_event::vblank, cycle_t(300));
+
+        CHECK(scheduler.get_cycle(scheduler_event::vblank) == cycle_t(300));
+        CHECK(scheduler.get_next_cycle() == cycle_t(300));
+    }
+
+    SECTION("cancel")
+    {
+        scheduler.schedule(scheduler_event::sprite_zero_hit, cycle_t(10));
+        scheduler.schedule(scheduler_event::vblank, cycle_t(20));
+        scheduler.cancel(scheduler_event::sprite_zero_hit);
+
+        CHECK_FALSE(scheduler.is_scheduled(scheduler_event::sprite_zero_hit));
+        CHECK(scheduler.get_next_cycle() == cycle_t(20));
+    }
+
+    SECTION("reset")
+    {
+        scheduler.schedule(scheduler_event::vblank, cycle_t(20));
+        scheduler.reset();
+
+        CHECK_FALSE(scheduler.is_scheduled(scheduler_event::vblank));
+        CHECK(scheduler.get_next_cycle() == scheduler::unscheduled);
+    }
+}
+
+} // namespace nese